@@ -18,8 +18,10 @@
  *	The driver uses NON LOCKING mode to allow multiple processes to
  *	wait for messages objects simultanously.
  * 
- *	Supports buffer queues for each of the 9 message objects
- *	plus one virtual "error object".
+ *	Supports buffer queues for each message object plus one virtual 
+ *	"error object" (object 0). The number of objects including the
+ *	error object is set by the NUM_OBJS descriptor key (default 10, 
+ *	max. MSCAN_MAX_OBJS).
  *
  *	See mscan_api documentation for further details.
  *
@@ -114,11 +116,18 @@ static const char RCSid[]="$Id: mscan_drv.c,v 1.19 2013/03/27 09:54:36 gvarlet E
 |  PROTOTYPES                              |
 +-----------------------------------------*/
 
-static int32 MscanWriteMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb );
+static int32 MscanWriteMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb, 
+							u_int32 lifetime );
+static int32 MscanWriteMsgExp( MSCAN_HANDLE *h, MSCAN_WRITEMSG_EXP_PB *pb );
 static int32 MscanClearBusOff( MSCAN_HANDLE *h );
 static int32 MscanEnable( MSCAN_HANDLE *h, int32 enable );
 static int32 MscanLoopback( MSCAN_HANDLE *h, int32 enable );
 static int32 MscanSetFilter( MSCAN_HANDLE *h, MSCAN_SETFILTER_PB *pb );
+static int32 MscanSetFilterRanges( MSCAN_HANDLE *h, 
+								   MSCAN_SETFILTERRANGES_PB *pb, int32 size );
+static int32 MscanSetRules( MSCAN_HANDLE *h, MSCAN_SETRULES_PB *pb, 
+							int32 size );
+static int32 MscanSetShared( MSCAN_HANDLE *h, MSCAN_SETSHARED_PB *pb );
 static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb );
 static int32 MscanSetBusTiming( MSCAN_HANDLE *h, 
 								const MSCAN_SETBUSTIMING_PB *pb );
@@ -126,23 +135,95 @@ static int32 MscanSetBitRate( MSCAN_HANDLE *h, MSCAN_SETBITRATE_PB *pb );
 static int32 MscanSetSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir);
 static int32 MscanClrSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir);
 static int32 MscanQueueClear( MSCAN_HANDLE *h, MSCAN_QUEUECLEAR_PB *pb );
+static int32 MscanTxAbort( MSCAN_HANDLE *h, MSCAN_TXABORT_PB *pb );
+static int32 MscanSetCyclic( MSCAN_HANDLE *h, MSCAN_SETCYCLIC_PB *pb, 
+							 int32 size );
+static void CyclicAlarm( void *arg );
+static void CyclicTakeOver( MSCAN_HANDLE *h );
 static int32 MscanReadMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb );
+static int32 MscanReadNMsg( MSCAN_HANDLE *h, MSCAN_READWRITENMSG_PB *pb, 
+							int32 size );
+static int32 MscanWriteNMsg( MSCAN_HANDLE *h, MSCAN_READWRITENMSG_PB *pb, 
+							 int32 size );
+static int32 MscanReadMsgTs( MSCAN_HANDLE *h, MSCAN_READMSG_TS_PB *pb );
+static int32 MscanTxConfEnable( MSCAN_HANDLE *h, MSCAN_TXCONFENABLE_PB *pb );
+static int32 MscanTxObjParam( MSCAN_HANDLE *h, MSCAN_TXOBJPARAM_PB *pb );
+static int32 MscanTxSchedPol( MSCAN_HANDLE *h, int32 policy );
+static int32 MscanReadTxConf( MSCAN_HANDLE *h, MSCAN_READTXCONF_PB *pb, 
+							  int32 size );
+static int32 MscanReadMbox( MSCAN_HANDLE *h, MSCAN_READMBOX_PB *pb, 
+							int32 size );
+static int32 MscanRxRingMap( MSCAN_HANDLE *h, MSCAN_RXRINGMAP_PB *pb );
+static int32 MscanRxRingWait( MSCAN_HANDLE *h, MSCAN_RXRINGWAIT_PB *pb );
+static int32 MscanTxRingMap( MSCAN_HANDLE *h, MSCAN_TXRINGMAP_PB *pb );
+static int32 MscanTxDoorbell( MSCAN_HANDLE *h, u_int32 nr );
+static int32 MscanWait( MSCAN_HANDLE *h, MSCAN_WAIT_PB *pb );
+static u_int32 WaitReady( MSCAN_HANDLE *h, u_int32 rxMask, u_int32 txMask,
+						  u_int32 txSpace, u_int32 *txReadyP );
+static int32 MscanReadNMsgTs( MSCAN_HANDLE *h, MSCAN_READNMSG_TS_PB *pb, 
+							  int32 size );
+static int32 ReadNFrames( MSCAN_HANDLE *h, u_int32 objNr, int32 timeout,
+						  u_int32 minFrames, u_int32 *nFramesP,
+						  MSCAN_FRAME *dst, MSCAN_FRAME_TS *dstTs );
 static int32 MscanReadError( MSCAN_HANDLE *h, MSCAN_READERROR_PB *pb );
 static int32 MscanQueueStatus( MSCAN_HANDLE *h, MSCAN_QUEUESTATUS_PB *pb );
 static int32 MscanErrorCounters( MSCAN_HANDLE *h, MSCAN_ERRORCOUNTERS_PB *pb );
 static int32 MscanDumpInternals( MSCAN_HANDLE *h, char *buffer, int maxLen);
 static void IrqRx( MSCAN_HANDLE *h );
+static void RxDeliver( MSCAN_HANDLE *h, int nr, const MSCAN_FRAME *frm,
+					   const MQUEUE_TS *ts );
+static u_int32 IrqRxDrain( MSCAN_HANDLE *h, u_int8 *rflgP );
+static int RxMboxPut( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+					  const MSCAN_FRAME *frm, const MQUEUE_TS *ts );
 static int ScheduleNextTx( MSCAN_HANDLE *h, int txb );
+static int TxSchedSelect( MSCAN_HANDLE *h );
+static void TxPreemptCheck( MSCAN_HANDLE *h );
+static int TxIdle( MSCAN_HANDLE *h );
+static int32 TxDrain( MSCAN_HANDLE *h );
 static void IrqOverrun( MSCAN_HANDLE *h );
 static void IrqStatus( MSCAN_HANDLE *h );
 static MSCAN_NODE_STATUS NodeStatus( MSCAN_HANDLE *h );
-static int SwFilter( const MSCAN_FRAME *frm, const MSCAN_FILTER *fspec );
+static int SwFilter( MSCAN_HANDLE *h, const MSCAN_FRAME *frm, 
+					 const MSCAN_OBJFILTER *f );
+static int32 ObjFilterSet( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+						   const MSCAN_FILTER *fspec );
+static int ObjMatch( MSCAN_HANDLE *h, const MSG_OBJ *obj, 
+					 const MSCAN_FRAME *frm );
+static void ObjRulesSet( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+						 MSCAN_OBJFILTER *rules, u_int32 num, u_int32 alloc );
+static u_int32 RuleCompile( const MSCAN_FILTER_RULE *rule, 
+							MSCAN_OBJFILTER *out );
+static void BuildRxDispatch( MSCAN_HANDLE *h );
+static u_int32 RxStdTargets( MSCAN_HANDLE *h, u_int16 *std, u_int8 *tgt,
+							 u_int32 tgtMax );
+static const u_int8 *RxDispatch( MSCAN_HANDLE *h, const MSCAN_RXDISP *disp,
+								 const MSCAN_FRAME *frm );
 static char* Ident( void );
 static int32 Cleanup(MSCAN_HANDLE *h, int32 retCode);
 static int32 QueueClear( MSCAN_HANDLE *h, u_int32 nr, u_int32 txabort );
 static int32 InitModeEnter( MSCAN_HANDLE *h );
 static int32 InitModeLeave( MSCAN_HANDLE *h );
 static void SetFilter( MSCAN_HANDLE *h, int fltNum, const MSCAN_FILTER *fspec);
+static void HwFiltSelect( const MSCAN_HWFILT_ITEM *in, u_int32 nIn,
+						  u_int32 stdWanted, u_int32 extWanted,
+						  u_int32 mode, MSCAN_HWFILT *best );
+static void HwFiltCompile( const MSCAN_HWFILT_ITEM *in, u_int32 nIn,
+						   u_int32 mode, MSCAN_HWFILT *hf );
+static void HwFiltMerge( const MSCAN_HWFILT_ITEM *a, 
+						 const MSCAN_HWFILT_ITEM *b, MSCAN_HWFILT_ITEM *m );
+static void HwFiltCover( MSCAN_HWFILT_ITEM *it, u_int32 bits );
+static void HwFiltSplit( const MSCAN_HWFILT_ITEM *it, u_int32 bits,
+						 MSCAN_HWFILT_ITEM *lo, MSCAN_HWFILT_ITEM *hi );
+static u_int32 HwFiltCost( const MSCAN_HWFILT_GEO *geo,
+						   const MSCAN_HWFILT_ITEM *it );
+static u_int32 HwFiltUnion( const MSCAN_HWFILT_ITEM *flt, u_int32 num,
+							int ext, u_int32 bits );
+static u_int32 HwFiltWanted( const MSCAN_IDRANGE *rng, u_int32 nRanges,
+							 int ext );
+static int32 HwFiltApply( MSCAN_HANDLE *h, const MSCAN_HWFILT *hf );
+static int32 HwFiltAuto( MSCAN_HANDLE *h, int force );
+static void HwFiltWrite( MSCAN_HANDLE *h, const MSCAN_HWFILT *hf );
+static u_int32 BitCount( u_int32 v );
 static int32 CalcBustime( MSCAN_HANDLE *h,
 						  u_int32 bitrate,
 						  u_int32 *calcBrpP,
@@ -150,8 +231,63 @@ static int32 CalcBustime( MSCAN_HANDLE *h,
 static void DumpFilter( MSCAN_HANDLE *h, char *msg, const MSCAN_FILTER *f );
 static void DumpFrame( MSCAN_HANDLE *h, char *msg, const MSCAN_FRAME *frm );
 static void PutError( MSCAN_HANDLE *h, int nr, MSCAN_ERRENTRY_CODE code );
-static int WaitRxFifoEntry( MSCAN_HANDLE *h,int nr,int32 timeout);
+static int WaitRxFifoEntry( MSCAN_HANDLE *h, u_int32 nr, u_int32 minEntries,
+							int32 timeout );
 static void RecomputeObjLimits( MSCAN_HANDLE *h );
+static void QueueCopyOut( MSCAN_HANDLE *h, const MQUEUE_HEAD *q, 
+						  MSCAN_FRAME *dst, u_int32 n );
+static void QueueCopyIn( MSCAN_HANDLE *h, MQUEUE_HEAD *q, 
+						 const MSCAN_FRAME *src, u_int32 n );
+static u_int32 QueueGetFrames( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+							   MSCAN_FRAME *dst, MSCAN_FRAME_TS *dstTs,
+							   u_int32 max );
+static void IrqStatUpdate( MSCAN_HANDLE *h, u_int32 t );
+static void TsExtend( MSCAN_HANDLE *h, u_int32 raw, MQUEUE_TS *ts );
+#if defined(MSCAN_IS_ODIN) || defined(MSCAN_TS_CYCLES)
+static void TsMulDiv( u_int32 a, u_int32 b, u_int32 c, 
+					  u_int32 *hiP, u_int32 *loP );
+#endif
+#ifdef MSCAN_TS_CYCLES
+static void TsCalibrate( MSCAN_HANDLE *h );
+static void TsCycles( MSCAN_HANDLE *h, MQUEUE_TS *ts );
+#endif
+static void RxTimestamp( MSCAN_HANDLE *h, MQUEUE_TS *ts );
+static void TxTimestamp( MSCAN_HANDLE *h, int txb, MQUEUE_TS *ts );
+static void TxConfirm( MSCAN_HANDLE *h, MSG_OBJ *obj, int txb );
+static void TxAbortWake( MSCAN_HANDLE *h, MSG_OBJ *obj );
+static int32 TxConfSetup( MSCAN_HANDLE *h, MSG_OBJ *obj, u_int32 entries );
+static u_int32 MscanTsFreq( MSCAN_HANDLE *h );
+static u_int32 QueuePutFrames( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+							   const MSCAN_FRAME *src, u_int32 max,
+							   u_int32 lifetime );
+static u_int32 TxDropExpired( MSCAN_HANDLE *h, MSG_OBJ *obj );
+static u_int32 MboxPutFrames( MSCAN_HANDLE *h, MSG_OBJ *obj, 
+							  const MSCAN_FRAME *src, u_int32 max,
+							  u_int32 lifetime );
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+
+/** acceptance code registers (2x32 mode: filter 0 uses IDAR0..3) */
+static const int idarReg[] = {
+	MSCAN_IDAR0, MSCAN_IDAR1, MSCAN_IDAR2, MSCAN_IDAR3, 
+	MSCAN_IDAR4, MSCAN_IDAR5, MSCAN_IDAR6, MSCAN_IDAR7 
+};
+
+/** acceptance mask registers, same order as idarReg */
+static const int idmrReg[] = {
+	MSCAN_IDMR0, MSCAN_IDMR1, MSCAN_IDMR2, MSCAN_IDMR3, 
+	MSCAN_IDMR4, MSCAN_IDMR5, MSCAN_IDMR6, MSCAN_IDMR7 
+};
+
+/** hw filter modes, indexed by MSCAN_HWFILT_xxx */
+static const MSCAN_HWFILT_GEO hwFiltGeo[] = {
+	/* idac			   num mixed  bits(std,ext) shift(std,ext) */
+	{ MSCAN_IDAC_2X32,	2,	0,		{ 11, 29 }, {  0,  0 } },
+	{ MSCAN_IDAC_4X16,	4,	0,		{ 11, 14 }, {  0, 15 } },
+	{ MSCAN_IDAC_8X8,	8,	1,		{  8,  8 }, {  3, 21 } }
+};
 
 /**********************************************************************/
 /** LL-Interface Init: Initialize MSCAN LL driver
@@ -167,6 +303,15 @@ static void RecomputeObjLimits( MSCAN_HANDLE *h );
  *
  * - \c CANCLOCK: must be specified! Specifies the MSCAN input clock in HZ. 
  *
+ * - \c MIN_BRP [2]: minimum baud rate prescaler
+ *
+ * - \c RX_DRAIN_MAX [16]: maximum number of frames read from the
+ *   controller's Rx FIFO within one interrupt
+ *
+ * - \c NUM_OBJS [10]: number of message objects including the error
+ *   object (2..256). Objects 15 and above share the lowest hardware
+ *   transmit priority.
+ *
  */
 static int32 MSCAN_Init( 
 	DESC_SPEC       *descP,
@@ -289,10 +434,30 @@ static int32 MSCAN_Init(
 	/* MIN_BRP (optional) */
     DESC_GetUInt32(h->descHdl, MSCAN_MIN_BRP, &h->minBrp, "MIN_BRP");
 
+	/* RX_DRAIN_MAX (optional) */
+    DESC_GetUInt32(h->descHdl, MSCAN_RX_DRAIN_DEF, &h->rxDrainMax, 
+				   "RX_DRAIN_MAX");
+	if( h->rxDrainMax == 0 )
+		h->rxDrainMax = 1;
+
+	/* NUM_OBJS (optional) */
+    DESC_GetUInt32(h->descHdl, MSCAN_NUM_OBJS, &value, "NUM_OBJS");
+	if( value < 2 || value > MSCAN_MAX_OBJS ){
+		DBGWRT_ERR((DBH," *** MSCAN_Init: illegal NUM_OBJS %d\n", value));
+		return( Cleanup( h, ERR_LL_ILL_PARAM ) );
+	}
+
 	/*-----------------------+
 	|  init message objects  |
 	+-----------------------*/
-	for( i=0; i<MSCAN_NUM_OBJS; i++ ) {
+	if( (h->msgObj = (MSG_OBJ *)OSS_MemGet( osHdl, value * sizeof(MSG_OBJ),
+											&h->msgObjAlloc )) == NULL )
+		return( Cleanup( h, ERR_OSS_MEM_ALLOC ) );
+
+    OSS_MemFill(osHdl, h->msgObjAlloc, (char*)h->msgObj, 0x00);
+	h->numObjs = value;
+
+	for( i=0; i<(int32)h->numObjs; i++ ) {
 
 		h->msgObj[i].nr 	= i;
 		h->msgObj[i].q.dir 	= MSCAN_DIR_DIS;
@@ -315,6 +480,11 @@ static int32 MSCAN_Init(
 	/* put MSCAN in INIT mode (all bus activity is disabled) */
 	if( (error = InitModeEnter( h ) ))
 		return( Cleanup( h, error ) );
+
+#ifdef MSCAN_TS_CYCLES
+	/* frequency of timestamp counter */
+	TsCalibrate( h );
+#endif
 		
     DBGWRT_1((DBH, "LL - MSCAN_Init finished ok\n"));
 	*llHdlP = (LL_HANDLE *)h;
@@ -396,7 +566,18 @@ static int32 MSCAN_SetStat(
 
 	case MSCAN_WRITEMSG:
 		CHK_BLK_SIZE( blk, MSCAN_READWRITEMSG_PB );
-		error = MscanWriteMsg( h, (MSCAN_READWRITEMSG_PB*)blk->data );
+		error = MscanWriteMsg( h, (MSCAN_READWRITEMSG_PB*)blk->data, 0 );
+		break;
+
+	case MSCAN_WRITEMSG_EXP:
+		CHK_BLK_SIZE( blk, MSCAN_WRITEMSG_EXP_PB );
+		error = MscanWriteMsgExp( h, (MSCAN_WRITEMSG_EXP_PB*)blk->data );
+		break;
+
+	case MSCAN_SETCYCLIC:
+		CHK_BLK_MINSIZE( blk, MSCAN_SETCYCLIC_PB );
+		error = MscanSetCyclic( h, (MSCAN_SETCYCLIC_PB*)blk->data, 
+								blk->size );
 		break;
 
 	case MSCAN_CLEARBUSOFF:
@@ -416,6 +597,23 @@ static int32 MSCAN_SetStat(
 		error = MscanSetFilter( h, (MSCAN_SETFILTER_PB*)blk->data );
 		break;
 
+	case MSCAN_SETFILTERRANGES:
+		CHK_BLK_MINSIZE( blk, MSCAN_SETFILTERRANGES_PB );
+		error = MscanSetFilterRanges( h, 
+									  (MSCAN_SETFILTERRANGES_PB*)blk->data,
+									  blk->size );
+		break;
+
+	case MSCAN_SETRULES:
+		CHK_BLK_MINSIZE( blk, MSCAN_SETRULES_PB );
+		error = MscanSetRules( h, (MSCAN_SETRULES_PB*)blk->data, blk->size );
+		break;
+
+	case MSCAN_SETSHARED:
+		CHK_BLK_SIZE( blk, MSCAN_SETSHARED_PB );
+		error = MscanSetShared( h, (MSCAN_SETSHARED_PB*)blk->data );
+		break;
+
 	case MSCAN_CONFIGMSG:
 		CHK_BLK_SIZE( blk, MSCAN_CONFIGMSG_PB );
 		error = MscanConfigMsg( h, (MSCAN_CONFIGMSG_PB*)blk->data );
@@ -456,6 +654,11 @@ static int32 MSCAN_SetStat(
 		error = MscanQueueClear( h, (MSCAN_QUEUECLEAR_PB*)blk->data );
 		break;
 
+	case MSCAN_TXCONFENABLE:
+		CHK_BLK_SIZE( blk, MSCAN_TXCONFENABLE_PB );
+		error = MscanTxConfEnable( h, (MSCAN_TXCONFENABLE_PB*)blk->data );
+		break;
+
 
 	/*--- standard MDIS setstats ---*/
 	case M_MK_IRQ_ENABLE:
@@ -476,6 +679,51 @@ static int32 MSCAN_SetStat(
 	case M_MK_IRQ_COUNT:	h->irqCount = value; break;
 	case MSCAN_MAXIRQTIME:	h->maxIrqTime = value; break;
 
+	case MSCAN_CLEARIRQSTAT:
+	{
+		OSS_IRQ_STATE oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+		OSS_MemFill( h->osHdl, sizeof(h->irqStat), (char *)&h->irqStat, 0 );
+		h->maxIrqTime = 0;
+		OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+		break;
+	}
+	case MSCAN_RXIRQFRAMES:	h->rxIrqFramesMax = value; break;
+
+	case MSCAN_TXSCHEDPOL:
+		error = MscanTxSchedPol( h, value );
+		break;
+
+	case MSCAN_TXDOORBELL:
+		error = MscanTxDoorbell( h, (u_int32)value );
+		break;
+
+	case MSCAN_FILTERAUTO:
+		if( value == -1 )
+			h->hwFiltAuto = FALSE;		/* keep current filter */
+		else if( (value < MSCAN_HWFILT_2X32) || 
+				 (value > MSCAN_HWFILT_AUTO) ||
+				 (value == MSCAN_HWFILT_CLOSED) )
+			error = MSCAN_ERR_BADPARAMETER;
+		else {
+			h->hwFiltAuto	  = TRUE;
+			h->hwFiltAutoMode = value;
+			error = HwFiltAuto( h, TRUE );
+		}
+		break;
+
+	case MSCAN_TXOBJPARAM:
+		CHK_BLK_SIZE( blk, MSCAN_TXOBJPARAM_PB );
+		error = MscanTxObjParam( h, (MSCAN_TXOBJPARAM_PB*)blk->data );
+		break;
+
+	case MSCAN_RXDRAINMAX:
+		if( value < 1 )
+			error = ERR_LL_ILL_PARAM;
+		else
+			h->rxDrainMax = value;
+		break;
+
 	default:		
 		error = ERR_LL_UNK_CODE;
 		break;
@@ -510,6 +758,100 @@ static int32 MSCAN_GetStat(
 		error = MscanReadMsg( h, (MSCAN_READWRITEMSG_PB*)blk->data );
 		break;
 
+	case MSCAN_READNMSG:
+		CHK_BLK_MINSIZE( blk, MSCAN_READWRITENMSG_PB );
+		error = MscanReadNMsg( h, (MSCAN_READWRITENMSG_PB*)blk->data, 
+							   blk->size );
+		break;
+
+	case MSCAN_WRITENMSG:
+		/* getstat, so the number of queued frames is returned */
+		CHK_BLK_MINSIZE( blk, MSCAN_READWRITENMSG_PB );
+		error = MscanWriteNMsg( h, (MSCAN_READWRITENMSG_PB*)blk->data,
+								blk->size );
+		break;
+
+	case MSCAN_READMBOX:
+		CHK_BLK_MINSIZE( blk, MSCAN_READMBOX_PB );
+		error = MscanReadMbox( h, (MSCAN_READMBOX_PB*)blk->data, 
+							   blk->size );
+		break;
+
+	case MSCAN_RXRINGMAP:
+		CHK_BLK_SIZE( blk, MSCAN_RXRINGMAP_PB );
+		error = MscanRxRingMap( h, (MSCAN_RXRINGMAP_PB*)blk->data );
+		break;
+
+	case MSCAN_RXRINGWAIT:
+		CHK_BLK_SIZE( blk, MSCAN_RXRINGWAIT_PB );
+		error = MscanRxRingWait( h, (MSCAN_RXRINGWAIT_PB*)blk->data );
+		break;
+
+	case MSCAN_TXRINGMAP:
+		CHK_BLK_SIZE( blk, MSCAN_TXRINGMAP_PB );
+		error = MscanTxRingMap( h, (MSCAN_TXRINGMAP_PB*)blk->data );
+		break;
+
+	case MSCAN_WAIT:
+		CHK_BLK_SIZE( blk, MSCAN_WAIT_PB );
+		error = MscanWait( h, (MSCAN_WAIT_PB*)blk->data );
+		break;
+
+	case MSCAN_READMSG_TS:
+		CHK_BLK_SIZE( blk, MSCAN_READMSG_TS_PB );
+		error = MscanReadMsgTs( h, (MSCAN_READMSG_TS_PB*)blk->data );
+		break;
+
+	case MSCAN_READNMSG_TS:
+		CHK_BLK_MINSIZE( blk, MSCAN_READNMSG_TS_PB );
+		error = MscanReadNMsgTs( h, (MSCAN_READNMSG_TS_PB*)blk->data, 
+								 blk->size );
+		break;
+
+	case MSCAN_TXEXPIRED:
+	{
+		MSCAN_TXEXPIRED_PB *pb = (MSCAN_TXEXPIRED_PB *)blk->data;
+
+		CHK_BLK_SIZE( blk, MSCAN_TXEXPIRED_PB );
+		if( pb->objNr >= h->numObjs || pb->objNr==0 ){
+			error = MSCAN_ERR_BADMSGNUM;
+			break;
+		}
+		pb->expired = h->msgObj[pb->objNr].txExpired;
+		break;
+	}
+
+	case MSCAN_TXABORT:
+		CHK_BLK_SIZE( blk, MSCAN_TXABORT_PB );
+		error = MscanTxAbort( h, (MSCAN_TXABORT_PB*)blk->data );
+		break;
+
+	case MSCAN_READTXCONF:
+		CHK_BLK_MINSIZE( blk, MSCAN_READTXCONF_PB );
+		error = MscanReadTxConf( h, (MSCAN_READTXCONF_PB*)blk->data, 
+								 blk->size );
+		break;
+
+	case MSCAN_FILTERINFO:
+		CHK_BLK_SIZE( blk, MSCAN_HWFILT_INFO );
+		*(MSCAN_HWFILT_INFO *)blk->data = h->hwFilt.info;
+		break;
+
+	case MSCAN_IRQSTAT:
+	{
+		OSS_IRQ_STATE oldState;
+
+		CHK_BLK_SIZE( blk, MSCAN_IRQSTAT_PB );
+
+		/* copy consistent snapshot */
+		oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+		*(MSCAN_IRQSTAT_PB *)blk->data = h->irqStat;
+		OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+		((MSCAN_IRQSTAT_PB *)blk->data)->tickFreq = MSCAN_CYCLES_FREQ( h );
+		break;
+	}
+
 	case MSCAN_READERROR:
 		CHK_BLK_SIZE( blk, MSCAN_READERROR_PB );
 		error = MscanReadError( h, (MSCAN_READERROR_PB*)blk->data );
@@ -532,10 +874,17 @@ static int32 MSCAN_GetStat(
 	case MSCAN_GETCANCLK:	*valueP = h->canClock; break;
 	case MSCAN_NODESTATUS:	*valueP = (int32)NodeStatus( h ); break;
 	case MSCAN_MAXIRQTIME:	*valueP = h->maxIrqTime; break;
+	case MSCAN_RXDRAINMAX:	*valueP = h->rxDrainMax; break;
+	case MSCAN_RXIRQFRAMES:	*valueP = h->rxIrqFramesMax; break;
+	case MSCAN_TSFREQ:		*valueP = MscanTsFreq( h ); break;
+	case MSCAN_TXSCHEDPOL:	*valueP = h->txSched; break;
+	case MSCAN_FILTERAUTO:	
+		*valueP = h->hwFiltAuto ? (int32)h->hwFiltAutoMode : -1; 
+		break;
 		
 	/*--- standard MDIS getstats ---*/
 	case M_LL_DEBUG_LEVEL:	*valueP = h->dbgLevel; break;
-	case M_LL_CH_NUMBER:	*valueP = MSCAN_NUM_OBJS; break;
+	case M_LL_CH_NUMBER:	*valueP = h->numObjs; break;
 	case M_LL_CH_TYP:		*valueP = M_CH_BINARY; break;
 	case M_LL_IRQ_COUNT:	*valueP = h->irqCount; break;
 	case M_MK_BLK_REV_ID:	*value64P = (INT32_OR_64)&h->idFuncTbl; break;
@@ -561,53 +910,24 @@ static int32 MSCAN_BlockRead(
 {
 	MSCAN_HANDLE *h = (MSCAN_HANDLE *)llHdl;
 	MSG_OBJ *obj = &h->msgObj[ch];
-	int32 availEntries, n;
-	MQUEUE_ENT *ent;
-	MSCAN_FRAME *frm;
-	OSS_IRQ_STATE oldState;
+	u_int32 n;
 
     DBGWRT_1((DBH, "LL - MSCAN_BlockRead: objNr=%d, size=%d\n",ch,size));
 	*nbrRdBytesP = 0;
 
 	/* parameter checks */
-	if( ch >= MSCAN_NUM_OBJS || ch==0)
+	if( ch >= (int32)h->numObjs || ch==0)
 		return MSCAN_ERR_BADMSGNUM;
 
-	if( obj->q.dir != MSCAN_DIR_RCV )
+	if( obj->q.dir != MSCAN_DIR_RCV || obj->rxSlot || obj->rxRing )
 		return MSCAN_ERR_BADDIR;
 
-	/* compute number of frames user wants to read */
-	size /= sizeof(MSCAN_FRAME);
-
-	/* check for FIFO space */
-	availEntries = obj->q.filled;
-	if( availEntries > size )
-		availEntries = size;
-
-	DBGWRT_2((DBH, " dequeue %d frames\n", availEntries ));
-
-	/*----------------------+
-	|  Put frame into FIFO  |
-	+----------------------*/
-	n = availEntries;
-	ent = obj->q.nxtOut;
-	frm = (MSCAN_FRAME *)buf;
-
-	while( n-- ){
-		*frm++ = ent->d.frm;
-		ent = ent->next;
-	}
-	obj->q.nxtOut = ent;
-	
-	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
-
-	obj->q.filled -= availEntries;
-	obj->q.errSent = FALSE;
-
-	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+	/* get as many frames as fit into user buffer */
+	n = QueueGetFrames( h, obj, (MSCAN_FRAME *)buf, NULL,
+						size / sizeof(MSCAN_FRAME) );
 
 	/* return nr of read bytes */
-	*nbrRdBytesP = availEntries * sizeof(MSCAN_FRAME);
+	*nbrRdBytesP = n * sizeof(MSCAN_FRAME);
 
 	return( 0 );
 }
@@ -625,58 +945,30 @@ static int32 MSCAN_BlockWrite(
 {
 	MSCAN_HANDLE *h = (MSCAN_HANDLE *)llHdl;
 	MSG_OBJ *obj = &h->msgObj[ch];
-	int32 availEntries, n;
-	MQUEUE_ENT *ent;
-	MSCAN_FRAME *frm;
-	OSS_IRQ_STATE oldState;
+	u_int32 n;
 
     DBGWRT_1((DBH, "LL - MSCAN_BlockWrite: objNr=%d, size=%d\n",ch,size));
 	*nbrWrBytesP = 0;
 
 	/* parameter checks */
-	if( ch >= MSCAN_NUM_OBJS || ch==0)
+	if( ch >= (int32)h->numObjs || ch==0)
 		return MSCAN_ERR_BADMSGNUM;
 
-	if( obj->q.dir != MSCAN_DIR_XMT )
-		return MSCAN_ERR_BADDIR;
+	if( obj->q.dir != MSCAN_DIR_XMT || obj->txRing )
+		return MSCAN_ERR_BADDIR;	/* shared ring is written by appl. */
+
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;	/* FIFO is written by alarm */
 
 	if( !h->canEnabled )
 		return MSCAN_ERR_NOTINIT;
 
-	/* compute number of frames user wants to write */
-	size /= sizeof(MSCAN_FRAME);
-
-	/* check for FIFO space */
-	availEntries = obj->q.totEntries - obj->q.filled;
-	if( availEntries > size )
-		availEntries = size;
-
-	DBGWRT_2((DBH, " enqueue %d frames\n", availEntries ));
-
-	/*----------------------+
-	|  Put frame into FIFO  |
-	+----------------------*/
-	n = availEntries;
-	ent = obj->q.nxtIn;
-	frm = (MSCAN_FRAME *)buf;
-
-	while( n-- ){
-		ent->d.frm = *frm++;
-		ent = ent->next;
-	}
-	obj->q.nxtIn = ent;
-	
-	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
-
-	obj->q.filled += availEntries;
-
-	/* enable all tx interrupts */
-	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
-	
-	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+	/* put as many frames as fit into FIFO */
+	n = QueuePutFrames( h, obj, (const MSCAN_FRAME *)buf, 
+						size / sizeof(MSCAN_FRAME), 0 );
 
 	/* return nr of written bytes */
-	*nbrWrBytesP = availEntries * sizeof(MSCAN_FRAME);
+	*nbrWrBytesP = n * sizeof(MSCAN_FRAME);
 
 	return( 0 );
 }
@@ -685,7 +977,7 @@ static int32 MSCAN_BlockWrite(
 /** LL-Interface Irq: MSCAN interrupt handler
  *	
  * Checks for occurred interrupts:
- * - receive interrupts
+ * - receive interrupts (reads up to RX_DRAIN_MAX frames from Rx FIFO)
  * - transmit interrupts
  * - receive overrun interrupts
  * - status change interrupts
@@ -707,12 +999,15 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 {
 	MSCAN_HANDLE *h = (MSCAN_HANDLE *)llHdl;
 	MACCESS ma = h->ma;
-	u_int8 rflg, tflg;
+	u_int8 rflg, tflg, taak;
 	int haveInt=0;
 	MSG_OBJ *obj;
 	int txb, objNr, nothingToSched=FALSE;
 	u_int8 txbMask;
 	OSS_IRQ_STATE oldState;
+	u_int32 tStart, tEnd;
+
+	MSCAN_CYCLES( h, tStart );
 
 	tflg = MSREAD( ma, MSCAN_TFLG );
 
@@ -722,15 +1017,17 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 	/* Mask the IRQ to be SMP safe */
 	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
 
+	h->rxIrqFrames = 0;
+	taak = (h->txPreempt | h->txAbort) ? MSREAD( ma, MSCAN_TAAK ) : 0;
+
 	/*-----------------------------------------+
 	|  Handle Rx and scheduling of Tx buffers  |
 	+-----------------------------------------*/
 
 	/*--- check for received buffers ---*/
-	if( (rflg = MSREAD( ma, MSCAN_RFLG )) & MSCAN_RFLG_RXF ){
-		IrqRx( h );
+	rflg = MSREAD( ma, MSCAN_RFLG );
+	if( IrqRxDrain( h, &rflg ) )
 		haveInt++;
-	}
 
 	/*--- check for completed transmissions ---*/
 	for( txb=0, txbMask=0x1; tflg && txb<MSCAN_NTXBUFS; txb++, txbMask<<=1 ){
@@ -746,7 +1043,7 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 				IDBGWRT_2((DBH,"   txed buf %d prio=0x%02x obj %d\n", 
 						   txb, h->txPrio[txb], objNr ));
 
-				/* record last sent prio for that object */
+				/* record last sent (or aborted) prio for that object */
 				{ 
 					u_int8 locPri = h->txPrio[txb] & 0xf;
 
@@ -757,10 +1054,49 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 				obj->txbUsed &= ~txbMask;
 				h->txPrio[txb] = MSCAN_UNASSIGNED;
 				haveInt++;
+
+				if( (h->txPreempt | h->txAbort) & txbMask ){
+					/* FALSE if queue has been cleared meanwhile */
+					int keep = obj->txPreempting && !(h->txAbort & txbMask);
+					int aborted = taak & txbMask;
+
+					h->txPreempt &= ~txbMask;
+					h->txAbort	 &= ~txbMask;
+					obj->txPreempting = FALSE;
+
+					if( aborted ){
+						IDBGWRT_2((DBH,"   aborted buf %d\n", txb ));
+						if( keep ){
+							/* preempted: send frame again before FIFO */
+							obj->txHold		 = h->txFrame[txb];
+							obj->txHoldSeq	 = h->txShadow[txb].seq;
+							obj->txHoldValid = TRUE;
+						}
+						else if( obj->txAbortedCnt < MSCAN_TXABORT_MAX ){
+							/* txabort: report frame to mscan_tx_abort */
+							obj->txAborted[obj->txAbortedCnt]	 = 
+								h->txFrame[txb];
+							obj->txAbortedSeq[obj->txAbortedCnt++] = 
+								h->txShadow[txb].seq;
+						}
+					}
+					TxAbortWake( h, obj );
+					if( aborted )
+						continue;
+				}
+
+				if( obj->txConf )
+					TxConfirm( h, obj, txb );
 			}
 		}
 	}
 
+	/*--- tx buffers empty for HwFiltApply ---*/
+	if( h->txDrainWait && TxIdle( h ) ){
+		h->txDrainWait = FALSE;
+		OSS_SemSignal( h->osHdl, h->txDrainSem );
+	}
+
 	/*--- schedule new transmissions ---*/
 	for( txb=0, txbMask=0x1; txb<MSCAN_NTXBUFS; txb++, txbMask<<=1 ){
 
@@ -778,13 +1114,15 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 			 * required for loopback mode - otherwise transmitter may
 			 * overrun receiver
 			 */
-			if( (rflg = MSREAD( ma, MSCAN_RFLG )) & MSCAN_RFLG_RXF ){
-				IrqRx( h );
+			rflg = MSREAD( ma, MSCAN_RFLG );
+			if( IrqRxDrain( h, &rflg ) )
 				haveInt++;
-			}
 		}
 	}
 
+	/*--- abort lower priority tx buffer for waiting frame ---*/
+	TxPreemptCheck( h );
+
 	/*--- check for Rx overrun ---*/
 	if( rflg & MSCAN_RFLG_OVRIF ){
 		IrqOverrun( h );
@@ -799,6 +1137,14 @@ static int32 MSCAN_Irq( LL_HANDLE *llHdl )
 		haveInt++;
 	}
 
+	if( h->rxIrqFrames > h->rxIrqFramesMax )
+		h->rxIrqFramesMax = h->rxIrqFrames;
+
+	if( haveInt ){
+		MSCAN_CYCLES( h, tEnd );
+		IrqStatUpdate( h, tEnd - tStart );
+	}
+
 	IDBGWRT_2((DBH,"<<< MSCAN_Irq\n"));
 	
 	/* Restore IRQ before returning from the ISR */
@@ -947,22 +1293,68 @@ static char* Ident( void )
 static int32 Cleanup( MSCAN_HANDLE *h, int32 retCode ) 
 {
 	u_int32 nr;
+
+	/*------------------------------+
+	|  Stop cyclic tx table         |
+	+------------------------------*/
+	if( h->cycAlarm )
+		OSS_AlarmRemove( h->osHdl, &h->cycAlarm );
+	if( h->cycTbl[0] )
+		OSS_MemFree( h->osHdl, (int8 *)h->cycTbl[0], h->cycAlloc );
+	if( h->cycSem )
+		OSS_SemRemove( h->osHdl, &h->cycSem );
+
+	if( h->waitSem )
+		OSS_SemRemove( h->osHdl, &h->waitSem );
+	if( h->txDrainSem )
+		OSS_SemRemove( h->osHdl, &h->txDrainSem );
+
 	/*------------------------------+
 	|  Free message queues/sems     |
 	+------------------------------*/
-	for( nr=0; nr<MSCAN_NUM_OBJS; nr++ )
+	for( nr=0; nr<h->numObjs; nr++ )
 	{
 		if( h->msgObj[nr].sig )
 			OSS_SigRemove( h->osHdl, &h->msgObj[nr].sig );
 		if( h->msgObj[nr].q.sem )
 			OSS_SemRemove( h->osHdl, &h->msgObj[nr].q.sem );
+		if( h->msgObj[nr].txAbortSem )
+			OSS_SemRemove( h->osHdl, &h->msgObj[nr].txAbortSem );
 	
-		if( h->msgObj[nr].q.first )
+		if( h->msgObj[nr].rxRing || h->msgObj[nr].txRing )
+		{
+			OSS_MemFree( h->osHdl, (int8 *)h->msgObj[nr].ringMem, 
+						 h->msgObj[nr].ringAlloc );
+		}
+		else if( h->msgObj[nr].q.ent.mem )
 		{
-			OSS_MemFree( h->osHdl, (int8 *)h->msgObj[nr].q.first, 
+			OSS_MemFree( h->osHdl, (int8 *)h->msgObj[nr].q.ent.mem, 
 						 h->msgObj[nr].q.memAlloc );
-			h->msgObj[nr].q.first = NULL;
 		}
+		h->msgObj[nr].q.ent.mem = NULL;
+
+		if( h->msgObj[nr].txConf )
+			OSS_MemFree( h->osHdl, (int8 *)h->msgObj[nr].txConf, 
+						 h->msgObj[nr].txConfAlloc );
+
+		if( h->msgObj[nr].rules )
+			OSS_MemFree( h->osHdl, (int8 *)h->msgObj[nr].rules, 
+						 h->msgObj[nr].rulesAlloc );
+	}
+
+	if( h->msgObj ){
+		OSS_MemFree( h->osHdl, (int8 *)h->msgObj, h->msgObjAlloc );
+		h->msgObj = NULL;
+	}
+
+	if( h->rxDisp ){
+		OSS_MemFree( h->osHdl, (int8 *)h->rxDisp, h->rxDisp->memAlloc );
+		h->rxDisp = NULL;
+	}
+
+	if( h->accPool ){
+		OSS_MemFree( h->osHdl, (int8 *)h->accPool, h->accPoolAlloc );
+		h->accPool = NULL;
 	}
 
     /*------------------------------+
@@ -993,22 +1385,29 @@ static int32 Cleanup( MSCAN_HANDLE *h, int32 retCode )
 static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb )
 {
 	MSG_OBJ *obj = &h->msgObj[pb->objNr];
-	MQUEUE_ENT *ent;
-	u_int32 i;
+	u_int32 ringSize, entSize, metaSize, slotSize;
 	int32 error=0;
+	int wasRx;
 	OSS_IRQ_STATE oldState;
 
 	DBGWRT_1((DBH,"MscanConfigMsg: nr=%d dir=%d entries=%d\n", 
 			  pb->objNr, pb->dir, pb->qEntries ));
 
 	/* sanity checks */
-	if( pb->dir > MSCAN_DIR_XMT )
+	if( pb->dir > MSCAN_DIR_RCVMBOX )
 		return MSCAN_ERR_BADDIR;
 
-	if( pb->objNr >= MSCAN_NUM_OBJS )
+	if( pb->objNr >= h->numObjs )
 		return MSCAN_ERR_BADMSGNUM;
 
-	if( (pb->qEntries == 0) && (pb->dir != MSCAN_DIR_DIS) )
+	if( pb->objNr == MSCAN_ERROR_OBJ && pb->dir >= MSCAN_DIR_XMTMBOX )
+		return MSCAN_ERR_BADDIR;
+
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;
+
+	if( ((pb->qEntries == 0) || (pb->qEntries > MQUEUE_MAX_ENTRIES)) && 
+		(pb->dir != MSCAN_DIR_DIS) )
 		return MSCAN_ERR_BADPARAMETER;
 
 	if( (pb->filter.mflags & MSCAN_USE_ACCFIELD) && 
@@ -1018,12 +1417,42 @@ static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb )
 	/*-------------+
 	|  Init queue  |
 	+-------------*/	
+	wasRx = (obj->q.dir == MSCAN_DIR_RCV);
 	obj->q.ready	  = FALSE;
 
-	/*--- realloc memory for queue ---*/
-	if( obj->q.first ){
-		OSS_MemFree( h->osHdl, (void *)obj->q.first, obj->q.memAlloc );
-		obj->q.first = NULL;
+	/* local filter is used by rx objects only */
+	if( (error = ObjFilterSet( h, obj, 
+							   ((pb->objNr != MSCAN_ERROR_OBJ) && 
+								((pb->dir == MSCAN_DIR_RCV) || 
+								 (pb->dir == MSCAN_DIR_RCVMBOX))) ?
+							   &pb->filter : NULL )))
+		goto ABORT;
+
+	/* filter rules are replaced by the new local filter */
+	ObjRulesSet( h, obj, NULL, 0, 0 );
+
+	/* fan-out must be re-enabled after reconfiguration */
+	obj->shared = FALSE;
+
+	/* tx confirmation must be re-enabled after reconfiguration */
+	TxConfSetup( h, obj, 0 );
+
+	/*--- realloc memory for queue (unmaps shared rx ring) ---*/
+	if( obj->rxRing || obj->txRing ){
+		OSS_MemFree( h->osHdl, obj->ringMem, obj->ringAlloc );
+		obj->rxRing = NULL;
+		obj->txRing = NULL;
+		obj->q.ent.mem = NULL;
+		obj->q.ts = NULL;
+		obj->q.txMeta = NULL;
+	}
+	if( obj->q.ent.mem ){
+		OSS_MemFree( h->osHdl, (void *)obj->q.ent.mem, obj->q.memAlloc );
+		obj->q.ent.mem = NULL;
+		obj->q.ts = NULL;
+		obj->q.txMeta = NULL;
+		obj->txSlot = NULL;
+		obj->rxSlot = NULL;
 	}
 
 	if( pb->dir != MSCAN_DIR_DIS ){
@@ -1038,35 +1467,80 @@ static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb )
 				goto ABORT;
 			}
 		}
-		/*--- allocate new queue entries ---*/
+		/*--- allocate new queue ring (power of two entries) ---*/
+		for( ringSize=1; ringSize < pb->qEntries; ringSize <<= 1 )
+			;
+		entSize = (pb->objNr == MSCAN_ERROR_OBJ) ? 
+			sizeof(MSCAN_READERROR_PB) : sizeof(MSCAN_FRAME);
+
+		/* 
+		 * rx objects: timestamps, tx objects: per frame info
+		 * in parallel array behind entries
+		 */
+		if( pb->objNr == MSCAN_ERROR_OBJ )
+			metaSize = 0;
+		else if( pb->dir == MSCAN_DIR_RCV )
+			metaSize = sizeof(MQUEUE_TS);
+		else
+			metaSize = sizeof(MQUEUE_TXMETA);
+
+		/* tx mailbox: one slot per FIFO entry */
+		if( pb->dir == MSCAN_DIR_XMTMBOX )
+			slotSize = pb->qEntries * sizeof(MSCAN_TXSLOT);
+		else if( pb->dir == MSCAN_DIR_RCVMBOX ){
+			/* rx mailbox: no ring, slots + hash + changed bitmap */
+			entSize = metaSize = 0;
+			slotSize = pb->qEntries * sizeof(MSCAN_RXSLOT) +
+				(2 * ringSize + (pb->qEntries + 31) / 32) * sizeof(u_int32);
+		}
+		else
+			slotSize = 0;
 
-		if( (obj->q.first = (MQUEUE_ENT*)OSS_MemGet( h->osHdl, 
-												pb->qEntries * sizeof(MQUEUE_ENT),
-												&obj->q.memAlloc )) == NULL){
+		if( (obj->q.ent.mem = OSS_MemGet( 
+				 h->osHdl, ringSize * (entSize + metaSize) + slotSize,
+				 &obj->q.memAlloc )) == NULL){
 			DBGWRT_ERR((DBH,"*** MscanConfigMsg: can't alloc queue mem\n"));
 			error = ERR_OSS_MEM_ALLOC;
 			goto ABORT;
 		}
 
-		/*--- init queue entries ---*/
-		for( i=0, ent=obj->q.first; i<pb->qEntries; ent++, i++ )
-			ent->next = ent+1;
-
-		ent[-1].next = obj->q.first;
-
 		/*--- init queue ---*/
+		obj->q.ts		  = NULL;
+		obj->q.txMeta	  = NULL;
+		/* both entries have 8 bytes: decide by direction, not size */
+		if( metaSize && pb->dir == MSCAN_DIR_RCV )
+			obj->q.ts = (MQUEUE_TS *)
+				((u_int8 *)obj->q.ent.mem + ringSize * entSize);
+		else if( metaSize )
+			obj->q.txMeta = (MQUEUE_TXMETA *)
+				((u_int8 *)obj->q.ent.mem + ringSize * entSize);
+		if( pb->dir == MSCAN_DIR_XMTMBOX )
+			obj->txSlot = (MSCAN_TXSLOT *)
+				((u_int8 *)obj->q.ent.mem + ringSize * (entSize + metaSize));
+		if( pb->dir == MSCAN_DIR_RCVMBOX ){
+			obj->rxSlot		= (MSCAN_RXSLOT *)obj->q.ent.mem;
+			obj->rxHash		= (u_int32 *)(obj->rxSlot + pb->qEntries);
+			obj->rxHashMask = 2 * ringSize - 1;
+			obj->rxChanged	= obj->rxHash + 2 * ringSize;
+		}
+		obj->q.ringMask	  = ringSize - 1;
 		obj->q.totEntries = pb->qEntries;
-		obj->q.filled	  = 0;
-		obj->q.dir		  = pb->dir;
-		obj->q.filter	  = pb->filter;
+		/* mailboxes are rx/tx objects for everything except read/write */
+		if( pb->dir == MSCAN_DIR_XMTMBOX )
+			obj->q.dir	  = MSCAN_DIR_XMT;
+		else if( pb->dir == MSCAN_DIR_RCVMBOX )
+			obj->q.dir	  = MSCAN_DIR_RCV;
+		else
+			obj->q.dir	  = pb->dir;
 		obj->txbUsed	  = 0;
 		obj->txNxtPrio	  = 0;
 		obj->txSentPrio	  = 0xf;
+		obj->txExpired	  = 0;
 
 		DBGWRT_2((DBH,"filter: mask=%x code=%x cf=%x mf=%x\n",
-				  obj->q.filter.mask, obj->q.filter.code, 
-				  obj->q.filter.cflags, obj->q.filter.mflags ));
-		DBGDMP_2((DBH,"accField", (void *)obj->q.filter.accField, 0x100, 1));
+				  pb->filter.mask, pb->filter.code, 
+				  pb->filter.cflags, pb->filter.mflags ));
+		DBGDMP_2((DBH,"accField", (void *)pb->filter.accField, 0x100, 1));
 
 		oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
 
@@ -1078,7 +1552,8 @@ static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb )
 	else {
 		/*--- disable object ---*/
 		obj->q.totEntries = 0;
-		obj->q.filled	  = 0;
+		obj->q.nxtIn	  = 0;
+		obj->q.nxtOut	  = 0;
 		obj->q.ready	  = FALSE;
 		obj->q.dir		  = MSCAN_DIR_DIS;
 
@@ -1086,6 +1561,21 @@ static int32 MscanConfigMsg( MSCAN_HANDLE *h, MSCAN_CONFIGMSG_PB *pb )
  ABORT:
 	/* recompute first/last Rx/Tx object */
 	RecomputeObjLimits( h );
+
+	/* recompile Rx filters if an Rx object was added or removed */
+	if( (pb->objNr != MSCAN_ERROR_OBJ) && 
+		(wasRx || obj->q.dir == MSCAN_DIR_RCV) ){
+		BuildRxDispatch( h );
+
+		/* derive hw filter from new set of Rx objects */
+		if( h->hwFiltAuto ){
+			int32 err2 = HwFiltAuto( h, FALSE );
+
+			if( error == 0 )
+				error = err2;
+		}
+	}
+
 	return error;
 }
 
@@ -1101,8 +1591,14 @@ static int32 MscanEnable( MSCAN_HANDLE *h, int32 enable )
 	if( enable ){
 		if( !h->busTimingSet || !h->irqEnabled )
 		    error = MSCAN_ERR_NOTINIT;
-		else
+		else {
+			/* hw filter deferred by HwFiltApply */
+			if( h->hwFiltPend && !h->canEnabled ){
+				HwFiltWrite( h, &h->hwFilt );
+				h->hwFiltPend = FALSE;
+			}
 			error = InitModeLeave( h ); 
+		}
 	}
 	else {
 		error = InitModeEnter( h ); 
@@ -1166,6 +1662,12 @@ static int32 MscanSetBusTiming( MSCAN_HANDLE *h,
 
 	h->busTimingSet = TRUE;
 
+	/* bit rate (= timestamp timer frequency) and OS tick rate */
+	h->bitRate = h->canClock / (pb->brp * (1 + pb->tseg1 + pb->tseg2));
+	h->tsTickRate = OSS_TickRateGet( h->osHdl );
+	if( h->tsTickRate == 0 || h->tsTickRate > 0xffff )
+		h->tsTickRate = 0xffff;	/* TsMulDiv requires 16 bit divisor */
+
 	return 0;
 }
 
@@ -1345,6 +1847,11 @@ static int32 MscanSetFilter( MSCAN_HANDLE *h, MSCAN_SETFILTER_PB *pb )
 	SetFilter( h, 0, &pb->filter1 );
 	SetFilter( h, 1, &pb->filter2 );
 
+	/* 2x32 mode, acceptance unknown */
+	OSS_MemFill( h->osHdl, sizeof(h->hwFilt), (char *)&h->hwFilt, 0 );
+	h->hwFiltAuto = FALSE;
+	h->hwFiltPend = FALSE;
+
 	if( canWasEnabled ){
 		if(( error = InitModeLeave( h )))
 			goto XIT;
@@ -1353,25 +1860,188 @@ static int32 MscanSetFilter( MSCAN_HANDLE *h, MSCAN_SETFILTER_PB *pb )
 	return error;
 }
 
+/**********************************************************************/
+/** Handler for API function mscan_set_filter_ranges
+ *
+ * Compiles the wanted ID ranges into the hardware acceptance filters
+ * and disables automatic filtering.
+ *
+ * \param h		LL handle
+ * \param pb		parameter block
+ * \param size	size of \a pb in bytes
+ */
+static int32 MscanSetFilterRanges(
+	MSCAN_HANDLE *h,
+	MSCAN_SETFILTERRANGES_PB *pb,
+	int32 size )
+{
+	const MSCAN_IDRANGE *rng = pb->range;
+	MSCAN_HWFILT_ITEM in[MSCAN_FILTER_MAXRANGES];
+	MSCAN_HWFILT hf;
+	u_int32 i;
+
+	DBGWRT_1((DBH,"MscanSetFilterRanges mode=%d n=%d\n", 
+			  pb->mode, pb->nRanges));
+
+	if( (pb->mode > MSCAN_HWFILT_AUTO) || 
+		(pb->mode == MSCAN_HWFILT_CLOSED) ||
+		(pb->nRanges > MSCAN_FILTER_MAXRANGES) ||
+		(MSCAN_SETFILTERRANGES_PB_SIZE( pb->nRanges ) > (u_int32)size) )
+		return MSCAN_ERR_BADPARAMETER;
+
+	for( i=0; i<pb->nRanges; i++ ){
+		if( (rng[i].first > rng[i].last) || 
+			(rng[i].flags & ~MSCAN_EXTENDED) ||
+			(rng[i].last > ((rng[i].flags & MSCAN_EXTENDED) ? 
+							0x1fffffff : 0x7ff)) )
+			return MSCAN_ERR_BADPARAMETER;
+
+		in[i].ext	= (rng[i].flags & MSCAN_EXTENDED) ? 1 : 0;
+		in[i].fixed	= FALSE;
+		in[i].lo	= rng[i].first;
+		in[i].hi	= rng[i].last;
+	}
+
+	HwFiltSelect( in, pb->nRanges, 
+				  HwFiltWanted( rng, pb->nRanges, 0 ),
+				  HwFiltWanted( rng, pb->nRanges, 1 ),
+				  pb->mode, &hf );
+
+	h->hwFiltAuto = FALSE;
+	return HwFiltApply( h, &hf );
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_set_filter_rules
+ *
+ * Compiles the rules into a list of code/mask patterns that replaces
+ * the object's local filter, then rebuilds the Rx dispatch table 
+ * (and the automatic hardware filter).
+ *
+ * \param h		LL handle
+ * \param pb		parameter block
+ * \param size	size of \a pb in bytes
+ */
+static int32 MscanSetRules( 
+	MSCAN_HANDLE *h, 
+	MSCAN_SETRULES_PB *pb, 
+	int32 size )
+{
+	const MSCAN_FILTER_RULE *r = pb->rule;
+	MSG_OBJ *obj;
+	MSCAN_OBJFILTER *rules = NULL;
+	u_int32 i, num=0, gotsize=0, idMask;
+	int32 error=0;
+
+	DBGWRT_1((DBH,"MscanSetRules nr=%d n=%d\n", pb->objNr, pb->nRules));
+
+	if( (pb->objNr == MSCAN_ERROR_OBJ) || (pb->objNr >= h->numObjs) )
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( (pb->nRules > MSCAN_RULES_MAX) ||
+		(MSCAN_SETRULES_PB_SIZE( pb->nRules ) > (u_int32)size) )
+		return MSCAN_ERR_BADPARAMETER;
+
+	obj = &h->msgObj[pb->objNr];
+	if( obj->q.dir != MSCAN_DIR_RCV )
+		return MSCAN_ERR_BADDIR;
+
+	/*--- check rules and count patterns ---*/
+	for( i=0; i<pb->nRules; i++ ){
+		idMask = (r[i].flags & MSCAN_EXTENDED) ? 0x1fffffff : 0x7ff;
+
+		if( (r[i].flags & ~MSCAN_EXTENDED) || 
+			(r[i].code > idMask) || (r[i].mask > idMask) )
+			return MSCAN_ERR_BADPARAMETER;
+
+		switch( r[i].type ){
+		case MSCAN_RULE_RANGE:
+			if( r[i].code > r[i].mask )
+				return MSCAN_ERR_BADPARAMETER;
+			break;
+		case MSCAN_RULE_MASK:
+			break;
+		default:
+			return MSCAN_ERR_BADPARAMETER;
+		}
+		num += RuleCompile( &r[i], NULL );
+	}
+
+	/*--- compile ---*/
+	if( num ){
+		if( (rules = (MSCAN_OBJFILTER *)OSS_MemGet( 
+				 h->osHdl, num * sizeof(MSCAN_OBJFILTER), &gotsize )) 
+			== NULL )
+			return ERR_OSS_MEM_ALLOC;
+
+		for( i=0, num=0; i<pb->nRules; i++ )
+			num += RuleCompile( &r[i], &rules[num] );
+	}
+	DBGWRT_2((DBH," %d patterns\n", num));
+
+	ObjRulesSet( h, obj, rules, num, gotsize );
+
+	BuildRxDispatch( h );
+	if( h->hwFiltAuto )
+		error = HwFiltAuto( h, FALSE );
+
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_set_shared
+ *
+ * The accepted IDs don't change, so the hardware filter is kept.
+ *
+ * \param h		LL handle
+ * \param pb		parameter block
+ */
+static int32 MscanSetShared( MSCAN_HANDLE *h, MSCAN_SETSHARED_PB *pb )
+{
+	DBGWRT_1((DBH,"MscanSetShared nr=%d shared=%d\n", 
+			  pb->objNr, pb->shared));
+
+	if( (pb->objNr == MSCAN_ERROR_OBJ) || (pb->objNr >= h->numObjs) )
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( h->msgObj[pb->objNr].q.dir != MSCAN_DIR_RCV )
+		return MSCAN_ERR_BADDIR;
+
+	h->msgObj[pb->objNr].shared = pb->shared ? TRUE : FALSE;
+
+	BuildRxDispatch( h );
+	return 0;
+}
+
 /**********************************************************************/
 /** Handler for API function mscan_write_msg
+ *
+ * \param h		LL handle
+ * \param pb		parameter block
+ * \param lifetime	OS ticks after which the frame is dropped if not 
+ *					yet in a tx buffer (0=never)
  */ 
-static int32 MscanWriteMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb )
+static int32 MscanWriteMsg( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READWRITEMSG_PB *pb, 
+	u_int32 lifetime )
 {
 	MSG_OBJ *obj = &h->msgObj[pb->objNr];
 	int32 error = 0;
-	OSS_IRQ_STATE oldState;
 
 	DBGWRT_1((DBH,"MscanWriteMsg objNr=%d tout=%dms\n", 
 			  pb->objNr, pb->timeout));
 	DumpFrame( h, " enqueue", &pb->msg );
 
 	/* parameter checks */
-	if( pb->objNr >= MSCAN_NUM_OBJS || pb->objNr==0)
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
 		return MSCAN_ERR_BADMSGNUM;
 
-	if( obj->q.dir != MSCAN_DIR_XMT )
-		return MSCAN_ERR_BADDIR;
+	if( obj->q.dir != MSCAN_DIR_XMT || obj->txRing )
+		return MSCAN_ERR_BADDIR;	/* shared ring is written by appl. */
+
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;	/* FIFO is written by alarm */
 
 	if( !h->canEnabled )
 		return MSCAN_ERR_NOTINIT;
@@ -1379,7 +2049,9 @@ static int32 MscanWriteMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb )
 	/*-----------------------+
 	|  Check for FIFO space  |
 	+-----------------------*/
-	if( obj->q.filled == obj->q.totEntries ){
+	/* (mailbox: entry of ID is overwritten, no waiting) */
+	while( (obj->txSlot == NULL) && 
+		   (MQUEUE_FILLED( &obj->q ) == obj->q.totEntries) ){
 
 		DBGWRT_2((DBH, " FIFO full\n"));
 
@@ -1388,51 +2060,65 @@ static int32 MscanWriteMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb )
 			return MSCAN_ERR_QFULL;
 		}
 
-		while( error == 0 ){
-			obj->q.waiting = TRUE;	/* flag we're waiting for sem */
+		obj->q.waiting = TRUE;	/* flag we're waiting for sem */
+		MSCAN_MEMBAR();
+
+		/* ISR may have freed an entry before it saw the flag */
+		if( MQUEUE_FILLED( &obj->q ) != obj->q.totEntries ){
+			obj->q.waiting = FALSE;
+			break;
+		}
+
+		DEVSEM_UNLOCK( h );
 
-			DEVSEM_UNLOCK( h );
+		/* wait for FIFO space */
+		error = OSS_SemWait( h->osHdl, obj->q.sem, 
+							 pb->timeout==0 ? 
+							 OSS_SEM_WAITFOREVER : pb->timeout );
 
-			/* wait for FIFO space */
-			error = OSS_SemWait( h->osHdl, obj->q.sem, 
-								 pb->timeout==0 ? 
-								 OSS_SEM_WAITFOREVER : pb->timeout );
+		DEVSEM_LOCK( h );
 
-			DEVSEM_LOCK( h );
+		if( error ){
+			obj->q.waiting = FALSE;
+			MSCAN_MEMBAR();
 
-			if( obj->q.waiting == FALSE ){
-				/*
-				 * fifo space available
-				 */
-				break;
-			}
-			else if( error ){
-				obj->q.waiting = FALSE;
-				DBGWRT_ERR((DBH,"*** MscanWriteMsg: error 0x%x waiting for "
-							"FIFO\n", error ));
-				return error;
-			}
-			/* no error, but no fifo space, continue waiting */
+			if( MQUEUE_FILLED( &obj->q ) != obj->q.totEntries )
+				break;			/* space arrived together with timeout */
+
+			DBGWRT_ERR((DBH,"*** MscanWriteMsg: error 0x%x waiting for "
+						"FIFO\n", error ));
+			return error;
 		}
+		/* re-check FIFO, wakeup may be from an earlier signal */
 	}
 	
 	/*----------------------+
 	|  Put frame into FIFO  |
 	+----------------------*/
-	obj->q.nxtIn->d.frm = pb->msg;
-	obj->q.nxtIn = obj->q.nxtIn->next;
-	
-	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
-
-	obj->q.filled++;
-	/* enable all tx interrupts */
-	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
-	
-	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+	if( QueuePutFrames( h, obj, &pb->msg, 1, lifetime ) == 0 )
+		return MSCAN_ERR_QFULL;		/* mailbox: no free slot for ID */
 
 	return 0;
 }
 
+/**********************************************************************/
+/** Handler for API function mscan_write_msg_exp
+ */ 
+static int32 MscanWriteMsgExp( MSCAN_HANDLE *h, MSCAN_WRITEMSG_EXP_PB *pb )
+{
+	u_int32 rate = OSS_TickRateGet( h->osHdl ), ticks = 0;
+
+	DBGWRT_1((DBH,"MscanWriteMsgExp lifetime=%dms\n", pb->lifetime ));
+
+	if( pb->lifetime > 0x7fffffff / (rate ? rate : 1) )
+		return MSCAN_ERR_BADPARAMETER;
+
+	if( pb->lifetime )
+		ticks = (pb->lifetime * rate + 999) / 1000;	/* ms->ticks */
+
+	return MscanWriteMsg( h, &pb->m, ticks );
+}
+
 /**********************************************************************/
 /** Handler for API function mscan_read_msg
  */ 
@@ -1440,549 +2126,3122 @@ static int32 MscanReadMsg( MSCAN_HANDLE *h, MSCAN_READWRITEMSG_PB *pb )
 {
 	MSG_OBJ *obj = &h->msgObj[pb->objNr];
 	int32 error = 0;
-	OSS_IRQ_STATE oldState;
 
 	DBGWRT_1((DBH,"MscanReadMsg objNr=%d tout=%dms\n", 
 			  pb->objNr, pb->timeout));
 
 	/* parameter checks */
-	if( pb->objNr==0)
+	if( pb->objNr==0 || pb->objNr >= h->numObjs )
 		return MSCAN_ERR_BADMSGNUM;
 
+	if( obj->rxSlot || obj->rxRing )
+		return MSCAN_ERR_BADDIR;	/* use mscan_read_mbox / shared ring */
+
 	/* wait until there is at least one entry in FIFO */
-	if( (error = WaitRxFifoEntry( h, pb->objNr, pb->timeout )) )
+	if( (error = WaitRxFifoEntry( h, pb->objNr, 1, pb->timeout )) )
 		return error;
 
 	/*----------------------+
 	|  Get frame from FIFO  |
 	+----------------------*/
-	pb->msg = obj->q.nxtOut->d.frm;
-	obj->q.nxtOut = obj->q.nxtOut->next;
-	
-	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	pb->msg = *MQUEUE_FRM_OUT( &obj->q );
+	MSCAN_MEMBAR();				/* release entry to ISR */
 
-	obj->q.filled--;
+	obj->q.nxtOut++;
 	obj->q.errSent = FALSE;
 
-	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
-
 	DumpFrame( h, " dequeue", &pb->msg );
 
 	return 0;
 }
 
 /**********************************************************************/
-/** Handler for API function mscan_read_error
+/** Handler for API functions mscan_read_nmsg(_timeout)
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
+ * \sa ReadNFrames
  */ 
-static int32 MscanReadError( MSCAN_HANDLE *h, MSCAN_READERROR_PB *pb )
+static int32 MscanReadNMsg( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READWRITENMSG_PB *pb, 
+	int32 size )
 {
-	MSG_OBJ *obj = &h->msgObj[MSCAN_ERROR_OBJ];
-	int32 error = 0;
-	OSS_IRQ_STATE oldState;
-
-	DBGWRT_1((DBH,"MscanReadError\n" ));
-
-	/* wait (forever) until there is at least one entry in FIFO */
-	if( (error = WaitRxFifoEntry( h, MSCAN_ERROR_OBJ, 0)) )
-		return error;
-
-	/*---------------------------+
-	|  Get error info from FIFO  |
-	+---------------------------*/
-	*pb = obj->q.nxtOut->d.err;
-	obj->q.nxtOut = obj->q.nxtOut->next;
-	
-	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	DBGWRT_1((DBH,"MscanReadNMsg objNr=%d min=%d max=%d tout=%dms\n", 
+			  pb->objNr, pb->minFrames, pb->nFrames, pb->timeout));
 
-	obj->q.filled--;
-	
-	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
-
-	DBGWRT_2((DBH," dequeued error info code=%d nr=%d\n",
-			  pb->errCode, pb->objNr));
+	if( (pb->nFrames > MQUEUE_MAX_ENTRIES) ||
+		(MSCAN_NMSG_PB_SIZE( pb->nFrames ) > (u_int32)size) )
+		return ERR_LL_ILL_PARAM;
 
-	return 0;
-	
+	return ReadNFrames( h, pb->objNr, pb->timeout, pb->minFrames, 
+						&pb->nFrames, pb->frm, NULL );
 }
 
 /**********************************************************************/
-/** Handler for API function mscan_clear_busoff
- * \remark not required for MSCAN	
+/** Handler for API function mscan_read_nmsg_ts
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
+ * \sa ReadNFrames
  */ 
-static int32 MscanClearBusOff( MSCAN_HANDLE *h )
+static int32 MscanReadNMsgTs( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READNMSG_TS_PB *pb, 
+	int32 size )
 {
-	return 0;
-}
+	DBGWRT_1((DBH,"MscanReadNMsgTs objNr=%d min=%d max=%d tout=%dms\n", 
+			  pb->objNr, pb->minFrames, pb->nFrames, pb->timeout));
+
+	if( (pb->nFrames > MQUEUE_MAX_ENTRIES) ||
+		(MSCAN_NMSG_TS_PB_SIZE( pb->nFrames ) > (u_int32)size) )
+		return ERR_LL_ILL_PARAM;
 
+	return ReadNFrames( h, pb->objNr, pb->timeout, pb->minFrames, 
+						&pb->nFrames, NULL, pb->frm );
+}
 
 /**********************************************************************/
-/** Handler for API function mscan_set_rcv_sig and mscan_set_xmt_sig
+/** Handler for API function mscan_read_msg_ts
+ *
+ * Same as MscanReadMsg, but returns frame with receive timestamp
  */ 
-static int32 MscanSetSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir)
+static int32 MscanReadMsgTs( MSCAN_HANDLE *h, MSCAN_READMSG_TS_PB *pb )
 {
-	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	u_int32 n = 1;
 	int32 error;
 
-	DBGWRT_1((DBH,"MscanSetSig objNr=%d sigCode=%d\n", 
-			  pb->objNr, pb->signal));
-
-	/* parameter checks */
-	if( pb->objNr >= MSCAN_NUM_OBJS )
-		return MSCAN_ERR_BADMSGNUM;
-	
-	if( obj->q.dir != dir )
-		return MSCAN_ERR_BADDIR;
+	DBGWRT_1((DBH,"MscanReadMsgTs objNr=%d tout=%dms\n", 
+			  pb->objNr, pb->timeout));
 
-	if( obj->sig != NULL )
-		return MSCAN_ERR_SIGBUSY;
+	error = ReadNFrames( h, pb->objNr, pb->timeout, 1, &n, NULL, &pb->msg );
 
-	if( (error = OSS_SigCreate( h->osHdl, pb->signal, &obj->sig )))
-		obj->sig = NULL;
+	if( (error == 0) && (n == 0) )
+		error = MSCAN_ERR_NOMESSAGE;
 
 	return error;
 }
 
 /**********************************************************************/
-/** Handler for API function mscan_clr_rcv_sig and mscan_clr_xmt_sig
+/** Handler for API function mscan_read_mbox
+ *
+ * Takes up to pb->nEntries changed slots of a rx mailbox object from
+ * the changed bitmap (with irqs masked), starting behind the last slot 
+ * taken, so a small pb->nEntries does not starve the higher slots.
+ * Then copies them under their sequence lock. A slot updated again
+ * while it is copied is copied again; an update after it has been 
+ * taken marks it changed for the next call.
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
  */ 
-static int32 MscanClrSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir)
+static int32 MscanReadMbox( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READMBOX_PB *pb, 
+	int32 size )
 {
 	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	MSCAN_MBOX_ENTRY *e;
+	MSCAN_RXSLOT *slot;
+	OSS_IRQ_STATE oldState;
+	u_int32 n, i, s, w, b, step, seq;
 	int32 error;
 
-	DBGWRT_1((DBH,"MscanSetSig objNr=%d sigCode=%d\n", 
-			  pb->objNr, pb->signal));
+	DBGWRT_1((DBH,"MscanReadMbox objNr=%d max=%d tout=%dms\n", 
+			  pb->objNr, pb->nEntries, pb->timeout));
 
 	/* parameter checks */
-	if( pb->objNr >= MSCAN_NUM_OBJS )
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
 		return MSCAN_ERR_BADMSGNUM;
-	
-	if( obj->sig == NULL )
-		return MSCAN_ERR_SIGBUSY;
 
-	error = OSS_SigRemove( h->osHdl, &obj->sig );
+	if( obj->rxSlot == NULL )
+		return MSCAN_ERR_BADDIR;
 
-	return error;
-}
+	if( (pb->nEntries > MQUEUE_MAX_ENTRIES) ||
+		(MSCAN_READMBOX_PB_SIZE( pb->nEntries ) > (u_int32)size) )
+		return ERR_LL_ILL_PARAM;
 
-/**********************************************************************/
-/** Handler for API function mscan_queue_clear
- */ 
-static int32 MscanQueueClear( MSCAN_HANDLE *h, MSCAN_QUEUECLEAR_PB *pb )
-{
-	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	/* wait for a changed slot */
+	if( (pb->timeout != -1) && (pb->nEntries != 0) &&
+		(error = WaitRxFifoEntry( h, pb->objNr, 1, pb->timeout )) ){
+		pb->nEntries = 0;
+		return error;
+	}
 
-	DBGWRT_1((DBH,"MscanQueueClear %d\n", pb->objNr ));
+	/*--- take changed slots (slot index in ent[].updates) ---*/
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
 
-	if( pb->objNr >= MSCAN_NUM_OBJS )
-		return MSCAN_ERR_BADMSGNUM;
+	s = obj->rxSlotScan < obj->rxSlotNum ? obj->rxSlotScan : 0;
 
-	/* flag object as non-ready */
-	obj->q.ready	= FALSE;
+	for( i=0, n=0; (n < pb->nEntries) && (i < obj->rxSlotNum); ){
+		w = s >> 5;
+		b = s & 31;
 
-	/* reset FIFO counters */
-	return QueueClear( h, pb->objNr, pb->txabort );
+		if( (obj->rxChanged[w] >> b) == 0 ){
+			/* no changed slot in rest of word */
+			step = 32 - b;
+			if( step > obj->rxSlotNum - s )
+				step = obj->rxSlotNum - s;
+		}
+		else {
+			step = 1;
+			if( obj->rxChanged[w] & ((u_int32)1 << b) ){
+				obj->rxChanged[w] &= ~((u_int32)1 << b);
+				pb->ent[n++].updates = s;
+			}
+		}
+
+		i += step;
+		if( (s += step) >= obj->rxSlotNum )
+			s = 0;
+	}
+	obj->rxSlotScan = s;
+	obj->q.nxtOut += n;
+	obj->q.errSent = FALSE;
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	/*--- copy slots ---*/
+	for( e=pb->ent; e < pb->ent + n; e++ ){
+		slot = &obj->rxSlot[e->updates];
+
+		do {
+			while( (seq = slot->seq) & 1 )
+				;				/* ISR writing on other CPU */
+			MSCAN_MEMBAR();
+			e->frm	  = slot->frm;
+			e->tsHigh = slot->ts.high;
+			e->tsLow  = slot->ts.low;
+			MSCAN_MEMBAR();
+		} while( slot->seq != seq );
+
+		e->updates = seq >> 1;
+	}
+	pb->nEntries = n;
+
+	DBGWRT_2((DBH, " %d changed slots\n", n ));
+	return 0;
 }
 
 /**********************************************************************/
-/** Handler for API function mscan_queue_status
+/** Handler for API function mscan_rxring_map
+ *
+ * Moves the FIFO of a rx object into a page aligned block with a 
+ * MSCAN_RXRING header in front, which is returned to the application.
+ * Frames in the FIFO are lost. If the ring is already shared, just 
+ * returns the header again.
+ *
+ * Only available if the driver is built with MSCAN_SHRING (single 
+ * address space OSes), see mscan_int.h.
  */ 
-static int32 MscanQueueStatus( MSCAN_HANDLE *h, MSCAN_QUEUESTATUS_PB *pb )
+static int32 MscanRxRingMap( MSCAN_HANDLE *h, MSCAN_RXRINGMAP_PB *pb )
 {
+#ifdef MSCAN_NO_SHRING
+	return ERR_LL_ILL_FUNC;
+#else
 	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	MSCAN_RXRING *ring;
+	OSS_IRQ_STATE oldState;
+	u_int32 ringSize, hdrSize, gotSize;
+	void *mem, *oldMem;
+
+	DBGWRT_1((DBH,"MscanRxRingMap objNr=%d\n", pb->objNr));
 
-	if( pb->objNr >= MSCAN_NUM_OBJS )
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
 		return MSCAN_ERR_BADMSGNUM;
 
-	if( obj->q.dir == MSCAN_DIR_XMT )
-		pb->entries = obj->q.totEntries - obj->q.filled;
-	else
-		pb->entries = obj->q.filled;
+	if( obj->q.dir != MSCAN_DIR_RCV || obj->rxSlot )
+		return MSCAN_ERR_BADDIR;
+
+	if( obj->rxRing ){
+		pb->ring = obj->rxRing;
+		return 0;
+	}
+
+	/*--- header, frames, timestamps in aligned block ---*/
+	ringSize = obj->q.ringMask + 1;
+	hdrSize	 = (sizeof(MSCAN_RXRING) + 7) & ~7;
+
+	if( (mem = OSS_MemGet( h->osHdl, MSCAN_SHRING_ALIGN - 1 + hdrSize + 
+						   ringSize * (sizeof(MSCAN_FRAME) + 
+									   sizeof(MQUEUE_TS)),
+						   &gotSize )) == NULL ){
+		DBGWRT_ERR((DBH,"*** MscanRxRingMap: can't alloc ring\n"));
+		return ERR_OSS_MEM_ALLOC;
+	}
+
+	ring = (MSCAN_RXRING *)(((U_INT32_OR_64)mem + MSCAN_SHRING_ALIGN - 1) &
+							~(U_INT32_OR_64)(MSCAN_SHRING_ALIGN - 1));
+	ring->ringMask	 = obj->q.ringMask;
+	ring->totEntries = obj->q.totEntries;
+	ring->frmOff	 = hdrSize;
+	ring->tsOff		 = hdrSize + ringSize * sizeof(MSCAN_FRAME);
+
+	/*--- switch queue to new ring ---*/
+	oldMem = obj->q.ent.mem;
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	obj->q.ent.mem	 = (u_int8 *)ring + ring->frmOff;
+	obj->q.ts		 = (MQUEUE_TS *)((u_int8 *)ring + ring->tsOff);
+	obj->rxRing		 = ring;
+	obj->ringMem	 = mem;
+	obj->ringAlloc = gotSize;
+	QueueClear( h, pb->objNr, 0 );
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
 
-	pb->direction = obj->q.dir;
+	OSS_MemFree( h->osHdl, oldMem, obj->q.memAlloc );
 
+	pb->ring = ring;
 	return 0;
+#endif /* MSCAN_NO_SHRING */
 }
 
 /**********************************************************************/
-/** Handler for API function mscan_error_counters
+/** Handler for API function mscan_rxring_wait
+ *
+ * Waits until the application's shared rx ring holds \em minFrames 
+ * frames (same as the FIFO read functions).
  */ 
-static int32 MscanErrorCounters( MSCAN_HANDLE *h, MSCAN_ERRORCOUNTERS_PB *pb )
+static int32 MscanRxRingWait( MSCAN_HANDLE *h, MSCAN_RXRINGWAIT_PB *pb )
 {
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	u_int32 minFrames = pb->minFrames;
+
+	DBGWRT_1((DBH,"MscanRxRingWait objNr=%d min=%d tout=%dms\n", 
+			  pb->objNr, pb->minFrames, pb->timeout));
+
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( obj->rxRing == NULL )
+		return MSCAN_ERR_BADDIR;
+
 	/* 
-	 * standard MSCAN implementation do not allow to read error counters
-	 * while online, Z015 does...
+	 * take over frames consumed by application. The application is
+	 * the ring's only reader and does not advance nxtOut while waiting,
+	 * so the ISR copies the same value
 	 */
-#ifndef MSCAN_IS_Z15
-	if( h->canEnabled )
-		return MSCAN_ERR_ONLINE;
-#endif
+	obj->q.nxtOut = obj->rxRing->nxtOut;
 
-	pb->txErrCnt = MSREAD( h->ma, MSCAN_TXER );
-	pb->rxErrCnt = MSREAD( h->ma, MSCAN_RXER );
+	if( minFrames == 0 )
+		minFrames = 1;
+	if( minFrames > obj->q.totEntries )
+		minFrames = obj->q.totEntries;
 
-	return 0;
+	return WaitRxFifoEntry( h, pb->objNr, minFrames, pb->timeout );
 }
 
 /**********************************************************************/
-/** IrqRx
+/** Handler for API function mscan_txring_map
  *
- * called from MSCAN_Irq.
- * IrqRx assumes that there is a valid frame into the fifo.
- * Reads out a single frame from the mscan's rx fifo and tries to find
- * a matching Rx object
+ * Moves the FIFO of a tx object into a page aligned block with a 
+ * MSCAN_TXRING header in front, which is returned to the application.
+ * Frames in the FIFO are lost. If the ring is already shared, just 
+ * returns the header again.
+ *
+ * Only available if the driver is built with MSCAN_SHRING (single 
+ * address space OSes), see mscan_int.h.
  */ 
-static void IrqRx( MSCAN_HANDLE *h )
+static int32 MscanTxRingMap( MSCAN_HANDLE *h, MSCAN_TXRINGMAP_PB *pb )
 {
-	MACCESS ma = h->ma;
-	MSCAN_FRAME frm;
-	u_int32 id, idr1, idr3;
-	MSG_OBJ *obj;
-	int nr;
+#ifdef MSCAN_NO_SHRING
+	return ERR_LL_ILL_FUNC;
+#else
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	MSCAN_TXRING *ring;
+	OSS_IRQ_STATE oldState;
+	u_int32 ringSize, hdrSize, gotSize;
+	void *mem, *oldMem;
 
-	IDBGWRT_2((DBH," CAN Rx irq\n"));
-	
-	/*----------------------------+
-	|  Get frame from CAN's FIFO  |
-	+----------------------------*/
-	frm.flags = 0;
+	DBGWRT_1((DBH,"MscanTxRingMap objNr=%d\n", pb->objNr));
 
-	if( (idr1 = MSREAD( ma, MSCAN_RXIDR1 )) & 0x8 ){
-		/* extended id */
-		id = (u_int32)MSREAD( ma, MSCAN_RXIDR0 ) << 21;
-		id |= (idr1 & 0x7) << 15;
-		id |= (idr1 & 0xe0) << 13;
-		id |= (u_int32)MSREAD( ma, MSCAN_RXIDR2 ) << 7;
-		idr3 = MSREAD( ma, MSCAN_RXIDR3 );
-		id |= idr3 >> 1;
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
 
-		if (idr3 & 0x1)
-			frm.flags |= MSCAN_RTR;
+	if( obj->q.dir != MSCAN_DIR_XMT || obj->txSlot )
+		return MSCAN_ERR_BADDIR;
 
-		frm.flags |= MSCAN_EXTENDED;	
-	}
-	else {
-		/* standard ID */
-		id = (u_int32)MSREAD( ma, MSCAN_RXIDR0 ) << 3;
-		id |= idr1 >> 5;
-		if (idr1 & 0x10)
-			frm.flags |= MSCAN_RTR;	
-	}
-	frm.id = id;
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;
 
-	switch( frm.dataLen = (MSREAD( ma, MSCAN_RXDLR ) & 0xf) ){
-	case 8:	frm.data[7] = MSREAD( ma, MSCAN_RXDSR7 );
-	case 7:	frm.data[6] = MSREAD( ma, MSCAN_RXDSR6 );
-	case 6:	frm.data[5] = MSREAD( ma, MSCAN_RXDSR5 );
-	case 5:	frm.data[4] = MSREAD( ma, MSCAN_RXDSR4 );
-	case 4:	frm.data[3] = MSREAD( ma, MSCAN_RXDSR3 );
-	case 3:	frm.data[2] = MSREAD( ma, MSCAN_RXDSR2 );
-	case 2:	frm.data[1] = MSREAD( ma, MSCAN_RXDSR1 );
-	case 1:	frm.data[0] = MSREAD( ma, MSCAN_RXDSR0 );
-	case 0:
-	default:
-		break;
+	if( obj->txRing ){
+		pb->ring = obj->txRing;
+		return 0;
 	}
 
-	/* release Rx buffer */
-	MSWRITE( ma, MSCAN_RFLG, MSCAN_RFLG_RXF );
+	/*--- header, frames, (private) frame info in aligned block ---*/
+	ringSize = obj->q.ringMask + 1;
+	hdrSize	 = (sizeof(MSCAN_TXRING) + 7) & ~7;
 
-	DumpFrame( h, "   rxfrm", &frm );
+	if( (mem = OSS_MemGet( h->osHdl, MSCAN_SHRING_ALIGN - 1 + hdrSize + 
+						   ringSize * (sizeof(MSCAN_FRAME) + 
+									   sizeof(MQUEUE_TXMETA)),
+						   &gotSize )) == NULL ){
+		DBGWRT_ERR((DBH,"*** MscanTxRingMap: can't alloc ring\n"));
+		return ERR_OSS_MEM_ALLOC;
+	}
 
-	/*----------------------------------------+
-	|  Find the corresponding message object  |
-	+----------------------------------------*/
-	nr = h->firstRxObj;
+	ring = (MSCAN_TXRING *)(((U_INT32_OR_64)mem + MSCAN_SHRING_ALIGN - 1) &
+							~(U_INT32_OR_64)(MSCAN_SHRING_ALIGN - 1));
+	ring->ringMask	 = obj->q.ringMask;
+	ring->totEntries = obj->q.totEntries;
+	ring->frmOff	 = hdrSize;
 
-	for( obj=&h->msgObj[nr]; nr<=h->lastRxObj; nr++, obj++ ){		
-		if( !obj->q.ready || (obj->q.dir != MSCAN_DIR_RCV) ){			
-			continue;
-		}
+	/*--- switch queue to new ring, stop pending transmissions ---*/
+	oldMem = obj->q.ent.mem;
 
-		if( SwFilter( &frm, &obj->q.filter ) == TRUE ){			
-			IDBGWRT_2((DBH, " put frm to msg obj %d\n", nr));
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
 
-			/* put the received frame into the object's FIFO */
-			if( obj->q.filled == obj->q.totEntries ){
-				IDBGWRT_ERR((DBH, "*** MSCAN obj %d overrun\n", nr));
+	obj->q.ent.mem	 = (u_int8 *)ring + ring->frmOff;
+	obj->q.txMeta	 = (MQUEUE_TXMETA *)
+		((u_int8 *)obj->q.ent.mem + ringSize * sizeof(MSCAN_FRAME));
+	obj->txRing		 = ring;
+	obj->ringMem	 = mem;
+	obj->ringAlloc	 = gotSize;
+	QueueClear( h, pb->objNr, 0 );
 
-				if( ! obj->q.errSent ){
-					PutError( h, nr, MSCAN_QOVERRUN );
-					obj->q.errSent = TRUE;
-				}
-			}
-			else {				
-				obj->q.nxtIn->d.frm = frm;
-				obj->q.nxtIn = obj->q.nxtIn->next;
-				obj->q.filled++;
-
-				/* wakeup read waiter */
-				if( obj->q.waiting ){					
-					IDBGWRT_2((DBH, " wake read waiter\n"));
-					obj->q.waiting = FALSE;
-					OSS_SemSignal( h->osHdl, obj->q.sem );
-				}
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
 
-				/* send signal */
-				if( obj->sig ){					
-					OSS_SigSend( h->osHdl, obj->sig );
-				}
-			}
-			break;
-		}
-	}
+	OSS_MemFree( h->osHdl, oldMem, obj->q.memAlloc );
 
-#ifdef DBG
-	if( nr == MSCAN_NUM_OBJS )
-		IDBGWRT_2((DBH, " frm discarded\n"));
-#endif
+	pb->ring = ring;
+	return 0;
+#endif /* MSCAN_NO_SHRING */
 }
 
 /**********************************************************************/
-/** Schedule next transmit frame to txbuffer \a txb
- * 
- * \return 0=no frame has been scheduled for transmission, 1=scheduled
+/** Handler for MSCAN_TXDOORBELL setstat
+ *
+ * Takes over the frames the application has put into the shared tx
+ * ring of object \a nr since the last call and kicks transmission.
+ * The frames get no lifetime.
  */ 
-static int ScheduleNextTx( MSCAN_HANDLE *h, int txb )
+static int32 MscanTxDoorbell( MSCAN_HANDLE *h, u_int32 nr )
 {
-	MSG_OBJ *obj;
-	int nr, sched=FALSE;
-	u_int8 txbMask = 1<<txb;
+	MSG_OBJ *obj = &h->msgObj[nr];
+	OSS_IRQ_STATE oldState;
+	u_int32 n, i, nxtIn, tick;
+
+	if( nr >= h->numObjs || nr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( obj->txRing == NULL )
+		return MSCAN_ERR_BADDIR;
+
+	if( !h->canEnabled )
+		return MSCAN_ERR_NOTINIT;
 
-	nr = h->firstTxObj;
+	nxtIn = obj->txRing->nxtIn;
+	n	  = nxtIn - obj->q.nxtIn;
 
-	for( obj=&h->msgObj[nr]; nr<=h->lastTxObj; nr++, obj++ ){
+	DBGWRT_2((DBH, "MscanTxDoorbell: obj %d: %d new frames\n", nr, n ));
 
-		if( obj->q.ready && (obj->q.dir == MSCAN_DIR_XMT) &&
-			(obj->q.filled != 0 )){
-			sched = TRUE;
-			break;
-		}
+	if( n > obj->q.totEntries - MQUEUE_FILLED( &obj->q ) ){
+		DBGWRT_ERR((DBH,"*** MscanTxDoorbell: ring overfilled\n"));
+		return MSCAN_ERR_QFULL;
 	}
+	if( n == 0 )
+		return 0;
 
-	if( !sched )
-		return 0;				/* nothing to schedule */
-		
-	/*
-	 * if there are other scheduled frames pending for that 
-	 * object and the new (object relative) priority would be 0,
-	 * the new frame would be perhaps sent before the previous
-	 * frames. 
-	 * To avoid this, we keep track of the outstanding frames.
+	tick = OSS_TickGet( h->osHdl );
+	for( i=0; i<n; i++ ){
+		MQUEUE_TXMETA *meta = 
+			&obj->q.txMeta[(obj->q.nxtIn + i) & obj->q.ringMask];
+
+		meta->enqTick  = tick;
+		meta->lifetime = 0;
+	}
+	MSCAN_MEMBAR();				/* publish entries to ISR */
+
+	obj->q.nxtIn = nxtIn;
+
+	/* enable all tx interrupts (TIER is modified by ISR too) */
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
+	TxPreemptCheck( h );
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_wait
+ *
+ * Waits until at least one of the rx objects in pb->rxMask has entries
+ * or one of the tx objects in pb->txMask has pb->txSpace free entries.
+ * Returns the ready objects in the masks. The ISR wakes the single
+ * waitSem only for objects in the masks (MSCAN_WAIT_WAKE), the 
+ * conditions are re-checked here. The timeout is a deadline for the
+ * whole call, wakeups that don't meet the conditions only wait for
+ * the remaining time.
+ *
+ * Only one caller at a time can sleep (MSCAN_ERR_WAITBUSY), polls
+ * never fail because of another waiter.
+ */ 
+static int32 MscanWait( MSCAN_HANDLE *h, MSCAN_WAIT_PB *pb )
+{
+	u_int32 rx, tx, rate, start=0, toutTicks=0, elapsed, left;
+	int32 error = 0, waitMs = OSS_SEM_WAITFOREVER;
+
+	DBGWRT_1((DBH,"MscanWait rx=0x%x tx=0x%x space=%d tout=%dms\n", 
+			  pb->rxMask, pb->txMask, pb->txSpace, pb->timeout));
+
+	if( (pb->rxMask | pb->txMask) == 0 )
+		return MSCAN_ERR_BADPARAMETER;
+
+	if( pb->timeout > 0 ){
+		/* ms->ticks without overflow, rounded up */
+		rate	  = OSS_TickRateGet( h->osHdl );
+		rate	  = rate ? rate : 1;
+		toutTicks = (pb->timeout / 1000) * rate + 
+			((pb->timeout % 1000) * rate + 999) / 1000;
+		start	  = OSS_TickGet( h->osHdl );
+	}
+
+	while( (rx = WaitReady( h, pb->rxMask, pb->txMask, pb->txSpace, 
+							&tx )) == 0 && tx == 0 ){
+
+		if( pb->timeout == -1 )
+			break;				/* poll: return empty masks */
+
+		if( h->waitBusy )
+			return MSCAN_ERR_WAITBUSY;
+
+		if( h->waitSem == NULL ){
+			/*--- create wakeup sem ---*/
+			if( (error = OSS_SemCreate( h->osHdl, OSS_SEM_BIN, 0, 
+										&h->waitSem ))){
+				DBGWRT_ERR((DBH,"*** MscanWait: error 0x%x creating "
+							"sem\n", error));
+				return error;
+			}
+		}
+
+		if( pb->timeout > 0 ){
+			/* wait only for the time left until the deadline */
+			elapsed = OSS_TickGet( h->osHdl ) - start;
+			if( elapsed >= toutTicks ){
+				DBGWRT_ERR((DBH,"*** MscanWait: timeout\n"));
+				return ERR_OSS_TIMEOUT;
+			}
+			left = toutTicks - elapsed;
+			left = (left / rate) * 1000 + 
+				((left % rate) * 1000 + rate - 1) / rate;	/* ->ms */
+			waitMs = (left < (u_int32)pb->timeout) ? 
+				(int32)left : pb->timeout;
+		}
+
+		h->waitRx	  = pb->rxMask;
+		h->waitTx	  = pb->txMask;
+		h->waitActive = TRUE;	/* flag we're waiting for sem */
+		MSCAN_MEMBAR();
+
+		/* ISR may have changed an object before it saw the flag */
+		if( (rx = WaitReady( h, pb->rxMask, pb->txMask, pb->txSpace, 
+							 &tx )) != 0 || tx != 0 ){
+			h->waitActive = FALSE;
+			break;
+		}
+
+		h->waitBusy = TRUE;
+		DEVSEM_UNLOCK( h );
+
+		error = OSS_SemWait( h->osHdl, h->waitSem, waitMs );
+
+		DEVSEM_LOCK( h );
+		h->waitBusy = FALSE;
+
+		if( error ){
+			h->waitActive = FALSE;
+			MSCAN_MEMBAR();
+
+			rx = WaitReady( h, pb->rxMask, pb->txMask, pb->txSpace, &tx );
+			if( rx || tx ){
+				error = 0;		/* event arrived together with timeout */
+				break;
+			}
+			DBGWRT_ERR((DBH,"*** MscanWait: error 0x%x waiting\n", error));
+			return error;
+		}
+		/* re-check, wakeup may be from an earlier event */
+	}
+
+	pb->rxMask = rx;
+	pb->txMask = tx;
+	return 0;
+}
+
+/**********************************************************************/
+/** Check conditions of mscan_wait
+ *
+ * \param h			LL handle
+ * \param rxMask		rx objects to check for entries
+ * \param txMask		tx objects to check for free entries
+ * \param txSpace		free entries required (at most FIFO size, min. 1)
+ * \param txReadyP	returns ready tx objects
+ * \return ready rx objects
+ */ 
+static u_int32 WaitReady( 
+	MSCAN_HANDLE *h, 
+	u_int32 rxMask, 
+	u_int32 txMask,
+	u_int32 txSpace, 
+	u_int32 *txReadyP )
+{
+	MSG_OBJ *obj;
+	u_int32 nr, bit, filled, need, rx = 0, tx = 0;
+
+	for( nr=0; (nr < MSCAN_WAIT_MAXOBJ) && (nr < h->numObjs); nr++ ){
+		obj = &h->msgObj[nr];
+		bit = (u_int32)1 << nr;
+
+		if( !obj->q.ready )
+			continue;
+
+		if( (rxMask & bit) && (obj->q.dir == MSCAN_DIR_RCV) ){
+			/* shared ring: application's nxtOut is the current one */
+			filled = obj->rxRing ? 
+				obj->q.nxtIn - obj->rxRing->nxtOut : MQUEUE_FILLED( &obj->q );
+			if( filled )
+				rx |= bit;
+		}
+
+		if( (txMask & bit) && (obj->q.dir == MSCAN_DIR_XMT) ){
+			filled = obj->txRing ?
+				obj->txRing->nxtIn - obj->q.nxtOut : MQUEUE_FILLED( &obj->q );
+			need = txSpace ? txSpace : 1;
+			if( need > obj->q.totEntries )
+				need = obj->q.totEntries;
+			if( obj->q.totEntries - filled >= need )
+				tx |= bit;
+		}
+	}
+	*txReadyP = tx;
+	return rx;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_txconf_enable
+ */ 
+static int32 MscanTxConfEnable( MSCAN_HANDLE *h, MSCAN_TXCONFENABLE_PB *pb )
+{
+	DBGWRT_1((DBH,"MscanTxConfEnable objNr=%d entries=%d\n", 
+			  pb->objNr, pb->entries));
+
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( h->msgObj[pb->objNr].q.dir != MSCAN_DIR_XMT )
+		return MSCAN_ERR_BADDIR;
+
+	if( pb->entries > MQUEUE_MAX_ENTRIES )
+		return ERR_LL_ILL_PARAM;
+
+	return TxConfSetup( h, &h->msgObj[pb->objNr], pb->entries );
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_set_tx_sched
+ *
+ * The TXBPR values of the policies are not comparable, so a frame 
+ * scheduled under the new policy could overtake a frame of the same
+ * object still waiting in a tx buffer. Therefore the policy can only 
+ * be changed while no tx buffer is assigned.
+ */ 
+static int32 MscanTxSchedPol( MSCAN_HANDLE *h, int32 policy )
+{
+	OSS_IRQ_STATE oldState;
+	int32 error=0;
+
+	DBGWRT_1((DBH,"MscanTxSchedPol policy=%d\n", policy));
+
+	if( policy < MSCAN_TXSCHED_PRIO || policy > MSCAN_TXSCHED_CANID )
+		return MSCAN_ERR_BADPARAMETER;
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	if( !TxIdle( h ) )
+		error = MSCAN_ERR_TXBUSY;
+	else {
+		h->txSched	   = policy;
+		h->txSchedNext = h->firstTxObj;
+		h->txWrrCredit = 0;
+	}
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_set_tx_param
+ */ 
+static int32 MscanTxObjParam( MSCAN_HANDLE *h, MSCAN_TXOBJPARAM_PB *pb )
+{
+	MSG_OBJ *obj;
+	u_int32 rate = OSS_TickRateGet( h->osHdl );
+
+	DBGWRT_1((DBH,"MscanTxObjParam objNr=%d weight=%d deadline=%dms\n", 
+			  pb->objNr, pb->weight, pb->deadline));
+
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( pb->deadline > 0x7fffffff / (rate ? rate : 1) )
+		return MSCAN_ERR_BADPARAMETER;
+
+	obj = &h->msgObj[pb->objNr];
+
+	obj->txWeight	= pb->weight;
+	obj->txDeadline = (pb->deadline * rate + 999) / 1000;	/* ms->ticks */
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_read_txconf
+ *
+ * Non-blocking, copies up to pb->nEntries confirmations
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
+ */ 
+static int32 MscanReadTxConf( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READTXCONF_PB *pb, 
+	int32 size )
+{
+	MSG_OBJ *obj;
+	u_int32 n, i, lost;
+
+	DBGWRT_1((DBH,"MscanReadTxConf objNr=%d max=%d\n", 
+			  pb->objNr, pb->nEntries));
+
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( (pb->nEntries > MQUEUE_MAX_ENTRIES) ||
+		(MSCAN_TXCONF_PB_SIZE( pb->nEntries ) > (u_int32)size) )
+		return ERR_LL_ILL_PARAM;
+
+	obj = &h->msgObj[pb->objNr];
+
+	if( obj->txConf == NULL )
+		return MSCAN_ERR_NOTINIT;
+
+	n = obj->txConfIn - obj->txConfOut;
+	if( n > pb->nEntries )
+		n = pb->nEntries;
+
+	MSCAN_MEMBAR();				/* read entries after txConfIn */
+	for( i=0; i<n; i++ )
+		pb->ent[i] = obj->txConf[(obj->txConfOut + i) & obj->txConfMask];
+	MSCAN_MEMBAR();				/* release entries to ISR */
+	obj->txConfOut += n;
+
+	/* lost counter is written by ISR only */
+	lost = obj->txConfLost;
+	pb->lost = lost - obj->txConfLostRd;
+	obj->txConfLostRd = lost;
+
+	pb->nEntries = n;
+	return 0;
+}
+
+/**********************************************************************/
+/** Read multiple frames from rx object, optionally with timestamps
+ *
+ * Waits until at least \a minFrames frames are in the object's FIFO
+ * (or timeout), then copies up to \a *nFramesP frames to \a dst (or
+ * \a dstTs, including timestamps). If the timeout expires with fewer 
+ * frames present, the available frames are returned. If no frame is
+ * present, the timeout error is returned.
+ *
+ * \param h			LL handle
+ * \param objNr		message object number
+ * \param timeout		-1=don't wait, 0=wait forever, >0=tout in ms
+ * \param minFrames	number of frames to wait for
+ * \param nFramesP		in: max. number of frames, out: frames copied
+ * \param dst			destination buffer for frames (or NULL)
+ * \param dstTs		destination buffer for frames with timestamps
+ * \return error code
+ */ 
+static int32 ReadNFrames(
+	MSCAN_HANDLE *h, 
+	u_int32 objNr,
+	int32 timeout,
+	u_int32 minFrames,
+	u_int32 *nFramesP,
+	MSCAN_FRAME *dst,
+	MSCAN_FRAME_TS *dstTs )
+{
+	MSG_OBJ *obj = &h->msgObj[objNr];
+	int32 error = 0;
+
+	/* parameter checks */
+	if( objNr >= h->numObjs || objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( obj->q.dir != MSCAN_DIR_RCV || obj->rxSlot || obj->rxRing )
+		return MSCAN_ERR_BADDIR;
+
+	/* can't wait for more frames than fit into FIFO or user buffer */
+	if( minFrames > *nFramesP )
+		minFrames = *nFramesP;
+	if( minFrames > obj->q.totEntries )
+		minFrames = obj->q.totEntries;
+
+	/*-----------------------+
+	|  Wait for frames       |
+	+-----------------------*/
+	if( (timeout != -1) && (minFrames != 0) ){
+		error = WaitRxFifoEntry( h, objNr, minFrames, timeout );
+
+		/* timeout: return what we've got */
+		if( (error == ERR_OSS_TIMEOUT) && (MQUEUE_FILLED( &obj->q ) != 0) )
+			error = 0;
+
+		if( error ){
+			*nFramesP = 0;
+			return error;
+		}
+	}
+
+	/*-----------------------+
+	|  Get frames from FIFO  |
+	+-----------------------*/
+	*nFramesP = QueueGetFrames( h, obj, dst, dstTs, *nFramesP );
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_write_nmsg
+ *
+ * Puts as many frames from the parameter block into the object's FIFO
+ * as fit, never waits. \em timeout and \em minFrames are not used.
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
+ */ 
+static int32 MscanWriteNMsg( 
+	MSCAN_HANDLE *h, 
+	MSCAN_READWRITENMSG_PB *pb, 
+	int32 size )
+{
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+
+	DBGWRT_1((DBH,"MscanWriteNMsg objNr=%d n=%d\n", 
+			  pb->objNr, pb->nFrames ));
+
+	/* parameter checks */
+	if( pb->objNr >= h->numObjs || pb->objNr==0)
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( obj->q.dir != MSCAN_DIR_XMT || obj->txRing )
+		return MSCAN_ERR_BADDIR;	/* shared ring is written by appl. */
+
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;	/* FIFO is written by alarm */
+
+	if( !h->canEnabled )
+		return MSCAN_ERR_NOTINIT;
+
+	if( (pb->nFrames > MQUEUE_MAX_ENTRIES) ||
+		(MSCAN_NMSG_PB_SIZE( pb->nFrames ) > (u_int32)size) )
+		return ERR_LL_ILL_PARAM;
+
+	/*-----------------------+
+	|  Put frames into FIFO  |
+	+-----------------------*/
+	pb->nFrames = QueuePutFrames( h, obj, pb->frm, pb->nFrames, 0 );
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_read_error
+ */ 
+static int32 MscanReadError( MSCAN_HANDLE *h, MSCAN_READERROR_PB *pb )
+{
+	MSG_OBJ *obj = &h->msgObj[MSCAN_ERROR_OBJ];
+	int32 error = 0;
+
+	DBGWRT_1((DBH,"MscanReadError\n" ));
+
+	/* wait (forever) until there is at least one entry in FIFO */
+	if( (error = WaitRxFifoEntry( h, MSCAN_ERROR_OBJ, 1, 0)) )
+		return error;
+
+	/*---------------------------+
+	|  Get error info from FIFO  |
+	+---------------------------*/
+	*pb = *MQUEUE_ERR_OUT( &obj->q );
+	MSCAN_MEMBAR();				/* release entry to ISR */
+
+	obj->q.nxtOut++;
+
+	DBGWRT_2((DBH," dequeued error info code=%d nr=%d\n",
+			  pb->errCode, pb->objNr));
+
+	return 0;
+	
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_clear_busoff
+ * \remark not required for MSCAN	
+ */ 
+static int32 MscanClearBusOff( MSCAN_HANDLE *h )
+{
+	return 0;
+}
+
+
+/**********************************************************************/
+/** Handler for API function mscan_set_rcv_sig and mscan_set_xmt_sig
+ */ 
+static int32 MscanSetSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir)
+{
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	int32 error;
+
+	DBGWRT_1((DBH,"MscanSetSig objNr=%d sigCode=%d\n", 
+			  pb->objNr, pb->signal));
+
+	/* parameter checks */
+	if( pb->objNr >= h->numObjs )
+		return MSCAN_ERR_BADMSGNUM;
+	
+	if( obj->q.dir != dir )
+		return MSCAN_ERR_BADDIR;
+
+	if( obj->sig != NULL )
+		return MSCAN_ERR_SIGBUSY;
+
+	if( (error = OSS_SigCreate( h->osHdl, pb->signal, &obj->sig )))
+		obj->sig = NULL;
+
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_clr_rcv_sig and mscan_clr_xmt_sig
+ */ 
+static int32 MscanClrSig( MSCAN_HANDLE *h, MSCAN_SIGNAL_PB *pb, MSCAN_DIR dir)
+{
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	int32 error;
+
+	DBGWRT_1((DBH,"MscanSetSig objNr=%d sigCode=%d\n", 
+			  pb->objNr, pb->signal));
+
+	/* parameter checks */
+	if( pb->objNr >= h->numObjs )
+		return MSCAN_ERR_BADMSGNUM;
+	
+	if( obj->sig == NULL )
+		return MSCAN_ERR_SIGBUSY;
+
+	error = OSS_SigRemove( h->osHdl, &obj->sig );
+
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_queue_clear
+ */ 
+static int32 MscanQueueClear( MSCAN_HANDLE *h, MSCAN_QUEUECLEAR_PB *pb )
+{
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+	int32 error;
+	OSS_IRQ_STATE oldState;
+
+	DBGWRT_1((DBH,"MscanQueueClear %d\n", pb->objNr ));
+
+	if( pb->objNr >= h->numObjs )
+		return MSCAN_ERR_BADMSGNUM;
+
+	/* alarm routine is the writer of the FIFO */
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;
+
+	/* 
+	 * resetting both counters is not single producer/consumer safe,
+	 * so keep ISR out
+	 */
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	/* flag object as non-ready */
+	obj->q.ready	= FALSE;
+
+	/* reset FIFO counters */
+	error = QueueClear( h, pb->objNr, pb->txabort );
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_tx_abort
+ *
+ * Clears the object's FIFO with txabort, waits until the ISR has seen 
+ * all tx buffers of the object complete (sent or aborted) and returns 
+ * the aborted frames in FIFO order. A timeout is not an error: frames 
+ * still in the tx buffers then are not reported.
+ */ 
+static int32 MscanTxAbort( MSCAN_HANDLE *h, MSCAN_TXABORT_PB *pb )
+{
+	MSG_OBJ *obj;
+	int32 error;
+	u_int32 i, j, n;
+	OSS_IRQ_STATE oldState;
+
+	DBGWRT_1((DBH,"MscanTxAbort %d\n", pb->objNr ));
+
+	pb->nFrames = 0;
+
+	if( pb->objNr >= h->numObjs || pb->objNr==0 )
+		return MSCAN_ERR_BADMSGNUM;
+
+	obj = &h->msgObj[pb->objNr];
+
+	if( obj->q.dir != MSCAN_DIR_XMT )
+		return MSCAN_ERR_BADDIR;
+
+	if( obj->txCyclic )
+		return MSCAN_ERR_CYCLIC;
+
+	if( obj->txAbortSem == NULL ){
+		/*--- create wakeup sem for txabort ---*/
+		if( (error = OSS_SemCreate( h->osHdl, OSS_SEM_BIN, 0, 
+									&obj->txAbortSem ))){
+			DBGWRT_ERR((DBH,"*** MscanTxAbort: error 0x%x "
+						"creating sem\n",error));
+			return error;
+		}
+	}
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	obj->q.ready = FALSE;
+	error = QueueClear( h, pb->objNr, TRUE );
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	if( error )
+		return error;
+
+	/*------------------------------------+
+	|  Wait until tx buffers are done     |
+	+------------------------------------*/
+	while( obj->txAborting && pb->timeout != -1 ){
+
+		obj->txAbortWait = TRUE;	/* flag we're waiting for sem */
+		MSCAN_MEMBAR();
+
+		/* ISR may have completed before it saw the flag */
+		if( !obj->txAborting ){
+			obj->txAbortWait = FALSE;
+			break;
+		}
+
+		DEVSEM_UNLOCK( h );
+
+		error = OSS_SemWait( h->osHdl, obj->txAbortSem, 
+							 pb->timeout==0 ? 
+							 OSS_SEM_WAITFOREVER : pb->timeout );
+
+		DEVSEM_LOCK( h );
+
+		if( error ){
+			obj->txAbortWait = FALSE;
+			MSCAN_MEMBAR();
+
+			if( !obj->txAborting ){
+				error = 0;		/* completed together with timeout */
+				break;
+			}
+
+			DBGWRT_ERR((DBH,"*** MscanTxAbort: error 0x%x waiting for "
+						"tx buffers\n", error ));
+			if( error == ERR_OSS_TIMEOUT )
+				error = 0;
+			break;
+		}
+		/* re-check, wakeup may be from an earlier signal */
+	}
+
+	/*------------------------------------+
+	|  Return aborted frames, oldest first|
+	+------------------------------------*/
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	n = obj->txAbortedCnt;
+	for( i=0; i<n; i++ ){
+		/* selection sort by seq, counters may wrap */
+		u_int32 min = i;
+
+		for( j=i+1; j<n; j++ )
+			if( (int32)(obj->txAbortedSeq[j] - obj->txAbortedSeq[min]) < 0 )
+				min = j;
+
+		pb->frm[i] = obj->txAborted[min];
+		obj->txAborted[min]	   = obj->txAborted[i];
+		obj->txAbortedSeq[min] = obj->txAbortedSeq[i];
+	}
+	obj->txAbortedCnt = 0;
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	pb->nFrames = n;
+	return error;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_set_cyclic
+ *
+ * Builds the new cyclic table from the active one and the updated 
+ * entries and posts it to the alarm routine. Returns when the alarm
+ * routine has taken it over, so removed entries are no longer used.
+ * The alarm is started with the first used entry and stopped when no
+ * entry is left.
+ *
+ * Periods shorter than the alarm period (usually one OS tick) are 
+ * rejected, the alarm could not send them in time.
+ *
+ * \param h		LL handle
+ * \param pb		parameter block (variable length)
+ * \param size		size of parameter block in bytes
+ */ 
+static int32 MscanSetCyclic( 
+	MSCAN_HANDLE *h, 
+	MSCAN_SETCYCLIC_PB *pb, 
+	int32 size )
+{
+	MSCAN_CYCENT *act, *tbl;
+	MSCAN_CYCLIC *ent;
+	u_int32 i, nUsed=0, rate = OSS_TickRateGet( h->osHdl ), minMs;
+	int32 error;
+
+	DBGWRT_1((DBH,"MscanSetCyclic first=%d n=%d\n", 
+			  pb->first, pb->nEntries));
+
+	if( (pb->nEntries > MSCAN_CYCLIC_MAX) ||
+		(pb->first > MSCAN_CYCLIC_MAX - pb->nEntries) ||
+		(MSCAN_CYCLIC_PB_SIZE( pb->nEntries ) > (u_int32)size) )
+		return MSCAN_ERR_BADPARAMETER;
+
+	/* alarm granularity: known once running, one OS tick before */
+	if( h->cycRunning )
+		minMs = h->cycMs;
+	else
+		minMs = rate ? (1000 + rate - 1) / rate : 1;
+
+	for( i=0, ent=pb->ent; i<pb->nEntries; i++, ent++ ){
+		if( ent->period == 0 )
+			continue;			/* entry removed */
+
+		if( ent->objNr >= h->numObjs || ent->objNr==0 )
+			return MSCAN_ERR_BADMSGNUM;
+
+		if( h->msgObj[ent->objNr].q.dir != MSCAN_DIR_XMT ||
+			h->msgObj[ent->objNr].txRing )
+			return MSCAN_ERR_BADDIR;
+
+		if( (ent->frm.dataLen > 8) || (ent->phase > 0x7fffffff) ||
+			(ent->period > 0x7fffffff / (rate ? rate : 1)) )
+			return MSCAN_ERR_BADPARAMETER;
+
+		if( ent->period < minMs ){
+			DBGWRT_ERR((DBH,"*** MscanSetCyclic: period %dms < alarm "
+						"period %dms\n", ent->period, minMs ));
+			return MSCAN_ERR_BADPARAMETER;
+		}
+	}
+
+	/*--- first use: allocate both tables and alarm ---*/
+	if( h->cycTbl[0] == NULL ){
+		if( (h->cycTbl[0] = (MSCAN_CYCENT *)OSS_MemGet( 
+				 h->osHdl, 2 * MSCAN_CYCLIC_MAX * sizeof(MSCAN_CYCENT),
+				 &h->cycAlloc )) == NULL )
+			return ERR_OSS_MEM_ALLOC;
+
+		OSS_MemFill( h->osHdl, h->cycAlloc, (char *)h->cycTbl[0], 0 );
+		h->cycTbl[1] = h->cycTbl[0] + MSCAN_CYCLIC_MAX;
+		h->cycAct	 = 0;
+		h->cycPend	 = -1;
+	}
+
+	if( h->cycAlarm == NULL ){
+		if( (error = OSS_AlarmCreate( h->osHdl, CyclicAlarm, (void *)h,
+									  &h->cycAlarm ))){
+			DBGWRT_ERR((DBH,"*** MscanSetCyclic: error 0x%x "
+						"creating alarm\n",error));
+			return error;
+		}
+	}
+
+	if( h->cycSem == NULL ){
+		if( (error = OSS_SemCreate( h->osHdl, OSS_SEM_BIN, 0, 
+									&h->cycSem ))){
+			DBGWRT_ERR((DBH,"*** MscanSetCyclic: error 0x%x "
+						"creating sem\n",error));
+			return error;
+		}
+	}
+
+	/*--- build new table in inactive buffer ---*/
+	act = h->cycTbl[h->cycAct];
+	tbl = h->cycTbl[h->cycAct ^ 1];
+
+	for( i=0; i<MSCAN_CYCLIC_MAX; i++ ){
+		/* config part is written here only */
+		tbl[i].c		= act[i].c;
+		tbl[i].lifetime = act[i].lifetime;
+		tbl[i].restart	= FALSE;
+	}
+
+	for( i=0, ent=pb->ent; i<pb->nEntries; i++, ent++ ){
+		MSCAN_CYCENT *e = &tbl[pb->first + i];
+
+		e->c		= *ent;
+		e->lifetime = (ent->period * rate + 999) / 1000;	/* ms->ticks */
+		e->restart	= TRUE;
+	}
+
+	/* lock objects used by new table against writes and config */
+	for( i=0; i<h->numObjs; i++ )
+		h->msgObj[i].txCyclic = 0;
+
+	for( i=0; i<MSCAN_CYCLIC_MAX; i++ ){
+		if( tbl[i].c.period ){
+			h->msgObj[tbl[i].c.objNr].txCyclic++;
+			nUsed++;
+		}
+	}
+
+	/*--- pass table to alarm routine ---*/
+	MSCAN_MEMBAR();				/* table complete before posting */
+	h->cycPend = h->cycAct ^ 1;
+
+	if( !h->cycRunning ){
+		/* alarm routine not active, take over here */
+		CyclicTakeOver( h );
+
+		if( nUsed ){
+			if( (error = OSS_AlarmSet( h->osHdl, h->cycAlarm, 1, TRUE, 
+									   &h->cycMs ))){
+				DBGWRT_ERR((DBH,"*** MscanSetCyclic: error 0x%x "
+							"starting alarm\n",error));
+				return error;
+			}
+			if( h->cycMs == 0 )
+				h->cycMs = 1;
+			h->cycRunning = TRUE;
+			DBGWRT_2((DBH," alarm started, period %dms\n", h->cycMs ));
+		}
+		return 0;
+	}
+
+	/*
+	 * wait until alarm routine took over the table (next alarm).
+	 * The device stays locked, the inactive table is still in use.
+	 * The timeout only guards against a lost wakeup.
+	 */
+	while( h->cycPend >= 0 ){
+		h->cycWait = TRUE;		/* flag we're waiting for sem */
+		MSCAN_MEMBAR();
+
+		/* alarm may have taken over before it saw the flag */
+		if( h->cycPend < 0 )
+			break;
+
+		OSS_SemWait( h->osHdl, h->cycSem, 4 * h->cycMs + 10 );
+	}
+	h->cycWait = FALSE;
+
+	if( nUsed == 0 ){
+		OSS_AlarmClear( h->osHdl, h->cycAlarm );
+		h->cycRunning = FALSE;
+		DBGWRT_2((DBH," alarm stopped\n"));
+	}
+	return 0;
+}
+
+/**********************************************************************/
+/** Make posted cyclic table the active one
+ *
+ * Timing of changed entries restarts now, other entries keep their
+ * state from the previous table. Called from the alarm routine or,
+ * when the alarm is not running, from MscanSetCyclic().
+ *
+ * \param h		LL handle
+ */ 
+static void CyclicTakeOver( MSCAN_HANDLE *h )
+{
+	MSCAN_CYCENT *old = h->cycTbl[h->cycAct], *e;
+	int i;
+
+	MSCAN_MEMBAR();				/* read table after cycPend */
+	e = h->cycTbl[h->cycPend];
+
+	for( i=0; i<MSCAN_CYCLIC_MAX; i++, e++, old++ ){
+		if( e->restart ){
+			e->due	   = h->cycNow + e->c.phase;
+			e->left	   = e->c.count;
+			e->restart = FALSE;
+		}
+		else {
+			e->due	= old->due;
+			e->left = old->left;
+		}
+	}
+
+	h->cycAct = h->cycPend;
+	MSCAN_MEMBAR();				/* old table no longer used */
+	h->cycPend = -1;
+	MSCAN_MEMBAR();
+
+	if( h->cycWait ){
+		h->cycWait = FALSE;
+		OSS_SemSignal( h->osHdl, h->cycSem );
+	}
+}
+
+/**********************************************************************/
+/** Alarm routine for cyclic tx table
+ *
+ * Queues the frames of all due entries into their tx objects. 
+ * Transmissions missed because the alarm was late are not repeated.
+ * If a tx FIFO is full, the frame is tried again at the next alarm.
+ * The frames get the entry's period as lifetime, so a frame that
+ * could not be sent within its period is dropped.
+ *
+ * \param arg	LL handle
+ */ 
+static void CyclicAlarm( void *arg )
+{
+	MSCAN_HANDLE *h = (MSCAN_HANDLE *)arg;
+	MSCAN_CYCENT *e;
+	int i;
+
+	if( h->cycPend >= 0 )
+		CyclicTakeOver( h );
+
+	h->cycNow += h->cycMs;
+
+	if( !h->canEnabled )
+		return;
+
+	for( i=0, e=h->cycTbl[h->cycAct]; i<MSCAN_CYCLIC_MAX; i++, e++ ){
+
+		if( (e->c.period == 0) || (e->c.count && e->left == 0) ||
+			((int32)(h->cycNow - e->due) < 0) )
+			continue;
+
+		if( QueuePutFrames( h, &h->msgObj[e->c.objNr], &e->c.frm, 1, 
+							e->lifetime ) == 0 ){
+			IDBGWRT_2((DBH,"  cyclic %d: obj %d FIFO full\n", 
+					   i, e->c.objNr ));
+			continue;
+		}
+
+		do
+			e->due += e->c.period;
+		while( (int32)(h->cycNow - e->due) >= 0 );
+
+		if( e->c.count )
+			e->left--;
+	}
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_queue_status
+ */ 
+static int32 MscanQueueStatus( MSCAN_HANDLE *h, MSCAN_QUEUESTATUS_PB *pb )
+{
+	MSG_OBJ *obj = &h->msgObj[pb->objNr];
+
+	if( pb->objNr >= h->numObjs )
+		return MSCAN_ERR_BADMSGNUM;
+
+	if( obj->q.dir == MSCAN_DIR_XMT )
+		pb->entries = obj->q.totEntries - MQUEUE_FILLED( &obj->q );
+	else
+		pb->entries = MQUEUE_FILLED( &obj->q );
+
+	if( obj->txSlot )
+		pb->direction = MSCAN_DIR_XMTMBOX;
+	else if( obj->rxSlot )
+		pb->direction = MSCAN_DIR_RCVMBOX;	/* entries: changed slots */
+	else
+		pb->direction = obj->q.dir;
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Handler for API function mscan_error_counters
+ */ 
+static int32 MscanErrorCounters( MSCAN_HANDLE *h, MSCAN_ERRORCOUNTERS_PB *pb )
+{
+	/* 
+	 * standard MSCAN implementation do not allow to read error counters
+	 * while online, Z015 does...
+	 */
+#ifndef MSCAN_IS_Z15
+	if( h->canEnabled )
+		return MSCAN_ERR_ONLINE;
+#endif
+
+	pb->txErrCnt = MSREAD( h->ma, MSCAN_TXER );
+	pb->rxErrCnt = MSREAD( h->ma, MSCAN_RXER );
+
+	return 0;
+}
+
+/**********************************************************************/
+/** IrqRx
+ *
+ * called from MSCAN_Irq.
+ * IrqRx assumes that there is a valid frame into the fifo.
+ * Reads out a single frame from the mscan's rx fifo and delivers it 
+ * to the lowest matching Rx object and all matching shared objects
+ */ 
+static void IrqRx( MSCAN_HANDLE *h )
+{
+	MACCESS ma = h->ma;
+	MSCAN_FRAME frm;
+	MQUEUE_TS ts;
+	u_int32 id, idr1, idr3, n=0;
+	const u_int8 *tgt;
+	MSG_OBJ *obj;
+	int nr, gotObj=FALSE;
+
+	IDBGWRT_2((DBH," CAN Rx irq\n"));
+
+	/* capture receive time first */
+	RxTimestamp( h, &ts );
+	
+	/*----------------------------+
+	|  Get frame from CAN's FIFO  |
+	+----------------------------*/
+	frm.flags = 0;
+
+	if( (idr1 = MSREAD( ma, MSCAN_RXIDR1 )) & 0x8 ){
+		/* extended id */
+		id = (u_int32)MSREAD( ma, MSCAN_RXIDR0 ) << 21;
+		id |= (idr1 & 0x7) << 15;
+		id |= (idr1 & 0xe0) << 13;
+		id |= (u_int32)MSREAD( ma, MSCAN_RXIDR2 ) << 7;
+		idr3 = MSREAD( ma, MSCAN_RXIDR3 );
+		id |= idr3 >> 1;
+
+		if (idr3 & 0x1)
+			frm.flags |= MSCAN_RTR;
+
+		frm.flags |= MSCAN_EXTENDED;	
+	}
+	else {
+		/* standard ID */
+		id = (u_int32)MSREAD( ma, MSCAN_RXIDR0 ) << 3;
+		id |= idr1 >> 5;
+		if (idr1 & 0x10)
+			frm.flags |= MSCAN_RTR;	
+	}
+	frm.id = id;
+
+	switch( frm.dataLen = (MSREAD( ma, MSCAN_RXDLR ) & 0xf) ){
+	case 8:	frm.data[7] = MSREAD( ma, MSCAN_RXDSR7 );
+	case 7:	frm.data[6] = MSREAD( ma, MSCAN_RXDSR6 );
+	case 6:	frm.data[5] = MSREAD( ma, MSCAN_RXDSR5 );
+	case 5:	frm.data[4] = MSREAD( ma, MSCAN_RXDSR4 );
+	case 4:	frm.data[3] = MSREAD( ma, MSCAN_RXDSR3 );
+	case 3:	frm.data[2] = MSREAD( ma, MSCAN_RXDSR2 );
+	case 2:	frm.data[1] = MSREAD( ma, MSCAN_RXDSR1 );
+	case 1:	frm.data[0] = MSREAD( ma, MSCAN_RXDSR0 );
+	case 0:
+	default:
+		break;
+	}
+
+	/* release Rx buffer */
+	MSWRITE( ma, MSCAN_RFLG, MSCAN_RFLG_RXF );
+
+	DumpFrame( h, "   rxfrm", &frm );
+
+	/*-------------------------------------------+
+	|  Find the corresponding message object(s)  |
+	+-------------------------------------------*/
+	tgt = NULL;
+	if( h->rxDisp ){
+		tgt = RxDispatch( h, h->rxDisp, &frm );
+
+		/* 
+		 * target being reconfigured (table not yet rebuilt): evaluate
+		 * filters, so the next matching object takes the frame
+		 */
+		for( n=0; tgt[n] != MSCAN_RXDISP_NONE; n++ )
+			if( !h->msgObj[tgt[n]].q.ready ){
+				tgt = NULL;
+				break;
+			}
+		n = 0;
+	}
+
+	if( tgt == NULL ){
+		/* no dispatch table, evaluate each object's filter */
+		nr = h->firstRxObj;
+
+		for( obj=&h->msgObj[nr]; nr<=h->lastRxObj; nr++, obj++ ){		
+			if( obj->q.ready && (obj->q.dir == MSCAN_DIR_RCV) &&
+				(obj->shared || !gotObj) && ObjMatch( h, obj, &frm )){
+
+				h->rxTgt[n++] = (u_int8)nr;
+				if( !obj->shared ){
+					gotObj = TRUE;
+					if( h->rxShared == 0 )
+						break;
+				}
+			}
+		}
+		h->rxTgt[n] = MSCAN_RXDISP_NONE;
+		tgt = h->rxTgt;
+	}
+
+	if( *tgt == MSCAN_RXDISP_NONE ){
+		IDBGWRT_2((DBH, " frm discarded\n"));
+		return;
+	}
+
+	/* copy the decoded frame to each target */
+	for( ; *tgt != MSCAN_RXDISP_NONE; tgt++ )
+		RxDeliver( h, *tgt, &frm, &ts );
+}
+
+/**********************************************************************/
+/** Put received frame into Rx object
+ *
+ * called from IrqRx for each target object of the frame.
+ *
+ * \param	h		LL handle
+ * \param	nr		message object number
+ * \param	frm		received frame
+ * \param	ts		its receive timestamp
+ */ 
+static void RxDeliver( 
+	MSCAN_HANDLE *h, 
+	int nr, 
+	const MSCAN_FRAME *frm, 
+	const MQUEUE_TS *ts )
+{
+	MSG_OBJ *obj = &h->msgObj[nr];
+
+	if( !obj->q.ready || (obj->q.dir != MSCAN_DIR_RCV) ){
+		IDBGWRT_2((DBH, " frm discarded by obj %d\n", nr));
+		return;
+	}
+
+	IDBGWRT_2((DBH, " put frm to msg obj %d\n", nr));
+
+	/* shared ring: frames consumed by application */
+	if( obj->rxRing && (obj->q.nxtOut != obj->rxRing->nxtOut) ){
+		obj->q.nxtOut  = obj->rxRing->nxtOut;
+		obj->q.errSent = FALSE;
+	}
+
+	/* put the received frame into the object's FIFO */
+	if( obj->rxSlot ){
+		/* mailbox: overwrite the slot of the frame's ID */
+		if( !RxMboxPut( h, obj, frm, ts ) )
+			return;
+	}
+	else if( MQUEUE_FILLED( &obj->q ) == obj->q.totEntries ){
+		IDBGWRT_ERR((DBH, "*** MSCAN obj %d overrun\n", nr));
+
+		if( ! obj->q.errSent ){
+			PutError( h, nr, MSCAN_QOVERRUN );
+			obj->q.errSent = TRUE;
+		}
+		return;
+	}
+	else {				
+		*MQUEUE_FRM_IN( &obj->q ) = *frm;
+		if( obj->q.ts )
+			obj->q.ts[obj->q.nxtIn & obj->q.ringMask] = *ts;
+		MSCAN_MEMBAR();			/* publish entry to reader */
+		obj->q.nxtIn++;
+		if( obj->rxRing )
+			obj->rxRing->nxtIn = obj->q.nxtIn;
+	}
+	MSCAN_MEMBAR();				/* nxtIn visible before checking waiter */
+
+	MSCAN_WAIT_WAKE( h, h->waitRx, nr );
+
+	/* wakeup read waiter if enough frames queued */
+	if( obj->q.waiting && 
+		(MQUEUE_FILLED( &obj->q ) >= obj->q.wakeLevel) ){
+		IDBGWRT_2((DBH, " wake read waiter\n"));
+		obj->q.waiting = FALSE;
+		OSS_SemSignal( h->osHdl, obj->q.sem );
+	}
+
+	/* send signal */
+	if( obj->sig ){					
+		OSS_SigSend( h->osHdl, obj->sig );
+	}
+}
+
+/**********************************************************************/
+/** Store received frame in rx mailbox object
+ *
+ * called from IrqRx. Looks up the slot of the frame's ID in the 
+ * object's hash (linear probing; the hash has twice the entries of the
+ * slots, so there is always a free cell) or binds a new slot. 
+ * The slot is written under its sequence lock, so MscanReadMbox can 
+ * copy it without masking irqs. If the slot was not yet marked changed,
+ * it is marked and q.nxtIn is advanced.
+ *
+ * \param	h		LL handle
+ * \param	obj		message object (rx mailbox)
+ * \param	frm		received frame
+ * \param	ts		its receive timestamp
+ * \return	TRUE if frame stored, FALSE if no free slot for ID
+ */ 
+static int RxMboxPut( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	const MSCAN_FRAME *frm, 
+	const MQUEUE_TS *ts )
+{
+	MSCAN_RXSLOT *slot;
+	u_int32 key = MSCAN_RXSLOT_KEY( frm );
+	u_int32 i, idx, bit;
+
+	for( i = MSCAN_RXDISP_HASH( key, 0 ) & obj->rxHashMask; ; 
+		 i = (i + 1) & obj->rxHashMask ){
+
+		if( (idx = obj->rxHash[i]) == 0 ){
+			/* new ID */
+			if( obj->rxSlotNum == obj->q.totEntries ){
+				IDBGWRT_ERR((DBH, "*** MSCAN obj %d: no mbox slot for ID "
+							 "0x%x\n", obj->nr, frm->id));
+
+				if( ! obj->q.errSent ){
+					PutError( h, obj->nr, MSCAN_QOVERRUN );
+					obj->q.errSent = TRUE;
+				}
+				return FALSE;
+			}
+			idx = obj->rxSlotNum++;
+			obj->rxSlot[idx].seq = 0;
+			obj->rxSlot[idx].key = key;
+			obj->rxHash[i] = idx + 1;
+			break;
+		}
+		if( obj->rxSlot[--idx].key == key )
+			break;
+	}
+
+	slot = &obj->rxSlot[idx];
+
+	slot->seq++;				/* odd: update in progress */
+	MSCAN_MEMBAR();
+	slot->frm = *frm;
+	slot->ts  = *ts;
+	MSCAN_MEMBAR();
+	slot->seq++;
+
+	bit = 1 << (idx & 31);
+	if( !(obj->rxChanged[idx >> 5] & bit) ){
+		obj->rxChanged[idx >> 5] |= bit;
+		MSCAN_MEMBAR();			/* publish bit to reader */
+		obj->q.nxtIn++;
+	}
+	return TRUE;
+}
+
+/**********************************************************************/
+/** Drain the controller's Rx FIFO
+ *
+ * called from MSCAN_Irq.
+ * Calls IrqRx() as long as RXF is set, but not more than RX_DRAIN_MAX
+ * times per interrupt. Frames left in the FIFO keep RXF set, so the
+ * interrupt is asserted again.
+ *
+ * \param rflgP	in: RFLG contents, out: RFLG contents after draining
+ * \return number of frames read
+ */ 
+static u_int32 IrqRxDrain( MSCAN_HANDLE *h, u_int8 *rflgP )
+{
+	u_int32 n = 0;
+	u_int8 rflg = *rflgP;
+
+	while( (rflg & MSCAN_RFLG_RXF) && (h->rxIrqFrames < h->rxDrainMax) ){
+		IrqRx( h );
+		h->rxIrqFrames++;
+		n++;
+		rflg = MSREAD( h->ma, MSCAN_RFLG );
+	}
+	*rflgP = rflg;
+	return n;
+}
+
+/**********************************************************************/
+/** Select tx object to be served next according to h->txSched
+ *
+ * - MSCAN_TXSCHED_PRIO: lowest object number with pending frames
+ * - MSCAN_TXSCHED_RR/WRR: objects with pending frames in turn, each
+ *   sending up to its weight (RR: 1) frames per turn
+ * - MSCAN_TXSCHED_EDF: object whose head frame has the earliest
+ *   deadline (time queued + object's deadline)
+ * - MSCAN_TXSCHED_CANID: object whose head frame has the lowest 
+ *   arbitration key (CAN ID)
+ *
+ * \return object number or -1 if nothing to schedule
+ */ 
+static int TxSchedSelect( MSCAN_HANDLE *h )
+{
+	MSG_OBJ *obj;
+	int nr, i, n, found=-1;
+	u_int32 weight, dl, bestDl=0;
+
+	switch( h->txSched ){
+	case MSCAN_TXSCHED_RR:
+	case MSCAN_TXSCHED_WRR:
+		/* continue with current object of round */
+		nr = h->txSchedNext;
+		if( nr < h->firstTxObj || nr > h->lastTxObj )
+			nr = h->firstTxObj;
+
+		n = h->lastTxObj - h->firstTxObj + 1;
+		for( i=0; i<n; i++ ){
+			if( MSCAN_TXOBJ_PENDING( &h->msgObj[nr] )){
+				found = nr;
+				break;
+			}
+			if( ++nr > h->lastTxObj )
+				nr = h->firstTxObj;
+		}
+		if( found < 0 )
+			break;
+
+		obj	   = &h->msgObj[found];
+		weight = (h->txSched == MSCAN_TXSCHED_WRR && obj->txWeight) ? 
+			obj->txWeight : 1;
+
+		/* new turn: grant weight frames */
+		if( found != h->txSchedNext || h->txWrrCredit == 0 )
+			h->txWrrCredit = weight;
+		h->txSchedNext = found;
+
+		if( --h->txWrrCredit == 0 )
+			h->txSchedNext = found + 1;	/* turn over */
+		break;
+
+	case MSCAN_TXSCHED_EDF:
+		nr = h->firstTxObj;
+		for( obj=&h->msgObj[nr]; nr<=h->lastTxObj; nr++, obj++ ){
+			if( !MSCAN_TXOBJ_PENDING( obj ))
+				continue;
+
+			dl = obj->q.txMeta[obj->q.nxtOut & obj->q.ringMask].enqTick + 
+				obj->txDeadline;
+			if( found < 0 || (int32)(dl - bestDl) < 0 ){
+				found  = nr;
+				bestDl = dl;
+			}
+		}
+		break;
+
+	case MSCAN_TXSCHED_CANID:
+		nr = h->firstTxObj;
+		for( obj=&h->msgObj[nr]; nr<=h->lastTxObj; nr++, obj++ ){
+			MSCAN_FRAME *frm;
+
+			/* wait until preempted frame is back in hold */
+			if( !MSCAN_TXOBJ_PENDING( obj ) || obj->txPreempting )
+				continue;
+
+			frm = obj->txHoldValid ? &obj->txHold : MQUEUE_FRM_OUT( &obj->q );
+			dl	= MSCAN_ARB_KEY( frm );
+			if( found < 0 || dl < bestDl ){
+				found  = nr;
+				bestDl = dl;
+			}
+		}
+		break;
+
+	default:					/* MSCAN_TXSCHED_PRIO */
+		nr = h->firstTxObj;
+		for( obj=&h->msgObj[nr]; nr<=h->lastTxObj; nr++, obj++ ){
+			if( MSCAN_TXOBJ_PENDING( obj )){
+				found = nr;
+				break;
+			}
+		}
+		break;
+	}
+	return found;
+}
+
+/**********************************************************************/
+/** MSCAN_TXSCHED_CANID: preempt tx buffer for lower CAN ID
+ *
+ * When all tx buffers are busy and a frame is waiting with a lower 
+ * CAN ID than the frame in the lowest priority tx buffer, request abort
+ * of that buffer. The ISR puts the aborted frame back into the object's
+ * hold slot (unless it was sent meanwhile). One abort at a time.
+ *
+ * Must be called with irqs masked.
+ */ 
+static void TxPreemptCheck( MSCAN_HANDLE *h )
+{
+	MSG_OBJ *obj;
+	int nr, txb, victim=-1;
+	u_int32 key;
+
+	if( (h->txSched != MSCAN_TXSCHED_CANID) || h->txPreempt || h->txAbort ||
+		h->txHalt )
+		return;
+
+	for( txb=0; txb<MSCAN_NTXBUFS; txb++ )
+		if( h->txPrio[txb] == MSCAN_UNASSIGNED )
+			return;				/* free buffer available */
+
+	if( (nr = TxSchedSelect( h )) < 0 )
+		return;
+
+	obj = &h->msgObj[nr];
+	key = MSCAN_ARB_KEY( obj->txHoldValid ? 
+						 &obj->txHold : MQUEUE_FRM_OUT( &obj->q ));
+
+	/* 
+	 * victim: lowest hardware priority, which is always the last
+	 * scheduled frame of its object. Not from an object that
+	 * already has a held frame or is the waiting object.
+	 */
+	for( txb=0; txb<MSCAN_NTXBUFS; txb++ ){
+		obj = &h->msgObj[h->txPrio[txb] >> 4];
+
+		if( ((h->txPrio[txb] >> 4) == nr) || obj->txHoldValid )
+			continue;
+
+		if( victim < 0 || h->txBpr[txb] > h->txBpr[victim] ||
+			(h->txBpr[txb] == h->txBpr[victim] && 
+			 h->txKey[txb] > h->txKey[victim]))
+			victim = txb;
+	}
+
+	if( victim < 0 || h->txKey[victim] <= key )
+		return;
+
+	IDBGWRT_2((DBH,"  preempt buf %d for obj %d\n", victim, nr ));
+
+	h->txPreempt |= 1<<victim;
+	h->msgObj[h->txPrio[victim] >> 4].txPreempting = TRUE;
+	MSWRITE( h->ma, MSCAN_TARQ, 1<<victim );
+}
+
+/**********************************************************************/
+/** Schedule next transmit frame to txbuffer \a txb
+ * 
+ * The object is selected by TxSchedSelect. In MSCAN_TXSCHED_PRIO mode,
+ * the hardware priority of the tx buffer is derived from the object
+ * number, so lower objects overtake frames already in the tx buffers.
+ * In the other modes, the tx buffers get a global sequence number as
+ * priority, so frames are sent in the order they were scheduled.
+ *
+ * \return 0=no frame has been scheduled for transmission, 1=scheduled
+ */ 
+static int ScheduleNextTx( MSCAN_HANDLE *h, int txb )
+{
+	MSG_OBJ *obj;
+	MSCAN_FRAME *frm;
+	int nr, i, fromHold;
+	u_int8 txbMask = 1<<txb;
+	u_int8 txbpr;
+
+	if( h->txHalt )
+		return 0;				/* tx buffers draining */
+
+	/*
+	 * global sequence wraps to 0: wait until all other tx buffers
+	 * are sent, otherwise the new frame would overtake them
+	 */
+	if( (h->txSched != MSCAN_TXSCHED_PRIO) && 
+		(h->txSched != MSCAN_TXSCHED_CANID) && (h->txSeqNxt == 0) ){
+		for( i=0; i<MSCAN_NTXBUFS; i++ ){
+			if( (i != txb) && (h->txPrio[i] != MSCAN_UNASSIGNED) ){
+				IDBGWRT_2((DBH,"  SchedNextTx: delay for seq wrap\n"));
+				return 0;
+			}
+		}
+	}
+
+	for(;;){
+		if( (nr = TxSchedSelect( h )) < 0 )
+			return 0;				/* nothing to schedule */
+
+		obj = &h->msgObj[nr];
+
+		MSCAN_MEMBAR();				/* read entry after nxtIn */
+
+		/* drop expired frames, select again if FIFO became empty */
+		if( obj->txHoldValid || TxDropExpired( h, obj ) == 0 ||
+			MQUEUE_FILLED( &obj->q ) != 0 )
+			break;
+	}
+		
+	/*
+	 * if there are other scheduled frames pending for that 
+	 * object and the new (object relative) priority would be 0,
+	 * the new frame would be perhaps sent before the previous
+	 * frames. 
+	 * To avoid this, we keep track of the outstanding frames.
+	 */
+	if( (h->txSched == MSCAN_TXSCHED_PRIO) && 
+		(obj->txNxtPrio == 0) && (obj->txSentPrio < 0xf) ){
+		IDBGWRT_2((DBH,"  SchedNextTx: delay obj %d\n", nr ));
+		return 0;
+	}
+
+	/* frame aborted by preemption is sent before the FIFO */
+	fromHold = obj->txHoldValid;
+	frm = fromHold ? &obj->txHold : MQUEUE_FRM_OUT( &obj->q );
+
+	/* hardware priority of tx buffer */
+	if( h->txSched == MSCAN_TXSCHED_PRIO )
+		txbpr = MSCAN_TXBPR_VAL( obj->txNxtPrio + (nr<<4) );
+	else if( h->txSched == MSCAN_TXSCHED_CANID ){
+		/* 
+		 * upper bits of CAN ID, but behind the object's frames 
+		 * already in tx buffers to keep FIFO order
+		 */
+		u_int32 pri = MSCAN_ARB_KEY( frm ) >> 24;
+
+		for( i=0; i<MSCAN_NTXBUFS; i++ )
+			if( (obj->txbUsed & (1<<i)) && (h->txBpr[i] >= pri) )
+				pri = h->txBpr[i] + 1;
+
+		if( pri > 0xff ){
+			IDBGWRT_2((DBH,"  SchedNextTx: delay obj %d (prio)\n", nr ));
+			return 0;
+		}
+		txbpr = (u_int8)pri;
+	}
+	else {
+		txbpr = (u_int8)h->txSeqNxt;
+		h->txSeqNxt = (h->txSeqNxt + 1) & 0xff;
+	}
+
+	/* record new priority being scheduled on tx buffer */
+	h->txPrio[txb] = obj->txNxtPrio + (nr<<4);
+	h->txBpr[txb]  = txbpr;
+
+	/* advance local priority for next frame */
+	obj->txNxtPrio = (obj->txNxtPrio + 1) & 0xf;
+
+	obj->txbUsed |= txbMask;
+		
+	/*----------------------------------------+ 
+	|  Put frame from FIFO into tx buffer     |
+	+----------------------------------------*/
+	{
+		MACCESS ma = h->ma;
+		const u_int8 *dataP = frm->data;
+		u_int32 id = frm->id;
+	
+		IDBGWRT_2((DBH,"   tx buf %d prio=0x%02x obj %d\n",
+				   txb, h->txPrio[txb], nr ));
+		DumpFrame( h, "   tx", frm );
+
+		/* remember frame for tx confirmation, preemption and txabort */
+		h->txShadow[txb].seq   = fromHold ? obj->txHoldSeq : obj->q.nxtOut;
+		h->txShadow[txb].id	   = id;
+		h->txShadow[txb].flags = frm->flags;
+		h->txFrame[txb]		   = *frm;
+		if( h->txSched == MSCAN_TXSCHED_CANID )
+			h->txKey[txb]	= MSCAN_ARB_KEY( frm );
+
+		MSWRITE( ma, MSCAN_BSEL, txbMask ); /* select tx buffer */
+
+		MSWRITE( ma, MSCAN_TXDSR0, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR1, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR2, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR3, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR4, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR5, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR6, *dataP++ );
+		MSWRITE( ma, MSCAN_TXDSR7, *dataP++ );
+
+		MSWRITE( ma, MSCAN_TXDLR, frm->dataLen );
+
+		if( frm->flags & MSCAN_EXTENDED ){
+			/* extended message */
+			MSWRITE( ma, MSCAN_TXIDR0, id>>21 );
+			MSWRITE( ma, MSCAN_TXIDR1, ((id>>13)&0xe0) | 0x18 | 
+					 ((id>>15)&0x07));
+
+			MSWRITE( ma, MSCAN_TXIDR2, id>>7 );
+			MSWRITE( ma, MSCAN_TXIDR3, (id<<1) | 
+					 ((frm->flags & MSCAN_RTR) ? 0x1:0x0));
+		}
+		else {
+			MSWRITE( ma, MSCAN_TXIDR0, id>>3 );
+			MSWRITE( ma, MSCAN_TXIDR1, (id<<5) | 
+					 ((frm->flags & MSCAN_RTR) ? 0x10:0x0));
+		}
+
+		MSWRITE( ma, MSCAN_TXBPR, txbpr );
+		
+		/* enable irq, start TX */
+		MSSETMASK( ma, MSCAN_TIER, txbMask );
+		MSWRITE( ma, MSCAN_TFLG, txbMask );
+	}
+
+
+	if( fromHold ){
+		obj->txHoldValid = FALSE;
+		return 1;				/* FIFO already advanced */
+	}
+
+	/* fifo handling */
+	MSCAN_MEMBAR();				/* release entry to writer */
+	obj->q.nxtOut++;
+	if( obj->txRing )
+		obj->txRing->nxtOut = obj->q.nxtOut;
+	MSCAN_MEMBAR();				/* nxtOut visible before checking waiter */
+
+	MSCAN_WAIT_WAKE( h, h->waitTx, obj->nr );
+
+	/* wakeup write waiter */
+	if( obj->q.waiting ){
+		IDBGWRT_2((DBH, " wake write waiter\n"));
+		obj->q.waiting = FALSE;
+		OSS_SemSignal( h->osHdl, obj->q.sem );
+	}
+
+	/* send signal */
+	if( obj->sig )
+		OSS_SigSend( h->osHdl, obj->sig );
+
+	return 1;		
+}
+
+
+/**********************************************************************/
+/** Handle Rx overrun errors
+ *
+ */ 
+static void IrqOverrun( MSCAN_HANDLE *h )
+{
+	MACCESS ma = h->ma;
+
+	IDBGWRT_ERR((DBH,"*** CAN Rx overrun\n"));
+	PutError( h, 0, MSCAN_DATA_OVERRUN );
+
+	MSWRITE( ma, MSCAN_RFLG, MSCAN_RFLG_OVRIF );
+}
+
+/**********************************************************************/
+/** Check for node status changes.
+ * 
+ * This is called from MSCAN_Irq() and InitModeLeave().
+ *
+ * \remark CSCIF is cleared in MSCAN_Irq() routine!
+ */ 
+static void IrqStatus( MSCAN_HANDLE *h )
+{
+	MSCAN_NODE_STATUS oldState = h->nodeStatus;
+	MSCAN_NODE_STATUS newState;
+
+	IDBGWRT_2((DBH," CAN Status changed\n"));
+	/* detemine new status */
+	newState = NodeStatus( h );
+
+	/* check for state change */
+	if( oldState != MSCAN_NS_BUS_OFF && 
+		newState == MSCAN_NS_BUS_OFF )
+		PutError( h, 0, MSCAN_BUSOFF_SET );
+
+	if( oldState == MSCAN_NS_BUS_OFF && 
+		newState != MSCAN_NS_BUS_OFF )
+		PutError( h, 0, MSCAN_BUSOFF_CLR );
+
+	if( oldState != MSCAN_NS_ERROR_PASSIVE && 
+		newState == MSCAN_NS_ERROR_PASSIVE )
+		PutError( h, 0, MSCAN_WARN_SET );
+
+	if( oldState == MSCAN_NS_ERROR_PASSIVE && 
+		newState != MSCAN_NS_ERROR_PASSIVE )
+		PutError( h, 0, MSCAN_WARN_CLR );
+
+
+	IDBGWRT_2((DBH," oldState=%d newState=%d\n", oldState, newState));
+
+	h->nodeStatus = newState;
+}
+
+/**********************************************************************/
+/** Determine node status (error active, warning, passive or bus off)
+ *
+ */
+static MSCAN_NODE_STATUS NodeStatus( MSCAN_HANDLE *h )
+{
+	u_int8 rflg = MSREAD( h->ma, MSCAN_RFLG );
+	MSCAN_NODE_STATUS nodeStatus;
+
+	/* 
+	 * following Bosch CAN Spec V2.0:
+	 * "a node is error passive when tx error count or rx error count >=128"
+	 * "a node is bus off when tx error count >= 256 
 	 */
-	if( (obj->txNxtPrio == 0) && (obj->txSentPrio < 0xf) ){
-		IDBGWRT_2((DBH,"  SchedNextTx: delay obj %d\n", nr ));
-		return 0;
+	if( (rflg & 0xc) == 0xc ){
+		/* bus off */
+		nodeStatus = MSCAN_NS_BUS_OFF;
+	}
+	else if( ((rflg & 0xc) == 0x8) || ((rflg & 0x30) == 0x20) ){
+		/* error passive */
+		nodeStatus = MSCAN_NS_ERROR_PASSIVE;
+	}
+	else {
+		/* error active */
+		nodeStatus = MSCAN_NS_ERROR_ACTIVE;
 	}
+	IDBGWRT_2((DBH," NodeStatus: rlfg=0x%02x node state=%d\n", 
+			   rflg, nodeStatus));
+	return nodeStatus;		
+}
 
-	/* record new priority being scheduled on tx buffer */
-	h->txPrio[txb] = obj->txNxtPrio + (nr<<4);
+/**********************************************************************/
+/** Software filtering. Check if \a frm matches compiled filter \a f
+ *
+ * \param frm		frame to compare
+ * \param f			compiled filter (see ObjFilterSet)
+ * \returns 0=no hit, 1 hit
+ */
+static int SwFilter( 
+	MSCAN_HANDLE *h, 
+	const MSCAN_FRAME *frm, 
+	const MSCAN_OBJFILTER *f )
+{
+	if( (frm->flags & f->flagMask) != f->flagCode )
+		return 0;
 
-	/* advance local priority for next frame */
-	obj->txNxtPrio = (obj->txNxtPrio + 1) & 0xf;
+	if( (frm->id & f->care) != f->code )
+		return 0;
 
-	obj->txbUsed |= txbMask;
-		
-	/*----------------------------------------+ 
-	|  Put frame from FIFO into tx buffer     |
-	+----------------------------------------*/
-	{
-		MACCESS ma = h->ma;
-		MSCAN_FRAME *frm = &obj->q.nxtOut->d.frm;
-		const u_int8 *dataP = frm->data;
-		u_int32 id = frm->id;
-	
-		IDBGWRT_2((DBH,"   tx buf %d prio=0x%02x obj %d\n",
-				   txb, h->txPrio[txb], nr ));
-		DumpFrame( h, "   tx", frm );
+	/* individual filter */
+	if( f->accIdx &&
+		! MSCAN_ACCFIELD_GET( h->accPool[f->accIdx-1].field, frm->id ))
+		return 0;
 
-		MSWRITE( ma, MSCAN_BSEL, txbMask ); /* select tx buffer */
+	return 1;
+}
 
-		MSWRITE( ma, MSCAN_TXDSR0, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR1, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR2, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR3, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR4, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR5, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR6, *dataP++ );
-		MSWRITE( ma, MSCAN_TXDSR7, *dataP++ );
+/**********************************************************************/
+/** Set local filter of a message object
+ *
+ * Converts the API filter into the compact form evaluated by SwFilter.
+ * An acceptance field is kept in the accField pool, where objects with 
+ * identical fields share one entry. So the 256 byte fields stay out of
+ * the message objects, which IrqRx scans when there is no Rx dispatch
+ * table. The object's previous pool entry is released.
+ *
+ * \param obj		message object
+ * \param fspec		filter from mscan_config_msg, NULL to clear filter
+ * \return error code
+ */
+static int32 ObjFilterSet( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	const MSCAN_FILTER *fspec )
+{
+	MSCAN_OBJFILTER flt;
+	MSCAN_ACCENT *ent = NULL;
+	u_int32 i, k;
+	OSS_IRQ_STATE oldState;
 
-		MSWRITE( ma, MSCAN_TXDLR, frm->dataLen );
+	OSS_MemFill( h->osHdl, sizeof(flt), (char *)&flt, 0 );
 
-		if( frm->flags & MSCAN_EXTENDED ){
-			/* extended message */
-			MSWRITE( ma, MSCAN_TXIDR0, id>>21 );
-			MSWRITE( ma, MSCAN_TXIDR1, ((id>>13)&0xe0) | 0x18 | 
-					 ((id>>15)&0x07));
+	if( fspec ){
+		flt.flagMask = (u_int8)(MSCAN_EXTENDED | (fspec->mflags & MSCAN_RTR));
+		flt.flagCode = (u_int8)(fspec->cflags & flt.flagMask);
+		flt.care	 = ~fspec->mask;
+		flt.code	 = fspec->code & flt.care;
+	}
 
-			MSWRITE( ma, MSCAN_TXIDR2, id>>7 );
-			MSWRITE( ma, MSCAN_TXIDR3, (id<<1) | 
-					 ((frm->flags & MSCAN_RTR) ? 0x1:0x0));
+	if( fspec && (fspec->mflags & MSCAN_USE_ACCFIELD) ){
+
+		/*--- first use: alloc pool, one entry per object is enough ---*/
+		if( h->accPool == NULL ){
+			if( (h->accPool = (MSCAN_ACCENT *)OSS_MemGet( 
+					 h->osHdl, h->numObjs * sizeof(MSCAN_ACCENT), 
+					 &h->accPoolAlloc )) == NULL )
+				return ERR_OSS_MEM_ALLOC;
+
+			OSS_MemFill( h->osHdl, h->accPoolAlloc, (char *)h->accPool, 0 );
 		}
-		else {
-			MSWRITE( ma, MSCAN_TXIDR0, id>>3 );
-			MSWRITE( ma, MSCAN_TXIDR1, (id<<5) | 
-					 ((frm->flags & MSCAN_RTR) ? 0x10:0x0));
+
+		/*--- use entry with identical field, else a free one ---*/
+		for( i=0; i<h->numObjs; i++ ){
+			if( h->accPool[i].refs == 0 ){
+				if( ent == NULL )
+					ent = &h->accPool[i];
+				continue;
+			}
+
+			for( k=0; k<sizeof(fspec->accField); k++ )
+				if( h->accPool[i].field[k] != fspec->accField[k] )
+					break;
+
+			if( k == sizeof(fspec->accField) ){
+				ent = &h->accPool[i];
+				break;
+			}
+		}
+
+		/* free entry is not referenced, so fill it with irqs enabled */
+		if( ent->refs == 0 )
+			OSS_MemCopy( h->osHdl, sizeof(ent->field), 
+						 (char *)fspec->accField, (char *)ent->field );
+
+		flt.accIdx = (u_int16)(ent - h->accPool + 1);
+	}
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	if( ent )
+		ent->refs++;
+	if( obj->q.filter.accIdx )
+		h->accPool[obj->q.filter.accIdx-1].refs--;
+	obj->q.filter = flt;
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return 0;
+}
+
+/**********************************************************************/
+/** Check if \a frm matches the filter rules or local filter of \a obj
+ *
+ * \param obj		message object
+ * \param frm		frame to compare
+ * \returns 0=no hit, 1 hit
+ */
+static int ObjMatch( 
+	MSCAN_HANDLE *h, 
+	const MSG_OBJ *obj, 
+	const MSCAN_FRAME *frm )
+{
+	const MSCAN_OBJFILTER *f = MSCAN_OBJ_FILTERS(obj);
+	u_int32 i;
+
+	for( i=0; i<MSCAN_OBJ_NFILTERS(obj); i++, f++ )
+		if( SwFilter( h, frm, f ))
+			return 1;
+	return 0;
+}
+
+/**********************************************************************/
+/** Exchange the compiled filter rules of a message object
+ *
+ * The old rules are freed after the exchange.
+ *
+ * \param obj		message object
+ * \param rules		new rules (NULL: use local filter again)
+ * \param num		number of entries in \a rules
+ * \param alloc		allocated size of \a rules
+ */
+static void ObjRulesSet( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	MSCAN_OBJFILTER *rules,
+	u_int32 num,
+	u_int32 alloc )
+{
+	MSCAN_OBJFILTER *old;
+	u_int32 oldAlloc;
+	OSS_IRQ_STATE oldState;
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	old				= obj->rules;
+	oldAlloc		= obj->rulesAlloc;
+	obj->rules		= rules;
+	obj->numRules	= num;
+	obj->rulesAlloc	= alloc;
+
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	if( old )
+		OSS_MemFree( h->osHdl, (int8 *)old, oldAlloc );
+}
+
+/**********************************************************************/
+/** Compile a filter rule into code/mask patterns
+ *
+ * A range is split into aligned power-of-two blocks, each of which is
+ * one pattern (at most two per ID bit). A mask rule is one pattern.
+ * RTR is not compared.
+ *
+ * \param rule		checked rule
+ * \param out		patterns (NULL: just count)
+ * \returns number of patterns
+ */
+static u_int32 RuleCompile( 
+	const MSCAN_FILTER_RULE *rule, 
+	MSCAN_OBJFILTER *out )
+{
+	u_int32 first = rule->code, last = rule->mask, size, n=0;
+	u_int32 idSpace = (rule->flags & MSCAN_EXTENDED) ? 
+		0x20000000 : MSCAN_NUM_STD_IDS;
+	MSCAN_OBJFILTER f;
+
+	f.flagMask = MSCAN_EXTENDED;
+	f.flagCode = (u_int8)(rule->flags & MSCAN_EXTENDED);
+	f.accIdx   = 0;
+
+	if( rule->type == MSCAN_RULE_MASK ){
+		f.care = ~rule->mask;
+		f.code = rule->code & f.care;
+		if( out )
+			*out = f;
+		return 1;
+	}
+
+	for(;;){
+		/* largest aligned block starting at first within range */
+		size = first ? (first & (~first + 1)) : idSpace;
+		while( size - 1 > last - first )
+			size >>= 1;
+
+		f.care = ~(size - 1);
+		f.code = first;
+		if( out )
+			out[n] = f;
+		n++;
+
+		if( size - 1 == last - first )
+			break;
+		first += size;
+	}
+	return n;
+}
+
+/**********************************************************************/
+/** Account ISR time and frames read in ISR to statistics
+ *
+ * \param h		LL handle
+ * \param t		ISR time in internal ticks (see MSCAN_CYCLES)
+ */
+static void IrqStatUpdate( MSCAN_HANDLE *h, u_int32 t )
+{
+	MSCAN_IRQSTAT_PB *st = &h->irqStat;
+	u_int32 v, bin;
+
+	if( st->count == 0 || t < st->minTime )
+		st->minTime = t;
+	if( t > st->maxTime )
+		st->maxTime = t;
+	if( t > h->maxIrqTime )
+		h->maxIrqTime = t;
+
+	v = st->sumLow + t;
+	if( v < st->sumLow )
+		st->sumHigh++;
+	st->sumLow = v;
+	st->count++;
+
+	/* log2 bin: number of significant bits */
+	for( bin=0, v=t; v && bin < MSCAN_IRQSTAT_TBINS-1; bin++ )
+		v >>= 1;
+	st->timeHist[bin]++;
+
+	bin = h->rxIrqFrames;
+	if( bin > MSCAN_IRQSTAT_FBINS-1 )
+		bin = MSCAN_IRQSTAT_FBINS-1;
+	st->framesHist[bin]++;
+}
+
+/**********************************************************************/
+/** Extend raw timer value to 64 bit timestamp
+ *
+ * ODIN: \a raw is a 16 bit value of the controller's timer (clocked with
+ * the bit rate), latched into RXTIM/TXTIM. The wraps of the timer since
+ * the last timestamp are estimated from the OS tick: the elapsed ticks
+ * are converted exactly into bit times (elapsed * bitRate / tickRate), 
+ * so the estimation error does not grow with the idle time, and the
+ * 64 bit value stays correct as long as the tick is accurate to 
+ * +/- 1/2 timer period.
+ * Since Tx completions can be latched before the last Rx frame, values
+ * slightly older than the last timestamp are accepted.
+ *
+ * Others: \a raw is a 32 bit value from MSCAN_TS_GET (default: OS tick),
+ * if the cycle counter is not used (see TsCycles).
+ *
+ * \param h		LL handle
+ * \param raw	raw timer value
+ * \param ts	receives timestamp
+ */
+static void TsExtend( MSCAN_HANDLE *h, u_int32 raw, MQUEUE_TS *ts )
+{
+	u_int32 delta, low;
+#ifdef MSCAN_IS_ODIN
+	u_int32 tick = OSS_TickGet( h->osHdl ), wraps, frac, hi, lo;
+	int32 x;
+#endif
+
+	if( !h->tsValid ){
+		/* first timestamp: start time base */
+		h->tsHigh  = 0;
+		h->tsLow   = raw;
+		h->tsValid = TRUE;
+	}
+	else {
+#ifdef MSCAN_IS_ODIN
+		delta = (raw - h->tsLastRaw) & 0xffff;
+
+		/* estimate elapsed bit times from OS tick */
+		TsMulDiv( tick - h->tsLastTick, h->bitRate, 
+				  h->tsTickRate ? h->tsTickRate : 1, &hi, &lo );
+		wraps	= (hi << 16) | (lo >> 16);
+		frac	= lo & 0xffff;
+
+		/* choose number of wraps where delta fits best to estimate */
+		x = (int32)frac - (int32)delta + 0x8000;
+		if( x < 0 ){
+			if( wraps == 0 ){
+				/* older than last timestamp, don't move time base */
+				delta = 0x10000 - delta;
+				ts->high = h->tsHigh - ((h->tsLow < delta) ? 1 : 0);
+				ts->low	 = h->tsLow - delta;
+				return;
+			}
+			wraps--;
 		}
+		else if( x >= 0x10000 )
+			wraps++;
+
+		/* add wraps*65536 */
+		h->tsHigh += wraps >> 16;
+		low = h->tsLow + (wraps << 16);
+		if( low < h->tsLow )
+			h->tsHigh++;
+		h->tsLow = low;
+#else
+		delta = raw - h->tsLastRaw;
+#endif
+		low = h->tsLow + delta;
+		if( low < h->tsLow )
+			h->tsHigh++;
+		h->tsLow = low;
+	}
+	h->tsLastRaw  = raw;
+#ifdef MSCAN_IS_ODIN
+	h->tsLastTick = tick;
+#endif
+	ts->high = h->tsHigh;
+	ts->low	 = h->tsLow;
+}
+
+#if defined(MSCAN_IS_ODIN) || defined(MSCAN_TS_CYCLES)
+/**********************************************************************/
+/** Compute \a a * \a b / \a c with 64 bit intermediate result
+ *
+ * Uses 16 bit digits, so no 64 bit type is required.
+ *
+ * \param c		divisor (1..0xffff)
+ * \param hiP	receives bits 63..32 of the quotient
+ * \param loP	receives bits 31..0 of the quotient
+ */
+static void TsMulDiv( 
+	u_int32 a, 
+	u_int32 b, 
+	u_int32 c, 
+	u_int32 *hiP, 
+	u_int32 *loP )
+{
+	u_int32 al = a & 0xffff, ah = a >> 16, bl = b & 0xffff, bh = b >> 16;
+	u_int32 ll = al * bl, lh = al * bh, hl = ah * bl, mid, hi, lo;
+	u_int32 d[4], r=0, cur, i;
+
+	/* a * b */
+	mid = (ll >> 16) + (lh & 0xffff) + (hl & 0xffff);
+	lo	= (mid << 16) | (ll & 0xffff);
+	hi	= ah * bh + (lh >> 16) + (hl >> 16) + (mid >> 16);
+
+	/* divide digit by digit, remainder < c fits into 16 bit */
+	d[0] = hi >> 16;
+	d[1] = hi & 0xffff;
+	d[2] = lo >> 16;
+	d[3] = lo & 0xffff;
+	for( i=0; i<4; i++ ){
+		cur	 = (r << 16) | d[i];
+		d[i] = cur / c;
+		r	 = cur % c;
+	}
+	*hiP = (d[0] << 16) | d[1];
+	*loP = (d[2] << 16) | d[3];
+}
+#endif /* MSCAN_IS_ODIN || MSCAN_TS_CYCLES */
+
+#ifdef MSCAN_TS_CYCLES
+/**********************************************************************/
+/** Measure frequency of the cycle counter used for timestamps
+ *
+ * Counts the cycles between two OS tick edges at least MSCAN_TSCAL_MS
+ * apart. If the frequency does not fit into 32 bit, the timestamps are
+ * shifted right. h->tsCycFreq stays 0 (OS tick timestamps) if the tick 
+ * rate is unusable.
+ *
+ * \param h		LL handle
+ */
+static void TsCalibrate( MSCAN_HANDLE *h )
+{
+	u_int32 rate = OSS_TickRateGet( h->osHdl ), t0, t1, tick, n;
+	u_int32 hi0, lo0, hi1, lo1, hi, lo, shift=0;
+
+	h->tsCycFreq = 0;
+	if( rate == 0 || rate > 0xffff )
+		return;					/* TsMulDiv requires 16 bit divisor */
+
+	/* start at an OS tick edge */
+	t0 = OSS_TickGet( h->osHdl );
+	while( (tick = OSS_TickGet( h->osHdl )) == t0 )
+		;
+	MSCAN_CYCLES64( h, hi0, lo0 );
+	t0 = tick;
+
+	OSS_Delay( h->osHdl, MSCAN_TSCAL_MS );
+
+	/* stop at an OS tick edge */
+	t1 = OSS_TickGet( h->osHdl );
+	while( (tick = OSS_TickGet( h->osHdl )) == t1 )
+		;
+	MSCAN_CYCLES64( h, hi1, lo1 );
+	n = tick - t0;
+
+	/* cycles must fit into 32 bit (< 1s at 4GHz) */
+	if( (hi1 - hi0 - ((lo1 < lo0) ? 1 : 0)) != 0 || n == 0 || n > 0xffff ){
+		DBGWRT_ERR((DBH,"*** TsCalibrate: can't measure, use OS tick\n"));
+		return;
+	}
+
+	/* cycles per second */
+	TsMulDiv( lo1 - lo0, rate, n, &hi, &lo );
+	while( hi ){
+		lo = (lo >> 1) | (hi << 31);
+		hi >>= 1;
+		shift++;
+	}
+
+	h->tsCycShift = shift;
+	h->tsCycFreq  = lo;
+	DBGWRT_2((DBH, " TsCalibrate: %d Hz, shift %d\n", lo, shift));
+}
+
+/**********************************************************************/
+/** Get 64 bit timestamp from the cycle counter
+ *
+ * \param h		LL handle
+ * \param ts	receives timestamp
+ * \sa TsCalibrate
+ */
+static void TsCycles( MSCAN_HANDLE *h, MQUEUE_TS *ts )
+{
+	u_int32 hi, lo, s = h->tsCycShift;
+
+	MSCAN_CYCLES64( h, hi, lo );
+	if( s ){
+		lo = (lo >> s) | (hi << (32 - s));
+		hi >>= s;
+	}
+	ts->high = hi;
+	ts->low	 = lo;
+}
+#endif /* MSCAN_TS_CYCLES */
+
+/**********************************************************************/
+/** Get 64 bit receive timestamp of frame in Rx FIFO
+ *
+ * \param h		LL handle
+ * \param ts	receives timestamp
+ * \sa TsExtend
+ */
+static void RxTimestamp( MSCAN_HANDLE *h, MQUEUE_TS *ts )
+{
+#ifdef MSCAN_IS_ODIN
+	TsExtend( h, ((u_int32)MSREAD( h->ma, MSCAN_RXTIMH ) << 8) | 
+			  MSREAD( h->ma, MSCAN_RXTIML ), ts );
+#else
+# ifdef MSCAN_TS_CYCLES
+	if( h->tsCycFreq ){
+		TsCycles( h, ts );
+		return;
+	}
+# endif
+	TsExtend( h, MSCAN_TS_GET( h ), ts );
+#endif
+}
+
+/**********************************************************************/
+/** Get 64 bit completion timestamp of tx buffer \a txb
+ *
+ * \param h		LL handle
+ * \param txb	tx buffer (0..2)
+ * \param ts	receives timestamp
+ * \sa TsExtend
+ */
+static void TxTimestamp( MSCAN_HANDLE *h, int txb, MQUEUE_TS *ts )
+{
+#ifdef MSCAN_IS_ODIN
+	MSWRITE( h->ma, MSCAN_BSEL, 1<<txb ); /* select tx buffer */
+	TsExtend( h, ((u_int32)MSREAD( h->ma, MSCAN_TXTIMH ) << 8) | 
+			  MSREAD( h->ma, MSCAN_TXTIML ), ts );
+#else
+# ifdef MSCAN_TS_CYCLES
+	if( h->tsCycFreq ){
+		TsCycles( h, ts );
+		return;
+	}
+# endif
+	TsExtend( h, MSCAN_TS_GET( h ), ts );
+#endif
+}
+
+/**********************************************************************/
+/** Put Tx confirmation for completed tx buffer \a txb (ISR)
+ *
+ * \param h		LL handle
+ * \param obj	message object that owned \a txb (txConf enabled)
+ * \param txb	tx buffer (0..2)
+ */
+static void TxConfirm( MSCAN_HANDLE *h, MSG_OBJ *obj, int txb )
+{
+	MSCAN_TXCONF *ent;
+	MQUEUE_TS ts;
+
+	if( obj->txConfIn - obj->txConfOut > obj->txConfMask ){
+		IDBGWRT_ERR((DBH,"*** obj %d tx confirmation lost\n", obj->nr ));
+		obj->txConfLost++;
+		return;
+	}
+
+	TxTimestamp( h, txb, &ts );
+
+	ent = &obj->txConf[obj->txConfIn & obj->txConfMask];
+	*ent = h->txShadow[txb];
+	ent->tsHigh = ts.high;
+	ent->tsLow	= ts.low;
+
+	MSCAN_MEMBAR();				/* publish entry to reader */
+	obj->txConfIn++;
+}
+
+/**********************************************************************/
+/** Drop frames at head of tx FIFO whose lifetime has expired
+ *
+ * Called from ScheduleNextTx() before a frame is put into a tx buffer.
+ * Frames already in a tx buffer (or in the hold slot) are never 
+ * dropped. Wakes up a write waiter if frames were dropped.
+ *
+ * \param h		LL handle
+ * \param obj	message object (configured for Tx)
+ * \return number of dropped frames
+ */ 
+static u_int32 TxDropExpired( MSCAN_HANDLE *h, MSG_OBJ *obj )
+{
+	MQUEUE_TXMETA *meta;
+	u_int32 n = 0, now = 0;
+
+	if( obj->q.txMeta == NULL )
+		return 0;
 
-		MSWRITE( ma, MSCAN_TXBPR, h->txPrio[txb] );
-		
-		/* enable irq, start TX */
-		MSSETMASK( ma, MSCAN_TIER, txbMask );
-		MSWRITE( ma, MSCAN_TFLG, txbMask );
+	while( MQUEUE_FILLED( &obj->q ) != 0 ){
+		meta = &obj->q.txMeta[obj->q.nxtOut & obj->q.ringMask];
+
+		if( meta->lifetime == 0 )
+			break;
+
+		if( n == 0 )
+			now = OSS_TickGet( h->osHdl );	/* only if lifetime used */
+
+		if( now - meta->enqTick <= meta->lifetime )
+			break;
+
+		IDBGWRT_2((DBH,"  obj %d: drop expired frame\n", obj->nr ));
+		MSCAN_MEMBAR();			/* release entry to writer */
+		obj->q.nxtOut++;
+		n++;
 	}
 
+	if( n == 0 )
+		return 0;
+
+	if( obj->txRing )
+		obj->txRing->nxtOut = obj->q.nxtOut;
+	obj->txExpired += n;
+	MSCAN_MEMBAR();				/* nxtOut visible before checking waiter */
 
-	/* fifo handling */
-	obj->q.nxtOut = obj->q.nxtOut->next;
-	obj->q.filled--;
+	MSCAN_WAIT_WAKE( h, h->waitTx, obj->nr );
 
-	/* wakeup write waiter */
 	if( obj->q.waiting ){
-		IDBGWRT_2((DBH, " wake write waiter\n"));
 		obj->q.waiting = FALSE;
 		OSS_SemSignal( h->osHdl, obj->q.sem );
 	}
-
-	/* send signal */
 	if( obj->sig )
 		OSS_SigSend( h->osHdl, obj->sig );
 
-	return 1;		
+	return n;
 }
 
-
 /**********************************************************************/
-/** Handle Rx overrun errors
+/** Wake up mscan_tx_abort when all aborted tx buffers of object are done
+ *
+ * Called from MSCAN_Irq() when a tx buffer of \a obj completed and from
+ * InitModeLeave().
  *
+ * \param h		LL handle
+ * \param obj	message object
  */ 
-static void IrqOverrun( MSCAN_HANDLE *h )
+static void TxAbortWake( MSCAN_HANDLE *h, MSG_OBJ *obj )
 {
-	MACCESS ma = h->ma;
+	if( !obj->txAborting || (obj->txbUsed & h->txAbort) )
+		return;
 
-	IDBGWRT_ERR((DBH,"*** CAN Rx overrun\n"));
-	PutError( h, 0, MSCAN_DATA_OVERRUN );
+	obj->txAborting = FALSE;
+	MSCAN_MEMBAR();
 
-	MSWRITE( ma, MSCAN_RFLG, MSCAN_RFLG_OVRIF );
+	if( obj->txAbortWait ){
+		obj->txAbortWait = FALSE;
+		OSS_SemSignal( h->osHdl, obj->txAbortSem );
+	}
 }
 
 /**********************************************************************/
-/** Check for node status changes.
- * 
- * This is called from MSCAN_Irq() and InitModeLeave().
+/** Setup (or remove) Tx confirmation ring of object
  *
- * \remark CSCIF is cleared in MSCAN_Irq() routine!
- */ 
-static void IrqStatus( MSCAN_HANDLE *h )
+ * \param h			LL handle
+ * \param obj		message object
+ * \param entries	number of ring entries (rounded up to a power of
+ *					two), 0 to remove ring
+ * \return error code
+ */
+static int32 TxConfSetup( MSCAN_HANDLE *h, MSG_OBJ *obj, u_int32 entries )
 {
-	MSCAN_NODE_STATUS oldState = h->nodeStatus;
-	MSCAN_NODE_STATUS newState;
-
-	IDBGWRT_2((DBH," CAN Status changed\n"));
-	/* detemine new status */
-	newState = NodeStatus( h );
-
-	/* check for state change */
-	if( oldState != MSCAN_NS_BUS_OFF && 
-		newState == MSCAN_NS_BUS_OFF )
-		PutError( h, 0, MSCAN_BUSOFF_SET );
-
-	if( oldState == MSCAN_NS_BUS_OFF && 
-		newState != MSCAN_NS_BUS_OFF )
-		PutError( h, 0, MSCAN_BUSOFF_CLR );
+	MSCAN_TXCONF *ring = NULL, *old;
+	u_int32 ringSize = 0, alloc = 0, oldAlloc;
+	OSS_IRQ_STATE oldState;
 
-	if( oldState != MSCAN_NS_ERROR_PASSIVE && 
-		newState == MSCAN_NS_ERROR_PASSIVE )
-		PutError( h, 0, MSCAN_WARN_SET );
+	if( entries ){
+		for( ringSize=1; ringSize < entries; ringSize <<= 1 )
+			;
+		if( (ring = (MSCAN_TXCONF *)OSS_MemGet( 
+				 h->osHdl, ringSize * sizeof(MSCAN_TXCONF), &alloc )) 
+			== NULL )
+			return ERR_OSS_MEM_ALLOC;
+	}
 
-	if( oldState == MSCAN_NS_ERROR_PASSIVE && 
-		newState != MSCAN_NS_ERROR_PASSIVE )
-		PutError( h, 0, MSCAN_WARN_CLR );
+	/* exchange ring while ISR can't access it */
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	old		 = obj->txConf;
+	oldAlloc = obj->txConfAlloc;
+
+	obj->txConf		  = ring;
+	obj->txConfAlloc  = alloc;
+	obj->txConfMask	  = ringSize - 1;
+	obj->txConfIn	  = 0;
+	obj->txConfOut	  = 0;
+	obj->txConfLost	  = 0;
+	obj->txConfLostRd = 0;
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
 
+	if( old )
+		OSS_MemFree( h->osHdl, (int8 *)old, oldAlloc );
 
-	IDBGWRT_2((DBH," oldState=%d newState=%d\n", oldState, newState));
+	return 0;
+}
 
-	h->nodeStatus = newState;
+/**********************************************************************/
+/** Get frequency of receive timestamps in Hz
+ *
+ * \return frequency or 0 if unknown (ODIN: bit timing not yet set)
+ */
+static u_int32 MscanTsFreq( MSCAN_HANDLE *h )
+{
+#ifdef MSCAN_IS_ODIN
+	return h->bitRate;
+#else
+# ifdef MSCAN_TS_CYCLES
+	if( h->tsCycFreq )
+		return h->tsCycFreq;
+# endif
+	return MSCAN_TS_FREQ( h );
+#endif
 }
 
 /**********************************************************************/
-/** Determine node status (error active, warning, passive or bus off)
+/** Build Rx dispatch table from the local filters of all Rx objects
+ *
+ * Called whenever an Rx object has been configured or removed.
+ * The new table is built with interrupts enabled and then exchanged
+ * with the old one. If no memory is available, IrqRx falls back to 
+ * evaluating the filter of each Rx object.
  *
+ * Each object contributes its local filter or all patterns of its 
+ * filter rules.
+ *
+ * Objects that are not ready (left half-configured by a failed 
+ * MscanConfigMsg) are not entered, so their frames go to the next 
+ * matching object like in the fallback loop of IrqRx.
+ *
+ * Standard IDs: For each ID/RTR combination, the list of target
+ * objects is recorded (see RxStdTargets).
+ *
+ * Extended IDs: Filters are grouped into buckets of identical masks.
+ * Entries are linked into hash chains in ascending object order, so 
+ * the first hit within a bucket is the lowest numbered object.
  */
-static MSCAN_NODE_STATUS NodeStatus( MSCAN_HANDLE *h )
+static void BuildRxDispatch( MSCAN_HANDLE *h )
 {
-	u_int8 rflg = MSREAD( h->ma, MSCAN_RFLG );
-	MSCAN_NODE_STATUS nodeStatus;
+	MSCAN_RXDISP *disp=NULL, *old;
+	MSCAN_RXDISP_EXT *e;
+	const MSCAN_OBJFILTER *f;
+	MSG_OBJ *obj;
+	u_int16 *std;
+	u_int8 *tgt;
+	u_int32 nExt=0, nShared=0, hashSize=1, size, gotsize, tmpSize;
+	u_int32 tgtMax, tgtSize, i, k, b, care, hv;
+	int32 nr;
+	OSS_IRQ_STATE oldState;
 
-	/* 
-	 * following Bosch CAN Spec V2.0:
-	 * "a node is error passive when tx error count or rx error count >=128"
-	 * "a node is bus off when tx error count >= 256 
-	 */
-	if( (rflg & 0xc) == 0xc ){
-		/* bus off */
-		nodeStatus = MSCAN_NS_BUS_OFF;
+	/*--- count extended filters and shared objects ---*/
+	for( nr=h->firstRxObj; nr<=h->lastRxObj; nr++ ){
+		obj = &h->msgObj[nr];
+		if( (obj->q.dir != MSCAN_DIR_RCV) || !obj->q.ready )
+			continue;
+
+		if( obj->shared )
+			nShared++;
+
+		f = MSCAN_OBJ_FILTERS(obj);
+		for( k=0; k<MSCAN_OBJ_NFILTERS(obj); k++, f++ )
+			if( f->flagCode & MSCAN_EXTENDED )
+				nExt++;
 	}
-	else if( ((rflg & 0xc) == 0x8) || ((rflg & 0x30) == 0x20) ){
-		/* error passive */
-		nodeStatus = MSCAN_NS_ERROR_PASSIVE;
+
+	/*--- standard ID target lists (in temporary memory) ---*/
+	tgtMax = 1 + (2 + nShared) * 2 * MSCAN_NUM_STD_IDS;
+	if( tgtMax > MSCAN_RXDISP_TGTMAX )
+		tgtMax = MSCAN_RXDISP_TGTMAX;
+
+	if( (std = (u_int16 *)OSS_MemGet( h->osHdl, 
+									  sizeof(disp->std) + tgtMax, 
+									  &tmpSize )) == NULL ){
+		DBGWRT_ERR((DBH,"*** BuildRxDispatch: can't alloc table\n"));
+		goto EXCHANGE;
+	}
+	tgt = (u_int8 *)(std + 2*MSCAN_NUM_STD_IDS);
+
+	if( (tgtSize = RxStdTargets( h, std, tgt, tgtMax )) == 0 ){
+		DBGWRT_ERR((DBH,"*** BuildRxDispatch: too many target lists\n"));
+		goto EXCHANGE;
+	}
+
+	/*--- alloc table ---*/
+	while( hashSize < 2*nExt )
+		hashSize <<= 1;
+
+	size = sizeof(MSCAN_RXDISP) + 
+		nExt * (sizeof(MSCAN_RXDISP_EXT) + sizeof(MSCAN_RXDISP_BKT)) +
+		hashSize * sizeof(u_int16) + tgtSize;
+
+	if( nExt > 0xffff ){
+		/* exceeds 16 bit chain links */
+		DBGWRT_ERR((DBH,"*** BuildRxDispatch: too many ext filters\n"));
+	}
+	else if( (disp = (MSCAN_RXDISP *)OSS_MemGet( h->osHdl, size, &gotsize )) 
+		== NULL ){
+		DBGWRT_ERR((DBH,"*** BuildRxDispatch: can't alloc table\n"));
 	}
 	else {
-		/* error active */
-		nodeStatus = MSCAN_NS_ERROR_ACTIVE;
+		OSS_MemFill( h->osHdl, gotsize, (char *)disp, 0x00 );
+		disp->memAlloc = gotsize;
+		disp->hashMask = hashSize - 1;
+		disp->ext	   = (MSCAN_RXDISP_EXT *)(disp + 1);
+		disp->bkt	   = (MSCAN_RXDISP_BKT *)(disp->ext + nExt);
+		disp->hash	   = (u_int16 *)(disp->bkt + nExt);
+		disp->tgt	   = (u_int8 *)(disp->hash + hashSize);
+
+		/*--- standard IDs ---*/
+		OSS_MemCopy( h->osHdl, sizeof(disp->std), (char *)std, 
+					 (char *)disp->std );
+		OSS_MemCopy( h->osHdl, tgtSize, (char *)tgt, (char *)disp->tgt );
+
+		/*--- extended IDs (descending, chains built by head insert) ---*/
+		for( i=0, nr=h->lastRxObj; nr>=h->firstRxObj; nr-- ){
+			obj = &h->msgObj[nr];
+			if( (obj->q.dir != MSCAN_DIR_RCV) || !obj->q.ready )
+				continue;
+
+			f = MSCAN_OBJ_FILTERS(obj);
+			for( k=0; k<MSCAN_OBJ_NFILTERS(obj); k++, f++ ){
+				if( !(f->flagCode & MSCAN_EXTENDED) )
+					continue;
+
+				care = f->care;
+				for( b=0; b<disp->numBkt; b++ )
+					if( disp->bkt[b].care == care )
+						break;
+				if( b == disp->numBkt ){
+					if( b > 0xff ){
+						/* exceeds 8 bit bucket index */
+						DBGWRT_ERR((DBH,"*** BuildRxDispatch: too many "
+									"ext buckets\n"));
+						OSS_MemFree( h->osHdl, (int8 *)disp, gotsize );
+						disp = NULL;
+						goto EXCHANGE;
+					}
+					disp->bkt[disp->numBkt++].care = care;
+				}
+
+				e = &disp->ext[i];
+				e->code		= f->code;
+				e->bkt		= (u_int8)b;
+				e->nr		= (u_int8)nr;
+				e->rtrMask	= (u_int8)(f->flagMask & MSCAN_RTR);
+				e->rtrCode	= (u_int8)(f->flagCode & MSCAN_RTR);
+				e->shared	= (u_int8)(obj->shared ? 1 : 0);
+
+				hv = MSCAN_RXDISP_HASH( e->code, b ) & disp->hashMask;
+				e->next = disp->hash[hv];
+				disp->hash[hv] = (u_int16)++i;
+			}
+		}
+		DBGWRT_2((DBH, " BuildRxDispatch: %d ext filters in %d buckets, "
+				  "%d shared objs, %d bytes target lists\n",
+				  nExt, disp->numBkt, nShared, tgtSize ));
 	}
-	IDBGWRT_2((DBH," NodeStatus: rlfg=0x%02x node state=%d\n", 
-			   rflg, nodeStatus));
-	return nodeStatus;		
+
+ EXCHANGE:
+	if( std )
+		OSS_MemFree( h->osHdl, (int8 *)std, tmpSize );
+
+	/*--- exchange tables ---*/
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	old = h->rxDisp;
+	h->rxDisp = disp;
+	h->rxShared = nShared;
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	if( old )
+		OSS_MemFree( h->osHdl, (int8 *)old, old->memAlloc );
 }
 
 /**********************************************************************/
-/** Software filtering. Check if \a frm matches filter \fspec
+/** Build the standard ID target lists of the Rx dispatch table
  *
- * \param frm		frame to compare
- * \param fspec		filter specification (see struct doc)
- * \returns 0=no hit, 1 hit
+ * First the lowest matching object that is not shared is entered for
+ * each ID/RTR combination. Objects are entered in descending order, 
+ * each pattern only visits the IDs it covers. Then each entry is 
+ * replaced by the offset of its target list, which is completed by 
+ * the matching shared objects. Identical lists are stored once.
+ *
+ * \param std		receives list offsets by [RTR][ID]
+ * \param tgt		receives target lists
+ * \param tgtMax	size of \a tgt
+ * \returns size of lists in \a tgt, 0 if \a tgtMax exceeded
  */
-static int SwFilter( const MSCAN_FRAME *frm, const MSCAN_FILTER *fspec )
+static u_int32 RxStdTargets( 
+	MSCAN_HANDLE *h, 
+	u_int16 *std, 
+	u_int8 *tgt, 
+	u_int32 tgtMax )
 {
-	if( (frm->flags & MSCAN_EXTENDED) != (fspec->cflags & MSCAN_EXTENDED))
-		return 0;
+	const MSCAN_OBJFILTER *f;
+	MSG_OBJ *obj;
+	MSCAN_FRAME frm;
+	u_int8 lst[MSCAN_MAX_OBJS+2];
+	u_int32 used=1, last=0, off, n, i, k, x, dc, s;
+	int32 nr, rtr;
+
+	OSS_MemFill( h->osHdl, 2 * MSCAN_NUM_STD_IDS * sizeof(u_int16), 
+				 (char *)std, 0x00 );
+	tgt[0] = MSCAN_RXDISP_NONE;		/* empty list */
+
+	/*--- lowest non shared object (descending, lower ones overwrite) ---*/
+	for( nr=h->lastRxObj; nr>=h->firstRxObj; nr-- ){
+		obj = &h->msgObj[nr];
+		if( (obj->q.dir != MSCAN_DIR_RCV) || !obj->q.ready || 
+			obj->shared )
+			continue;
 
-	if( fspec->mflags & MSCAN_RTR ){
-		if( (fspec->cflags & MSCAN_RTR) != (frm->flags & MSCAN_RTR))
-			return 0;
+		f = MSCAN_OBJ_FILTERS(obj);
+		for( k=0; k<MSCAN_OBJ_NFILTERS(obj); k++, f++ ){
+			if( f->flagCode & MSCAN_EXTENDED )
+				continue;
+
+			/* enumerate all combinations of don't care bits */
+			dc = ~f->care & (MSCAN_NUM_STD_IDS-1);
+			s  = 0;
+			do {
+				frm.id = (f->code | s) & (MSCAN_NUM_STD_IDS-1);
+
+				for( rtr=0; rtr<2; rtr++ ){
+					frm.flags = rtr ? MSCAN_RTR : 0;
+					if( SwFilter( h, &frm, f ))
+						std[rtr * MSCAN_NUM_STD_IDS + frm.id] = (u_int16)nr;
+				}
+				s = (s - dc) & dc;
+			} while( s );
+		}
 	}
 
-	if( (fspec->code & ~fspec->mask) != (frm->id & ~fspec->mask) )
-		return 0;
+	/*--- replace objects by target lists ---*/
+	for( i=0; i<2*MSCAN_NUM_STD_IDS; i++ ){
+		frm.id	  = i & (MSCAN_NUM_STD_IDS-1);
+		frm.flags = (i >= MSCAN_NUM_STD_IDS) ? MSCAN_RTR : 0;
 
-	/* individual filter */
-	if( (fspec->mflags & MSCAN_USE_ACCFIELD) &&
-		! MSCAN_ACCFIELD_GET( fspec->accField, frm->id ))
-		return 0;
+		n = 0;
+		if( std[i] != MSCAN_RXDISP_NONE )
+			lst[n++] = (u_int8)std[i];
 
-	return 1;
+		for( nr=h->firstRxObj; nr<=h->lastRxObj; nr++ ){
+			obj = &h->msgObj[nr];
+			if( (obj->q.dir == MSCAN_DIR_RCV) && obj->q.ready && 
+				obj->shared && ObjMatch( h, obj, &frm ))
+				lst[n++] = (u_int8)nr;
+		}
+
+		if( n == 0 )
+			continue;
+		lst[n++] = MSCAN_RXDISP_NONE;
+
+		/* most likely same list as previous ID, else search all lists */
+		for( off=last, x=1; ; ){
+			for( k=0; (k < n) && (tgt[off+k] == lst[k]); k++ )
+				;
+			if( k == n )
+				break;			/* found */
+
+			if( x >= used ){
+				/* append new list */
+				if( used + n > tgtMax )
+					return 0;
+				OSS_MemCopy( h->osHdl, n, (char *)lst, (char *)&tgt[used] );
+				off	  = used;
+				used += n;
+				break;
+			}
+
+			off = x;
+			while( tgt[x++] != MSCAN_RXDISP_NONE )
+				;
+		}
+		std[i] = (u_int16)off;
+		last   = off;
+	}
+	return used;
+}
+
+/**********************************************************************/
+/** Find the target Rx objects of a frame in the Rx dispatch table
+ *
+ * The list contains the lowest matching object that is not shared
+ * and all matching shared objects. For extended IDs, the list is 
+ * built in h->rxTgt.
+ *
+ * \param disp		dispatch table built by BuildRxDispatch
+ * \param frm		received frame
+ * \returns list of object numbers, terminated by MSCAN_RXDISP_NONE
+ */
+static const u_int8 *RxDispatch( 
+	MSCAN_HANDLE *h, 
+	const MSCAN_RXDISP *disp, 
+	const MSCAN_FRAME *frm )
+{
+	const MSCAN_RXDISP_EXT *e;
+	u_int8 *tgt = h->rxTgt;
+	u_int32 b, key, idx, n=1, k;
+	int nr = MSCAN_RXDISP_NONE;
+
+	if( !(frm->flags & MSCAN_EXTENDED) )
+		return &disp->tgt[disp->std[(frm->flags & MSCAN_RTR) ? 1 : 0]
+						  [frm->id & (MSCAN_NUM_STD_IDS-1)]];
+
+	/* tgt[0] is reserved for the non shared object */
+	for( b=0; b<disp->numBkt; b++ ){
+		key = frm->id & disp->bkt[b].care;
+		idx = disp->hash[MSCAN_RXDISP_HASH( key, b ) & disp->hashMask];
+
+		while( idx ){
+			e = &disp->ext[idx-1];
+
+			if( (e->bkt == b) && (e->code == key) &&
+				((frm->flags & e->rtrMask) == e->rtrCode) ){
+
+				if( e->shared ){
+					/* object may match with several patterns */
+					for( k=1; (k < n) && (tgt[k] != e->nr); k++ )
+						;
+					if( k == n )
+						tgt[n++] = e->nr;
+				}
+				else {
+					/* first hit in chain is lowest object of this bucket */
+					if( (nr == MSCAN_RXDISP_NONE) || (e->nr < nr) )
+						nr = e->nr;
+					if( h->rxShared == 0 )
+						break;
+				}
+			}
+			idx = e->next;
+		}
+	}
+	tgt[n] = MSCAN_RXDISP_NONE;
+
+	if( nr == MSCAN_RXDISP_NONE )
+		return tgt + 1;
+
+	tgt[0] = (u_int8)nr;
+	return tgt;
 }
 
 /**********************************************************************/
-/** Wait for entry from rx FIFO (either CAN rx or error object)
+/** Wait for entries in rx FIFO (either CAN rx or error object)
  *
  * When this function returns without error, caller must get the 
- * frame from FIFO and update FIFO counter and pointer
+ * frame(s) from FIFO and then advance the FIFO's output counter.
  *
- * \param nr		message object number
- * \param timeout	-1=don't wait, 0=wait forever, >0=tout in ms
+ * The FIFO is a single producer (ISR) / single consumer (caller, 
+ * serialized by the device semaphore) ring, so no irq masking
+ * is required.
+ *
+ * \param nr			message object number
+ * \param minEntries	number of entries to wait for 
+ *						(1..totEntries of the FIFO)
+ * \param timeout		-1=don't wait, 0=wait forever, >0=tout in ms
  * \returns error code
  */
 static int WaitRxFifoEntry( 
 	MSCAN_HANDLE *h,
-	int nr,
+	u_int32 nr,
+	u_int32 minEntries,
 	int32 timeout)
 {
 	MSG_OBJ *obj = &h->msgObj[nr];
 	int32 error = 0;
 
-	if( nr >= MSCAN_NUM_OBJS )
+	if( nr >= h->numObjs )
 		return MSCAN_ERR_BADMSGNUM;
 
 	if( obj->q.dir != MSCAN_DIR_RCV )
@@ -1991,47 +5250,298 @@ static int WaitRxFifoEntry(
     /*--------------------------+
 	|  Check for frames in FIFO |
 	+--------------------------*/
-	if( obj->q.filled == 0 ){
+	while( MQUEUE_FILLED( &obj->q ) < minEntries ){
 
-		DBGWRT_2((DBH, " FIFO empty\n"));
+		DBGWRT_2((DBH, " FIFO has %d of %d entries\n", 
+				  MQUEUE_FILLED( &obj->q ), minEntries ));
 
-		/*--- FIFO empty ---*/
+		/*--- not enough entries ---*/
 		if( timeout == -1 ){
 			return MSCAN_ERR_NOMESSAGE;
 		}
 
-		while( error == 0 ){
-			obj->q.waiting = TRUE;	/* flag we're waiting for sem */
+		obj->q.wakeLevel = minEntries;
+		obj->q.waiting = TRUE;	/* flag we're waiting for sem */
+		MSCAN_MEMBAR();
+
+		/* ISR may have put an entry before it saw the flag */
+		if( MQUEUE_FILLED( &obj->q ) >= minEntries ){
+			obj->q.waiting = FALSE;
+			break;
+		}
 
-			DEVSEM_UNLOCK( h );
+		DEVSEM_UNLOCK( h );
 
-			/* wait for FIFO entries */
-			error = OSS_SemWait( h->osHdl, obj->q.sem, 
-								 timeout==0 ? 
-								 OSS_SEM_WAITFOREVER : timeout );
+		/* wait for FIFO entries */
+		error = OSS_SemWait( h->osHdl, obj->q.sem, 
+							 timeout==0 ? 
+							 OSS_SEM_WAITFOREVER : timeout );
 
-			DEVSEM_LOCK( h );
+		DEVSEM_LOCK( h );
 
+		if( error ){
+			obj->q.waiting = FALSE;
+			MSCAN_MEMBAR();
 
-			if( obj->q.waiting == FALSE ){
-				/*
-				 * got an rx message
-				 */
+			if( MQUEUE_FILLED( &obj->q ) >= minEntries ){
+				error = 0;		/* entry arrived together with timeout */
 				break;
 			}
-			else if( error ){
-				obj->q.waiting = FALSE;
-				DBGWRT_ERR((DBH,"*** MscanReadMsg: error 0x%x waiting for "
-							"FIFO\n", error ));
+
+			DBGWRT_ERR((DBH,"*** MscanReadMsg: error 0x%x waiting for "
+						"FIFO\n", error ));
+			return error;
+		}
+		/* re-check FIFO, wakeup may be from an earlier signal */
+	}
+
+	MSCAN_MEMBAR();				/* read entry after nxtIn */
+	return 0;
+}
+
+/**********************************************************************/
+/** Copy frames from rx/tx queue to linear buffer
+ *
+ * Copies \a n frames beginning at the queue's output counter in at
+ * most two runs (wrap-around). Does not advance the output counter.
+ *
+ * \param	h		LL handle
+ * \param	q		queue header
+ * \param	dst		destination buffer
+ * \param	n		number of frames (must be <= filled entries)
+ */ 
+static void QueueCopyOut( 
+	MSCAN_HANDLE *h, 
+	const MQUEUE_HEAD *q, 
+	MSCAN_FRAME *dst, 
+	u_int32 n )
+{
+	u_int32 idx = q->nxtOut & q->ringMask;
+	u_int32 run = q->ringMask + 1 - idx;
+
+	if( run > n )
+		run = n;
+
+	OSS_MemCopy( h->osHdl, run * sizeof(MSCAN_FRAME), 
+				 (char *)&q->ent.frm[idx], (char *)dst );
+	if( n > run )
+		OSS_MemCopy( h->osHdl, (n - run) * sizeof(MSCAN_FRAME), 
+					 (char *)q->ent.frm, (char *)(dst + run) );
+}
+
+/**********************************************************************/
+/** Copy frames from linear buffer into rx/tx queue
+ *
+ * Copies \a n frames to the queue's input counter in at most two runs 
+ * (wrap-around). Does not advance the input counter.
+ *
+ * \param	h		LL handle
+ * \param	q		queue header
+ * \param	src		source buffer
+ * \param	n		number of frames (must be <= free entries)
+ */ 
+static void QueueCopyIn( 
+	MSCAN_HANDLE *h, 
+	MQUEUE_HEAD *q, 
+	const MSCAN_FRAME *src, 
+	u_int32 n )
+{
+	u_int32 idx = q->nxtIn & q->ringMask;
+	u_int32 run = q->ringMask + 1 - idx;
+
+	if( run > n )
+		run = n;
+
+	OSS_MemCopy( h->osHdl, run * sizeof(MSCAN_FRAME), 
+				 (char *)src, (char *)&q->ent.frm[idx] );
+	if( n > run )
+		OSS_MemCopy( h->osHdl, (n - run) * sizeof(MSCAN_FRAME), 
+					 (char *)(src + run), (char *)q->ent.frm );
+}
+
+/**********************************************************************/
+/** Get frames from rx queue (reader side)
+ *
+ * \param	h		LL handle
+ * \param	obj		message object (configured for Rx)
+ * \param	dst		destination buffer
+ * \param	dstTs	if non-NULL, copy frames with timestamps here 
+ *					instead of \a dst
+ * \param	max		max. number of frames to get
+ * \return	number of frames copied
+ */ 
+static u_int32 QueueGetFrames( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	MSCAN_FRAME *dst, 
+	MSCAN_FRAME_TS *dstTs,
+	u_int32 max )
+{
+	MQUEUE_HEAD *q = &obj->q;
+	u_int32 n = MQUEUE_FILLED( q ), i, idx;
+
+	if( n > max )
+		n = max;
+
+	DBGWRT_2((DBH, " dequeue %d frames\n", n ));
+
+	MSCAN_MEMBAR();				/* read entries after nxtIn */
+	if( dstTs ){
+		for( i=0; i<n; i++, dstTs++ ){
+			idx = (q->nxtOut + i) & q->ringMask;
+			dstTs->frm	  = q->ent.frm[idx];
+			dstTs->tsHigh = q->ts ? q->ts[idx].high : 0;
+			dstTs->tsLow  = q->ts ? q->ts[idx].low : 0;
+		}
+	}
+	else
+		QueueCopyOut( h, q, dst, n );
+	MSCAN_MEMBAR();				/* release entries to ISR */
+
+	obj->q.nxtOut += n;
+	obj->q.errSent = FALSE;
+
+	return n;
+}
+
+/**********************************************************************/
+/** Put frames into tx queue (writer side) and kick transmission
+ *
+ * \param	h		LL handle
+ * \param	obj		message object (configured for Tx)
+ * \param	src		source buffer
+ * \param	max		max. number of frames to put
+ * \param	lifetime	OS ticks until frames are dropped (0=never)
+ * \return	number of frames put into queue
+ */ 
+static u_int32 QueuePutFrames( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	const MSCAN_FRAME *src, 
+	u_int32 max,
+	u_int32 lifetime )
+{
+	u_int32 n = obj->q.totEntries - MQUEUE_FILLED( &obj->q );
+	OSS_IRQ_STATE oldState;
+
+	if( obj->txSlot )
+		return MboxPutFrames( h, obj, src, max, lifetime );
+
+	if( n > max )
+		n = max;
+
+	DBGWRT_2((DBH, " enqueue %d frames\n", n ));
+
+	if( n == 0 )
+		return 0;
+
+	MSCAN_MEMBAR();				/* write entries after nxtOut */
+	QueueCopyIn( h, &obj->q, src, n );
+
+	if( obj->q.txMeta ){
+		u_int32 i, tick = OSS_TickGet( h->osHdl );
+
+		for( i=0; i<n; i++ ){
+			MQUEUE_TXMETA *meta = 
+				&obj->q.txMeta[(obj->q.nxtIn + i) & obj->q.ringMask];
+
+			meta->enqTick  = tick;
+			meta->lifetime = lifetime;
+		}
+	}
+	MSCAN_MEMBAR();				/* publish entries to ISR */
+
+	obj->q.nxtIn += n;
+
+	/* enable all tx interrupts (TIER is modified by ISR too) */
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
+	TxPreemptCheck( h );
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return n;
+}
+
+/**********************************************************************/
+/** Put frames into tx mailbox object and kick transmission
+ *
+ * For each frame, looks up the slot bound to the frame's ID (or binds
+ * a free one). If the previous frame of that ID is still in the FIFO,
+ * it is replaced by the new frame, otherwise the frame is appended.
+ * Since each ID has at most one entry, the FIFO never overflows.
+ *
+ * The whole update runs with irqs masked, because the ISR may take the
+ * entry being overwritten.
+ *
+ * \param	h		LL handle
+ * \param	obj		message object (tx mailbox)
+ * \param	src		source buffer
+ * \param	max		number of frames to put
+ * \param	lifetime	OS ticks until frames are dropped (0=never)
+ * \return	number of frames put (less than \a max if no free slot)
+ */ 
+static u_int32 MboxPutFrames( 
+	MSCAN_HANDLE *h, 
+	MSG_OBJ *obj, 
+	const MSCAN_FRAME *src, 
+	u_int32 max,
+	u_int32 lifetime )
+{
+	MQUEUE_HEAD *q = &obj->q;
+	MSCAN_TXSLOT *slot;
+	OSS_IRQ_STATE oldState;
+	u_int32 n, i, idx, tick = OSS_TickGet( h->osHdl );
+	u_int8 key;
+
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+
+	for( n=0; n<max; n++, src++ ){
+		key = src->flags & (MSCAN_EXTENDED | MSCAN_RTR);
+
+		for( i=0, slot=obj->txSlot; i<obj->txSlotNum; i++, slot++ )
+			if( slot->id == src->id && slot->flags == key )
+				break;
+
+		if( i == obj->txSlotNum ){
+			/* new ID */
+			if( i == q->totEntries ){
+				DBGWRT_ERR((DBH,"*** MboxPutFrames: no slot for ID 0x%x\n",
+							src->id ));
 				break;
 			}
+			slot->id	= src->id;
+			slot->flags = key;
+			slot->seq	= q->nxtOut - 1;	/* no entry in FIFO */
+			obj->txSlotNum++;
+		}
+
+		if( slot->seq - q->nxtOut < MQUEUE_FILLED( q ) ){
+			/* frame of ID not yet sent: replace */
+			idx = slot->seq & q->ringMask;
+		}
+		else {
+			idx = q->nxtIn & q->ringMask;
+			slot->seq = q->nxtIn;
+		}
+
+		q->ent.frm[idx]				= *src;
+		q->txMeta[idx].enqTick		= tick;
+		q->txMeta[idx].lifetime		= lifetime;
+
+		if( slot->seq == q->nxtIn ){
+			MSCAN_MEMBAR();
+			q->nxtIn++;
+		}
+	}
+
+	DBGWRT_2((DBH, " mailbox: put %d frames\n", n ));
+
+	/* enable all tx interrupts */
+	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
+	TxPreemptCheck( h );
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
 
-			/* no error, but no rx msg arrived, continue waiting */
-		}
-			
-	}
-	
-	return error;
+	return n;
 }
 
 /**********************************************************************/
@@ -2051,14 +5561,17 @@ static void PutError( MSCAN_HANDLE *h, int nr, MSCAN_ERRENTRY_CODE code )
 		return;					/* no error object created */
 
 	/* put the error into the error FIFO */
-	if( obj->q.filled == obj->q.totEntries ){
+	if( MQUEUE_FILLED( &obj->q ) == obj->q.totEntries ){
 		IDBGWRT_ERR((DBH, "*** MSCAN error obj overrun\n", nr));
 	}
 	else {
-		obj->q.nxtIn->d.err.errCode = code;
-		obj->q.nxtIn->d.err.objNr	= nr;
-		obj->q.filled++;
-		obj->q.nxtIn = obj->q.nxtIn->next;
+		MQUEUE_ERR_IN( &obj->q )->errCode = code;
+		MQUEUE_ERR_IN( &obj->q )->objNr	  = nr;
+		MSCAN_MEMBAR();			/* publish entry to reader */
+		obj->q.nxtIn++;
+		MSCAN_MEMBAR();			/* nxtIn visible before checking waiter */
+
+		MSCAN_WAIT_WAKE( h, h->waitRx, 0 );
 
 		/* wakeup read waiter */
 		if( obj->q.waiting ){
@@ -2076,6 +5589,14 @@ static void PutError( MSCAN_HANDLE *h, int nr, MSCAN_ERRENTRY_CODE code )
 
 /**********************************************************************/
 /** Reset queue of message object
+ *
+ * With \a txabort, an abort request is issued for all tx buffers
+ * of the object (TARQ). The ISR sees the buffers complete, records
+ * the frames that were really aborted (TAAK) in \em txAborted and 
+ * clears \em txAborting when the last buffer is done. A frame in the 
+ * hold slot is recorded as aborted immediately.
+ *
+ * Must be called with irqs masked.
  *
  * \param	h		LL handle
  * \param	nr		msg obj number
@@ -2089,18 +5610,51 @@ static int32 QueueClear( MSCAN_HANDLE *h, u_int32 nr, u_int32 txabort )
 
 	DBGWRT_2((DBH,"  QueueClear: nr=%d txabort=%d\n", nr, txabort ));
 
-	if( nr >= MSCAN_NUM_OBJS )
+	if( nr >= h->numObjs )
 		return MSCAN_ERR_BADMSGNUM;
 
-#if 0
-	/*???*/
-	if( txabort && obj->q.dir == CPL_DIR_XMT )
-		_MSCAN_transmit_abort( llHdl, nr );
-#endif
+	if( txabort && obj->q.dir == MSCAN_DIR_XMT ){
+		obj->txAbortedCnt = 0;
+
+		if( obj->txHoldValid ){
+			obj->txAborted[0]	 = obj->txHold;
+			obj->txAbortedSeq[0] = obj->txHoldSeq;
+			obj->txAbortedCnt	 = 1;
+		}
+
+		if( obj->txbUsed ){
+			DBGWRT_2((DBH,"  abort tx bufs 0x%x\n", obj->txbUsed ));
+			h->txAbort		|= obj->txbUsed;
+			obj->txAborting = TRUE;
+			MSWRITE( h->ma, MSCAN_TARQ, obj->txbUsed );
+		}
+	}
+	obj->txHoldValid  = FALSE;
+	obj->txPreempting = FALSE;
+	obj->txSlotNum	  = 0;
+
+	if( obj->rxSlot ){
+		/* unbind all rx mailbox slots */
+		obj->rxSlotNum	= 0;
+		obj->rxSlotScan = 0;
+		OSS_MemFill( h->osHdl, (obj->rxHashMask + 1 + 
+								(obj->q.totEntries + 31) / 32) * 
+					 sizeof(u_int32), (char *)obj->rxHash, 0 );
+	}
+
+	if( obj->rxRing ){
+		obj->rxRing->nxtIn	= 0;
+		obj->rxRing->nxtOut = 0;
+	}
+	if( obj->txRing ){
+		obj->txRing->nxtIn	= 0;
+		obj->txRing->nxtOut = 0;
+	}
+
 	/*--- init queue pointers ---*/
-	obj->q.nxtIn 	= obj->q.first;
-	obj->q.nxtOut 	= obj->q.first;
-	obj->q.filled	= 0;
+	obj->q.nxtIn 	= 0;
+	obj->q.nxtOut 	= 0;
+	obj->q.wakeLevel= 1;
 	obj->q.errSent  = 0;
 	obj->q.ready	= TRUE;
 
@@ -2120,30 +5674,22 @@ static void SetFilter( MSCAN_HANDLE *h, int fltNum, const MSCAN_FILTER *fspec )
 {
 	MACCESS ma = h->ma;
 	u_int32 id;
-	static const int mreg[] = {
-		MSCAN_IDMR0, MSCAN_IDMR1, MSCAN_IDMR2, MSCAN_IDMR3, 
-		MSCAN_IDMR4, MSCAN_IDMR5, MSCAN_IDMR6, MSCAN_IDMR7 
-	};
-	static const int areg[] = {
-		MSCAN_IDAR0, MSCAN_IDAR1, MSCAN_IDAR2, MSCAN_IDAR3, 
-		MSCAN_IDAR4, MSCAN_IDAR5, MSCAN_IDAR6, MSCAN_IDAR7 
-	};
 	const int *ar, *mr;
 
 	if( fltNum == 0 ){
-		ar = &areg[0];
-		mr = &mreg[0];
+		ar = &idarReg[0];
+		mr = &idmrReg[0];
 	}
 	else {
-		ar = &areg[4];
-		mr = &mreg[4];
+		ar = &idarReg[4];
+		mr = &idmrReg[4];
 	}
 
 	/*
 	 * Filter config:
 	 * IDAM=0	- 2*32 bit acceptance filters
 	 */
-	MSWRITE( ma, MSCAN_IDAC, 0x00 );
+	MSWRITE( ma, MSCAN_IDAC, MSCAN_IDAC_2X32 );
 
 	if( fspec->cflags & MSCAN_EXTENDED ){
 
@@ -2186,6 +5732,708 @@ static void SetFilter( MSCAN_HANDLE *h, int fltNum, const MSCAN_FILTER *fspec )
 
 
 
+/**********************************************************************/
+/** Compile hw filters in the given mode or select the best mode
+ *
+ * With MSCAN_HWFILT_AUTO, all modes are compiled and the one with the
+ * fewest falsely accepted IDs is used. Standard IDs are weighted by
+ * the ratio of the ID spaces, so a falsely accepted standard ID costs
+ * as much as 2^18 extended IDs.
+ *
+ * \param in		wanted IDs, see HwFiltCompile
+ * \param nIn		number of entries in \a in
+ * \param stdWanted	number of wanted standard IDs
+ * \param extWanted	number of wanted extended IDs
+ * \param mode		MSCAN_HWFILT_2X32..8X8 or MSCAN_HWFILT_AUTO
+ * \param best		out: compiled filters and acceptance info
+ */
+static void HwFiltSelect(
+	const MSCAN_HWFILT_ITEM *in,
+	u_int32 nIn,
+	u_int32 stdWanted,
+	u_int32 extWanted,
+	u_int32 mode,
+	MSCAN_HWFILT *best )
+{
+	MSCAN_HWFILT hf;
+	MSCAN_HWFILT_INFO *info = &hf.info;
+	u_int32 m, cost, bestCost = 0xffffffff, acc, wanted;
+
+	for( m=MSCAN_HWFILT_2X32; m<=MSCAN_HWFILT_8X8; m++ ){
+		if( (mode != MSCAN_HWFILT_AUTO) && (mode != m) )
+			continue;
+
+		HwFiltCompile( in, nIn, m, &hf );
+
+		/* wanted counts of overlapping patterns may be too high */
+		info->stdWanted = (stdWanted < info->stdAccepted) ? 
+			stdWanted : info->stdAccepted;
+		info->extWanted = (extWanted < info->extAccepted) ? 
+			extWanted : info->extAccepted;
+
+		/* scale down to avoid overflow of wanted * 1000 */
+		acc 	= info->stdAccepted + info->extAccepted;
+		wanted 	= info->stdWanted + info->extWanted;
+		while( acc > 0x3fffff ){
+			acc >>= 1;
+			wanted >>= 1;
+		}
+		info->precision = acc ? (wanted * 1000) / acc : 1000;
+
+		cost = ((info->stdAccepted - info->stdWanted) << 
+				MSCAN_HWFILT_STDWEIGHT) +
+			(info->extAccepted - info->extWanted);
+
+		if( cost < bestCost ){
+			bestCost = cost;
+			*best = hf;
+		}
+	}
+}
+
+/**********************************************************************/
+/** Compile wanted IDs into the hw filters of one mode
+ *
+ * Each interval is first covered by one code/mask pair: the smallest
+ * aligned block of IDs that contains it. If the mode has spare
+ * filters, the interval whose cover wastes most IDs is split into two
+ * halves, each covered separately. If there are more entries than
+ * filters, the pair of filters whose combination adds the fewest IDs
+ * is merged, until the filters fit.
+ *
+ * The work is done in the ID space of the mode, i.e. on the ID bits
+ * the hardware compares (see hwFiltGeo). In 8x8 mode, a filter only
+ * sees the upper 8 bits of the ID, so it accepts both standard and
+ * extended frames.
+ *
+ * \param in		wanted IDs (full ID space): intervals lo..hi, or
+ *					code/care patterns if \em fixed is set
+ * \param nIn		number of entries in \a in (max. 
+ *					MSCAN_FILTER_MAXRANGES)
+ * \param mode		MSCAN_HWFILT_2X32..MSCAN_HWFILT_8X8
+ * \param hf		out: compiled filters and accepted IDs
+ */
+static void HwFiltCompile(
+	const MSCAN_HWFILT_ITEM *in,
+	u_int32 nIn,
+	u_int32 mode,
+	MSCAN_HWFILT *hf )
+{
+	const MSCAN_HWFILT_GEO *geo = &hwFiltGeo[mode];
+	MSCAN_HWFILT_ITEM it[MSCAN_FILTER_MAXRANGES], lo, hi, m, bestM;
+	MSCAN_HWFILT_INFO *info = &hf->info;
+	u_int32 n, i, j, sh, gain, bestGain, bestI=0, bestJ=0, u;
+	int32 added, bestAdded;
+
+	/*--- one filter per entry, in the mode's ID space ---*/
+	for( n=0; n<nIn; n++ ){
+		it[n] = in[n];
+		sh = geo->shift[it[n].ext];
+
+		if( it[n].fixed ){
+			it[n].code >>= sh;
+			it[n].care >>= sh;
+		}
+		else {
+			it[n].lo >>= sh;
+			it[n].hi >>= sh;
+			HwFiltCover( &it[n], geo->bits[it[n].ext] );
+		}
+	}
+
+	/*--- spare filters: split interval whose cover wastes most IDs ---*/
+	while( n < geo->num ){
+		bestGain = 0;
+
+		for( i=0; i<n; i++ ){
+			if( it[i].fixed || (it[i].lo == it[i].hi) )
+				continue;
+
+			HwFiltSplit( &it[i], geo->bits[it[i].ext], &lo, &hi );
+			gain = HwFiltCost( geo, &it[i] ) - HwFiltCost( geo, &lo ) - 
+				HwFiltCost( geo, &hi );
+
+			if( gain > bestGain ){
+				bestGain = gain;
+				bestI = i;
+			}
+		}
+		if( bestGain == 0 )
+			break;				/* all intervals exactly covered */
+
+		HwFiltSplit( &it[bestI], geo->bits[it[bestI].ext], &lo, &hi );
+		it[bestI] = lo;
+		it[n++] = hi;
+	}
+
+	/*--- too many entries: merge pair that adds fewest IDs ---*/
+	while( n > geo->num ){
+		bestAdded = 0x7fffffff;
+
+		for( i=0; i<n; i++ ){
+			for( j=i+1; j<n; j++ ){
+				if( !geo->mixed && (it[i].ext != it[j].ext) )
+					continue;
+
+				HwFiltMerge( &it[i], &it[j], &m );
+				added = (int32)HwFiltCost( geo, &m ) - 
+					(int32)HwFiltCost( geo, &it[i] ) - 
+					(int32)HwFiltCost( geo, &it[j] );
+
+				if( added < bestAdded ){
+					bestAdded = added;
+					bestM = m;
+					bestJ = j;
+					bestI = i;
+				}
+			}
+		}
+		it[bestI] = bestM;
+		it[bestJ] = it[--n];
+	}
+
+	hf->num = n;
+	for( i=0; i<n; i++ )
+		hf->flt[i] = it[i];
+
+	/*--- IDs accepted by resulting filters ---*/
+	info->mode = n ? mode : MSCAN_HWFILT_CLOSED;
+
+	if( geo->mixed ){
+		u = HwFiltUnion( it, n, -1, geo->bits[0] );
+		info->stdAccepted = u << geo->shift[0];
+		info->extAccepted = u << geo->shift[1];
+	}
+	else {
+		info->stdAccepted = HwFiltUnion( it, n, 0, geo->bits[0] ) << 
+			geo->shift[0];
+		info->extAccepted = HwFiltUnion( it, n, 1, geo->bits[1] ) << 
+			geo->shift[1];
+	}
+}
+
+/**********************************************************************/
+/** Merge two filters into one that accepts the IDs of both
+ *
+ * Only bits compared by both filters and equal in both codes remain
+ * compared. \a m may point to \a a.
+ */
+static void HwFiltMerge(
+	const MSCAN_HWFILT_ITEM *a,
+	const MSCAN_HWFILT_ITEM *b,
+	MSCAN_HWFILT_ITEM *m )
+{
+	u_int32 care = a->care & b->care & ~(a->code ^ b->code);
+
+	*m = *a;
+	m->care  = care;
+	m->code  = a->code & care;
+	m->fixed = TRUE;
+}
+
+/**********************************************************************/
+/** Set code/mask of filter to smallest aligned block containing lo..hi
+ *
+ * \param it		filter, lo/hi must be set
+ * \param bits		width of ID space
+ */
+static void HwFiltCover( MSCAN_HWFILT_ITEM *it, u_int32 bits )
+{
+	u_int32 diff = it->lo ^ it->hi, span = 0;
+
+	/* span: all bits up to highest bit where lo and hi differ */
+	while( diff ){
+		span = (span << 1) | 1;
+		diff >>= 1;
+	}
+	it->care = (((u_int32)1 << bits) - 1) & ~span;
+	it->code = it->lo & it->care;
+}
+
+/**********************************************************************/
+/** Split interval of filter \a it at its highest differing bit
+ *
+ * \param it		filter to split (lo != hi, not merged)
+ * \param bits		width of ID space
+ * \param lo		out: filter for lower half
+ * \param hi		out: filter for upper half
+ */
+static void HwFiltSplit(
+	const MSCAN_HWFILT_ITEM *it,
+	u_int32 bits,
+	MSCAN_HWFILT_ITEM *lo,
+	MSCAN_HWFILT_ITEM *hi )
+{
+	/* lowest ID of upper half: upper bits of hi, lower bits cleared */
+	u_int32 half = ((~it->care & (((u_int32)1 << bits) - 1)) + 1) >> 1;
+	u_int32 mid = it->hi & ~(half - 1);
+
+	*lo = *hi = *it;
+	lo->hi = mid - 1;
+	hi->lo = mid;
+	HwFiltCover( lo, bits );
+	HwFiltCover( hi, bits );
+}
+
+/**********************************************************************/
+/** Weighted number of IDs accepted by a single filter
+ *
+ * Standard IDs count 2^MSCAN_HWFILT_STDWEIGHT, so the whole standard
+ * and extended ID spaces have the same weight.
+ *
+ * \param geo		mode geometry
+ * \param it		filter
+ * \return weighted IDs (max. 2^30)
+ */
+static u_int32 HwFiltCost(
+	const MSCAN_HWFILT_GEO *geo,
+	const MSCAN_HWFILT_ITEM *it )
+{
+	u_int32 size = (u_int32)1 << (geo->bits[it->ext] - BitCount( it->care ));
+
+	if( geo->mixed )
+		return (size << (geo->shift[0] + MSCAN_HWFILT_STDWEIGHT)) + 
+			(size << geo->shift[1]);
+
+	if( it->ext )
+		return size << geo->shift[1];
+
+	return size << (geo->shift[0] + MSCAN_HWFILT_STDWEIGHT);
+}
+
+/**********************************************************************/
+/** Number of IDs accepted by any of the filters
+ *
+ * \param flt		filters
+ * \param num		number of entries in \a flt
+ * \param ext		count filters for std (0) or ext (1) IDs, -1=all
+ * \param bits		width of ID space
+ * \return number of IDs in the ID space of the mode
+ */
+static u_int32 HwFiltUnion(
+	const MSCAN_HWFILT_ITEM *flt,
+	u_int32 num,
+	int ext,
+	u_int32 bits )
+{
+	const MSCAN_HWFILT_ITEM *a = NULL, *b = NULL;
+	u_int32 i, id, cnt = 0;
+
+	if( bits <= 14 ){
+		/* small ID space, test each ID */
+		for( id=0; id < ((u_int32)1 << bits); id++ ){
+			for( i=0; i<num; i++ ){
+				if( ((ext < 0) || (flt[i].ext == ext)) &&
+					((id & flt[i].care) == flt[i].code) ){
+					cnt++;
+					break;
+				}
+			}
+		}
+		return cnt;
+	}
+
+	/* 29 bit IDs only in 2x32 mode, i.e. max. two filters */
+	for( i=0; i<num; i++ ){
+		if( (ext >= 0) && (flt[i].ext != ext) )
+			continue;
+
+		cnt += (u_int32)1 << (bits - BitCount( flt[i].care ));
+		if( a == NULL )
+			a = &flt[i];
+		else
+			b = &flt[i];
+	}
+
+	/* subtract IDs accepted by both */
+	if( b && !((a->code ^ b->code) & a->care & b->care) )
+		cnt -= (u_int32)1 << (bits - BitCount( a->care | b->care ));
+
+	return cnt;
+}
+
+/**********************************************************************/
+/** Number of distinct IDs in the ranges of one ID type
+ *
+ * \param rng		ID ranges
+ * \param nRanges	number of entries in \a rng
+ * \param ext		count standard (0) or extended (1) ranges
+ */
+static u_int32 HwFiltWanted(
+	const MSCAN_IDRANGE *rng,
+	u_int32 nRanges,
+	int ext )
+{
+	u_int32 first[MSCAN_FILTER_MAXRANGES], last[MSCAN_FILTER_MAXRANGES];
+	u_int32 i, j, n = 0, cnt = 0, nxt = 0, f;
+
+	/* sort ranges by first ID */
+	for( i=0; i<nRanges; i++ ){
+		if( ((rng[i].flags & MSCAN_EXTENDED) ? 1 : 0) != ext )
+			continue;
+
+		for( j=n; (j > 0) && (first[j-1] > rng[i].first); j-- ){
+			first[j] = first[j-1];
+			last[j]  = last[j-1];
+		}
+		first[j] = rng[i].first;
+		last[j]  = rng[i].last;
+		n++;
+	}
+
+	/* count IDs not counted by a previous range */
+	for( i=0; i<n; i++ ){
+		f = (first[i] > nxt) ? first[i] : nxt;
+		if( last[i] >= f ){
+			cnt += last[i] - f + 1;
+			nxt = last[i] + 1;
+		}
+	}
+	return cnt;
+}
+
+/**********************************************************************/
+/** Write compiled hw filters and make them the current filters
+ *
+ * If CAN is enabled, bus activity is temporarily disabled. INIT mode
+ * forgets the frames in the tx buffers (InitModeLeave), so scheduling
+ * is held until they have been sent and confirmed, and restarted 
+ * afterwards. If they are not sent within MSCAN_TXDRAIN_TOUT (e.g. no
+ * other node acknowledges), the filters are written by the next 
+ * MscanEnable() and MSCAN_ERR_TXBUSY is returned.
+ *
+ * \param hf		compiled filters
+ * \return error code
+ */
+static int32 HwFiltApply( MSCAN_HANDLE *h, const MSCAN_HWFILT *hf )
+{
+	OSS_IRQ_STATE oldState;
+	int32 error = 0;
+
+	DBGWRT_2((DBH," HwFiltApply: mode %d: std %d/%d ext %d/%d prec. %d\n",
+			  hf->info.mode, hf->info.stdWanted, hf->info.stdAccepted,
+			  hf->info.extWanted, hf->info.extAccepted, 
+			  hf->info.precision ));
+
+	h->hwFilt = *hf;
+
+	if( !h->canEnabled ){
+		HwFiltWrite( h, hf );
+		h->hwFiltPend = FALSE;
+		return 0;
+	}
+
+	if( (error = TxDrain( h )) ){
+		DBGWRT_2((DBH," HwFiltApply: tx busy, deferred to enable\n"));
+		h->hwFiltPend = TRUE;
+	}
+	else if( (error = InitModeEnter( h )) == 0 ){
+		HwFiltWrite( h, hf );
+		h->hwFiltPend = FALSE;
+		error = InitModeLeave( h );
+	}
+
+	/* resume tx, the ISR schedules the FIFOs (ScheduleNextTx) */
+	oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+	h->txHalt = FALSE;
+	MSWRITE( h->ma, MSCAN_TIER, MSCAN_TXB_MASK );
+	TxPreemptCheck( h );
+	OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+	return error;
+}
+
+/**********************************************************************/
+/** Hold tx scheduling and wait until the tx buffers are empty
+ *
+ * Sets txHalt, which the caller must clear. Waits until the ISR has
+ * handled the completion of all tx buffers, at most MSCAN_TXDRAIN_TOUT.
+ *
+ * \return 0 or MSCAN_ERR_TXBUSY if tx buffers still in use
+ */
+static int32 TxDrain( MSCAN_HANDLE *h )
+{
+	OSS_IRQ_STATE oldState;
+	int32 error = 0;
+	int idle;
+
+	if( h->txDrainSem == NULL ){
+		/*--- create wakeup sem for drain ---*/
+		if( (error = OSS_SemCreate( h->osHdl, OSS_SEM_BIN, 0, 
+									&h->txDrainSem ))){
+			DBGWRT_ERR((DBH,"*** TxDrain: error 0x%x creating sem\n",
+						error));
+			return error;
+		}
+	}
+
+	/* a wakeup left from a previous timeout just loops once more */
+	for(;;){
+		oldState = OSS_IrqMaskR( h->osHdl, h->irqHdl );
+		h->txHalt = TRUE;
+		idle = TxIdle( h );
+		h->txDrainWait = !idle && !error;
+		OSS_IrqRestore( h->osHdl, h->irqHdl, oldState );
+
+		if( !h->txDrainWait )
+			break;
+
+		error = OSS_SemWait( h->osHdl, h->txDrainSem, MSCAN_TXDRAIN_TOUT );
+	}
+
+	return idle ? 0 : MSCAN_ERR_TXBUSY;
+}
+
+/**********************************************************************/
+/** Check if no tx buffer holds a frame (irqs must be masked)
+ */
+static int TxIdle( MSCAN_HANDLE *h )
+{
+	int txb;
+
+	for( txb=0; txb<MSCAN_NTXBUFS; txb++ )
+		if( h->txPrio[txb] != MSCAN_UNASSIGNED )
+			return FALSE;
+
+	return TRUE;
+}
+
+/**********************************************************************/
+/** Derive hw filters from the local filters of all Rx objects
+ *
+ * Called when automatic filtering is enabled and whenever an Rx object
+ * has been configured or removed.
+ *
+ * Standard IDs wanted by any object are taken from the Rx dispatch
+ * table, so acceptance fields are considered. They are passed as runs
+ * of IDs; beyond MSCAN_HWFILT_AUTOSTD runs, the runs with the smallest
+ * gap are joined. Extended object filters are passed as code/mask
+ * patterns; when no entry is left, a pattern is merged into the one
+ * that grows least. Without dispatch table, all IDs pass.
+ *
+ * The controller only enters INIT mode if the compiled registers differ
+ * from the current ones.
+ *
+ * \param force		write filters even if unchanged
+ * \return error code
+ */
+static int32 HwFiltAuto( MSCAN_HANDLE *h, int force )
+{
+	const MSCAN_RXDISP *disp = h->rxDisp;
+	const MSCAN_OBJFILTER *f;
+	MSCAN_HWFILT_ITEM in[MSCAN_FILTER_MAXRANGES], m, t;
+	MSCAN_HWFILT hf;
+	u_int32 nIn=0, nStd, i, j=0, id, gap, bestGap, grow, bestGrow, size;
+	u_int32 stdWanted=0, extWanted=0, k;
+	const MSG_OBJ *obj;
+	int32 nr, error;
+
+	if( disp == NULL ){
+		in[0].ext	= 0;
+		in[0].fixed	= FALSE;
+		in[0].lo	= 0;
+		in[0].hi	= MSCAN_NUM_STD_IDS - 1;
+		in[1]		= in[0];
+		in[1].ext	= 1;
+		in[1].hi	= 0x1fffffff;
+		nIn = 2;
+		stdWanted = MSCAN_NUM_STD_IDS;
+		extWanted = 0x20000000;
+		goto COMPILE;
+	}
+
+	/*--- runs of standard IDs ---*/
+	for( id=0; id<MSCAN_NUM_STD_IDS; id++ ){
+		if( !disp->std[0][id] && !disp->std[1][id] )
+			continue;
+
+		stdWanted++;
+
+		if( nIn && (in[nIn-1].hi == id-1) ){
+			in[nIn-1].hi = id;		/* extend current run */
+			continue;
+		}
+
+		if( nIn == MSCAN_HWFILT_AUTOSTD ){
+			/* join runs with smallest gap, including gap to this ID */
+			bestGap = id - in[nIn-1].hi;
+			j = nIn-1;
+			for( i=0; i<nIn-1; i++ ){
+				gap = in[i+1].lo - in[i].hi;
+				if( gap < bestGap ){
+					bestGap = gap;
+					j = i;
+				}
+			}
+			if( j == nIn-1 ){
+				in[j].hi = id;
+				continue;
+			}
+			in[j].hi = in[j+1].hi;
+			for( i=j+1; i<nIn-1; i++ )
+				in[i] = in[i+1];
+			nIn--;
+		}
+
+		in[nIn].ext	  = 0;
+		in[nIn].fixed = FALSE;
+		in[nIn].lo	  = id;
+		in[nIn].hi	  = id;
+		nIn++;
+	}
+	nStd = nIn;
+
+	/*--- extended object filters ---*/
+	for( nr=h->firstRxObj; nr<=h->lastRxObj; nr++ ){
+		obj = &h->msgObj[nr];
+		if( obj->q.dir != MSCAN_DIR_RCV )
+			continue;
+
+		f = MSCAN_OBJ_FILTERS(obj);
+		for( k=0; k<MSCAN_OBJ_NFILTERS(obj); k++, f++ ){
+			if( !(f->flagCode & MSCAN_EXTENDED) )
+				continue;
+
+			m.ext	= 1;
+			m.fixed	= TRUE;
+			m.care	= f->care & 0x1fffffff;
+			m.code	= f->code & m.care;
+			m.lo	= m.hi = 0;
+
+			/* sum of pattern sizes, overlaps counted twice */
+			size = (u_int32)1 << (29 - BitCount( m.care ));
+			extWanted = (extWanted + size > 0x20000000) ? 
+				0x20000000 : extWanted + size;
+
+			if( nIn < MSCAN_FILTER_MAXRANGES ){
+				in[nIn++] = m;
+				continue;
+			}
+
+			bestGrow = 0xffffffff;
+			for( i=nStd; i<nIn; i++ ){
+				HwFiltMerge( &in[i], &m, &t );
+				grow = ((u_int32)1 << (29 - BitCount( t.care ))) -
+					((u_int32)1 << (29 - BitCount( in[i].care )));
+
+				if( grow < bestGrow ){
+					bestGrow = grow;
+					j = i;
+				}
+			}
+			HwFiltMerge( &in[j], &m, &in[j] );
+		}
+	}
+
+ COMPILE:
+	HwFiltSelect( in, nIn, stdWanted, extWanted, h->hwFiltAutoMode, &hf );
+
+	/*--- registers unchanged? ---*/
+	if( !force && (hf.info.mode == h->hwFilt.info.mode) && 
+		(hf.num == h->hwFilt.num) ){
+
+		for( i=0; i<hf.num; i++ ){
+			if( (hf.flt[i].code != h->hwFilt.flt[i].code) ||
+				(hf.flt[i].care != h->hwFilt.flt[i].care) ||
+				(hf.flt[i].ext != h->hwFilt.flt[i].ext) )
+				break;
+		}
+		if( i == hf.num ){
+			h->hwFilt.info = hf.info;
+			return 0;
+		}
+	}
+
+	/* implicit update deferred to next enable is no error of caller */
+	if( ((error = HwFiltApply( h, &hf )) == MSCAN_ERR_TXBUSY) && !force )
+		error = 0;
+
+	return error;
+}
+
+/**********************************************************************/
+/** Write compiled hw filters to controller
+ *
+ * Controller must be in INIT mode. Unused filters repeat filter 0.
+ *
+ * \param hf		compiled filters
+ */
+static void HwFiltWrite( MSCAN_HANDLE *h, const MSCAN_HWFILT *hf )
+{
+	MACCESS ma = h->ma;
+	const MSCAN_HWFILT_GEO *geo;
+	const MSCAN_HWFILT_ITEM *it;
+	MSCAN_FILTER fspec;
+	u_int8 ar[8], mr[8];
+	u_int32 f, c, k;
+
+	if( hf->info.mode == MSCAN_HWFILT_CLOSED ){
+		MSWRITE( ma, MSCAN_IDAC, MSCAN_IDAC_CLOSED );
+		return;
+	}
+	geo = &hwFiltGeo[hf->info.mode];
+
+	for( f=0; f<geo->num; f++ ){
+		it = &hf->flt[ (f < hf->num) ? f : 0 ];
+		c  = it->code;
+		k  = ~it->care;			/* mask bit set: don't care */
+
+		switch( hf->info.mode ){
+		case MSCAN_HWFILT_2X32:
+			fspec.code 	 = c;
+			fspec.mask 	 = k & (it->ext ? 0x1fffffff : 0x7ff);
+			fspec.cflags = it->ext ? MSCAN_EXTENDED : 0;
+			fspec.mflags = 0;	/* RTR don't care */
+			SetFilter( h, f, &fspec );
+			break;
+
+		case MSCAN_HWFILT_4X16:
+			if( it->ext ){
+				/* ID28..15, SRR=1, IDE=1 */
+				ar[2*f]   = (u_int8)(c >> 6);
+				ar[2*f+1] = (u_int8)((((c >> 3) & 7) << 5) | 0x18 | (c & 7));
+				mr[2*f]   = (u_int8)(k >> 6);
+				mr[2*f+1] = (u_int8)((((k >> 3) & 7) << 5) | (k & 7));
+			}
+			else {
+				/* ID10..0, RTR don't care, IDE=0 */
+				ar[2*f]   = (u_int8)(c >> 3);
+				ar[2*f+1] = (u_int8)(c << 5);
+				mr[2*f]   = (u_int8)(k >> 3);
+				mr[2*f+1] = (u_int8)((k << 5) | 0x17);
+			}
+			break;
+
+		default:
+			/* 8x8: ID10..3 or ID28..21 */
+			ar[f] = (u_int8)c;
+			mr[f] = (u_int8)k;
+			break;
+		}
+	}
+
+	if( hf->info.mode != MSCAN_HWFILT_2X32 ){
+		MSWRITE( ma, MSCAN_IDAC, geo->idac );
+		for( f=0; f<8; f++ ){
+			MSWRITE( ma, idarReg[f], ar[f] );
+			MSWRITE( ma, idmrReg[f], mr[f] );
+		}
+	}
+}
+
+/**********************************************************************/
+/** Count bits set in \a v
+ */
+static u_int32 BitCount( u_int32 v )
+{
+	u_int32 n;
+
+	for( n=0; v; n++ )
+		v &= v - 1;
+
+	return n;
+}
+
 /**********************************************************************/
 /** Put MSCAN into INIT mode
  *
@@ -2223,6 +6471,13 @@ static int32 InitModeLeave( MSCAN_HANDLE *h )
 
 	for( i=0; i<MSCAN_NTXBUFS; i++ )
 		h->txPrio[i] = MSCAN_UNASSIGNED;
+	h->txSeqNxt = 0;
+	h->txPreempt = 0;
+	h->txAbort = 0;
+
+	/* tx buffers are empty now, release txabort waiters */
+	for( i=0; i<(int)h->numObjs; i++ )
+		TxAbortWake( h, &h->msgObj[i] );
 
 	/* INITAK handshake */
 	MSCLRMASK( ma, MSCAN_CTL0, MSCAN_CTL0_INITRQ );
@@ -2235,6 +6490,12 @@ static int32 InitModeLeave( MSCAN_HANDLE *h )
 	}
 	h->canEnabled = TRUE;
 
+#ifdef MSCAN_IS_ODIN
+	/* enable timer for receive timestamps (held in reset in INIT mode) */
+	MSSETMASK( ma, MSCAN_CTL0, MSCAN_CTL0_TIME );
+#endif
+	h->tsValid = FALSE;
+
 	/* update nodestatus */
 	IrqStatus( h );
 
@@ -2302,11 +6563,11 @@ ALLDONE:
  */
 static void RecomputeObjLimits( MSCAN_HANDLE *h )
 {
-	int32 firstRx=MSCAN_NUM_OBJS, lastRx=0, firstTx=MSCAN_NUM_OBJS, lastTx=0;
+	int32 firstRx=h->numObjs, lastRx=0, firstTx=h->numObjs, lastTx=0;
 	int32 nr;
 	OSS_IRQ_STATE oldState;
 
-	for( nr=1; nr<MSCAN_NUM_OBJS; nr++ ){
+	for( nr=1; nr<(int32)h->numObjs; nr++ ){
 
 		if( h->msgObj[nr].q.dir == MSCAN_DIR_RCV ){
 
@@ -2375,9 +6636,17 @@ static int32 MscanDumpInternals( MSCAN_HANDLE *h, char *buffer, int maxLen)
    for( i=0; i<MSCAN_NTXBUFS; i++ ){
 	   ADDSTR((o,lb,"%d ", h->txPrio[i] ));
    }
+   ADDSTR((o,lb, "\n txSched: %d txSeqNxt: %d txSchedNext: %d", 
+			h->txSched, h->txSeqNxt, h->txSchedNext ));
+   ADDSTR((o,lb, "\n rxDrainMax: %d rxIrqFramesMax: %d", h->rxDrainMax,
+			h->rxIrqFramesMax ));
+   if( h->rxDisp ){
+	   ADDSTR((o,lb, "\n rxDisp: %d ext buckets, %d shared objs", 
+			   h->rxDisp->numBkt, h->rxShared ));
+   }
    
    ADDSTR((o,lb, "\nMESSAGE OBJECTS:\n"));
-   for( i=0; i<MSCAN_NUM_OBJS; i++ ){
+   for( i=0; i<(int32)h->numObjs; i++ ){
 	   MSG_OBJ *obj = &h->msgObj[i];
 
 	   if( obj->q.dir != MSCAN_DIR_DIS ){
@@ -2388,8 +6657,9 @@ static int32 MscanDumpInternals( MSCAN_HANDLE *h, char *buffer, int maxLen)
 			   ADDSTR((o,lb, "  txbUsed: %x txNxtPrio %d txSentPrio %d\n",
 						obj->txbUsed, obj->txNxtPrio, obj->txSentPrio ));
 		   }
-		   ADDSTR((o,lb, "  totEntries: %d filled: %d\n", obj->q.totEntries, 
-					obj->q.filled ));
+		   ADDSTR((o,lb, "  totEntries: %d ringSize: %d filled: %d\n", 
+					obj->q.totEntries, obj->q.ringMask + 1,
+					MQUEUE_FILLED( &obj->q ) ));
 		   
 	   }
    }
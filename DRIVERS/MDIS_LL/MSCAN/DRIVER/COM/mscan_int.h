@@ -79,7 +79,8 @@
 /* general MDIS defs */
 
 /* others */
-#define MSCAN_NUM_OBJS		10			/**< number of message objects */
+#define MSCAN_NUM_OBJS		10			/**< def. number of message objects */
+#define MSCAN_MAX_OBJS		256			/**< max. number of message objects */
 #define	MSCAN_ERROR_OBJ		0			/**< msg obj number of error obj  */
 
 /* address space size occupied by MSCAN registers */
@@ -98,6 +99,150 @@
 
 #define MSCAN_MAX_LOC_PRIO	0x0f 		/**< see txNxtPrio  */
 
+#define MQUEUE_MAX_ENTRIES	0x1000000	/**< max. entries per queue */
+
+/** 
+ * memory barrier between queue entries and queue counters (SMP).
+ * The lock-free queues, shared rings and mailbox slots depend on it,
+ * so unknown compilers must define it in the build. An empty 
+ * definition is only correct for uniprocessor targets.
+ */
+#ifndef MSCAN_MEMBAR
+# if defined(__GNUC__)
+#  define MSCAN_MEMBAR()	__sync_synchronize()
+# elif defined(_MSC_VER)
+#  define MSCAN_MEMBAR()	MemoryBarrier()
+# else
+#  error "MSCAN_MEMBAR: no memory barrier known for this compiler"
+# endif
+#endif
+
+/** alignment of rx/tx rings shared with the application (page size) */
+#ifndef MSCAN_SHRING_ALIGN
+# define MSCAN_SHRING_ALIGN	0x1000
+#endif
+
+/** 
+ * Shared rx/tx rings are handed to the application as driver pointers,
+ * they are not mapped into another address space. So they are only 
+ * built if MSCAN_SHRING is defined, which is correct only for OSes 
+ * that run driver and application in one address space without memory 
+ * protection (e.g. VxWorks).
+ */
+#if defined(MSCAN_SHRING) && defined(LINUX)
+# error "MSCAN_SHRING: shared rings need a single address space"
+#endif
+#if !defined(MSCAN_SHRING) && !defined(MSCAN_NO_SHRING)
+# define MSCAN_NO_SHRING
+#endif
+
+/** 
+ * max. time in ms to wait for the tx buffers to get empty before the
+ * hw filter is rewritten on a running controller
+ */
+#ifndef MSCAN_TXDRAIN_TOUT
+# define MSCAN_TXDRAIN_TOUT	100
+#endif
+
+/** 
+ * read free running counter for ISR time measurement into \a v (u_int32),
+ * CPU cycle counter if known, OS tick otherwise. May be overridden by
+ * the build, together with MSCAN_CYCLES_FREQ (0=unknown).
+ * MSCAN_CYCLES64 reads the full 64 bit cycle counter into \a hi/\a lo
+ * (u_int32), it is only defined if such a counter is known.
+ */
+#ifndef MSCAN_CYCLES
+# if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  define MSCAN_CYCLES(h,v) \
+	__asm__ __volatile__("rdtsc" : "=a" (v) : : "edx")
+#  define MSCAN_CYCLES64(h,hi,lo) \
+	__asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi))
+#  define MSCAN_CYCLES_FREQ(h)	0
+# elif defined(__GNUC__) && (defined(__powerpc__) || defined(__PPC__))
+#  define MSCAN_CYCLES(h,v) \
+	__asm__ __volatile__("mftb %0" : "=r" (v))
+#  define MSCAN_CYCLES64(h,hi,lo) \
+	do { \
+		u_int32 _hi2; \
+		do { \
+			__asm__ __volatile__("mftbu %0" : "=r" (hi)); \
+			__asm__ __volatile__("mftb %0" : "=r" (lo)); \
+			__asm__ __volatile__("mftbu %0" : "=r" (_hi2)); \
+		} while( (hi) != _hi2 ); \
+	} while(0)
+#  define MSCAN_CYCLES_FREQ(h)	0
+# else
+#  define MSCAN_CYCLES(h,v)		((v) = OSS_TickGet((h)->osHdl))
+#  define MSCAN_CYCLES_FREQ(h)	OSS_TickRateGet((h)->osHdl)
+# endif
+#endif
+
+/** 
+ * timestamp source for non-ODIN implementations. If MSCAN_CYCLES64 is
+ * known, timestamps are read from the 64 bit cycle counter, whose 
+ * frequency is measured against the OS tick at init (MSCAN_TS_CYCLES). 
+ * MSCAN_TS_GET/MSCAN_TS_FREQ (32 bit, free running, default: OS tick) 
+ * are used if there is no such counter or the measurement failed. 
+ * They may be overridden by the build to use another counter.
+ */
+#ifndef MSCAN_TS_GET
+# if !defined(MSCAN_IS_ODIN) && defined(MSCAN_CYCLES64)
+#  define MSCAN_TS_CYCLES
+# endif
+# define MSCAN_TS_GET(h)	OSS_TickGet((h)->osHdl)
+# define MSCAN_TS_FREQ(h)	OSS_TickRateGet((h)->osHdl)
+#endif
+
+/** min. time in ms to measure the cycle counter frequency at init */
+#ifndef MSCAN_TSCAL_MS
+# define MSCAN_TSCAL_MS		20
+#endif
+
+/** tx object \a obj has frames to schedule */
+#define MSCAN_TXOBJ_PENDING(obj) \
+	((obj)->q.ready && ((obj)->q.dir == MSCAN_DIR_XMT) && \
+	 ((MQUEUE_FILLED( &(obj)->q ) != 0) || (obj)->txHoldValid))
+
+/**
+ * bus arbitration key of frame \a f, lower key wins: 
+ * base ID, RTR/SRR, IDE, extended ID, RTR 
+ */
+#define MSCAN_ARB_KEY(f) \
+	(((f)->flags & MSCAN_EXTENDED) ? \
+	 ((((f)->id & 0x1ffc0000) << 3) | 0x00180000 | \
+	  (((f)->id & 0x3ffff) << 1) | (((f)->flags & MSCAN_RTR) ? 1 : 0)) : \
+	 ((((f)->id & 0x7ff) << 21) | (((f)->flags & MSCAN_RTR) ? 0x100000 : 0)))
+
+/** number of filled entries in queue \a q */
+#define MQUEUE_FILLED(q)	((q)->nxtIn - (q)->nxtOut)
+
+/** next rx/tx queue entry to fill/extract */
+#define MQUEUE_FRM_IN(q)	(&(q)->ent.frm[(q)->nxtIn & (q)->ringMask])
+#define MQUEUE_FRM_OUT(q)	(&(q)->ent.frm[(q)->nxtOut & (q)->ringMask])
+
+/** next error queue entry to fill/extract */
+#define MQUEUE_ERR_IN(q)	(&(q)->ent.err[(q)->nxtIn & (q)->ringMask])
+#define MQUEUE_ERR_OUT(q)	(&(q)->ent.err[(q)->nxtOut & (q)->ringMask])
+
+/** convert txPrio to TXBPR value (objects >= 15 share the lowest prio) */
+#define MSCAN_TXBPR_VAL(p) \
+	((p) > 0xff ? (0xf0 | ((p) & 0xf)) : (p))
+
+#define MSCAN_RX_DRAIN_DEF	16			/**< default frames read per irq */
+
+#define MSCAN_NUM_STD_IDS	0x800		/**< number of standard IDs */
+#define MSCAN_RXDISP_NONE	0			/**< rx dispatch: no target object */
+#define MSCAN_RXDISP_TGTMAX	0x10000		/**< max. size of target lists */
+
+#define MSCAN_HWFILT_NUM	8			/**< max. hw filters (8x8 mode) */
+/** weight of a std ID vs. an ext ID when comparing hw filters (2^29/2^11) */
+#define MSCAN_HWFILT_STDWEIGHT	18
+#define MSCAN_HWFILT_AUTOSTD	16		/**< max. std ID runs in auto mode */
+
+/** hash function for extended IDs in Rx dispatch table */
+#define MSCAN_RXDISP_HASH(key,bkt) \
+	((key) ^ ((key) >> 9) ^ ((key) >> 18) ^ ((bkt) * 0x3b))
+
 /** Macro to check if Setstat/Getstat block sizes match */
 #define CHK_BLK_SIZE( blk, type ) \
  if( blk->size != sizeof(type) ){\
@@ -106,6 +251,22 @@
     break;\
  }
 
+/** Macro to check if Setstat/Getstat block has at least size of type */
+#define CHK_BLK_MINSIZE( blk, type ) \
+ if( blk->size < (int32)sizeof(type) ){\
+    DBGWRT_ERR((DBH,"*** MSCAN: blk->size too small for %s\n", #type ));\
+    error = ERR_LL_ILL_PARAM;\
+    break;\
+ }
+
+/** Macro to wake mscan_wait if it waits for object \a nr in \a mask */
+#define MSCAN_WAIT_WAKE(h,mask,nr) \
+ if( (h)->waitActive && ((nr) < MSCAN_WAIT_MAXOBJ) && \
+	 (((mask) >> (nr)) & 1) ){ \
+	 (h)->waitActive = FALSE; \
+	 OSS_SemSignal( (h)->osHdl, (h)->waitSem ); \
+ }
+
 /** Macro to lock device semaphore */
 /* ??? while( error == ERR_OSS_SIG_OCCURED ) might be a problem in Linux???*/
 #define DEVSEM_LOCK(h) \
@@ -140,32 +301,172 @@
 |  TYPEDEFS                                |
 +-----------------------------------------*/
 
-/** queue entry structure */
-typedef struct mqueue_ent {
-	struct mqueue_ent *next;		/**< ptr to next entry */
+/** 64 bit receive timestamp of queue entry */
+typedef struct {
+	u_int32		high;
+	u_int32		low;
+} MQUEUE_TS;
+
+/** per entry info of tx queue */
+typedef struct {
+	u_int32		enqTick;			/**< OS tick when frame was queued */
+	u_int32		lifetime;			/**< OS ticks until dropped, 0=never */
+} MQUEUE_TXMETA;
+
+/** accField pool entry, shared by objects with identical fields */
+typedef struct {
+	u_int8			field[256];		/**< MSCAN_FILTER.accField */
+	u_int32			refs;			/**< objects using this entry */
+} MSCAN_ACCENT;
+
+/** compiled local filter of an Rx object (see ObjFilterSet) */
+typedef struct {
+	u_int32			care;			/**< ID bits compared (inverted mask) */
+	u_int32			code;			/**< acceptance code & care */
+	u_int8			flagMask;		/**< frame flags compared */
+	u_int8			flagCode;		/**< required frame flags */
+	u_int16			accIdx;			/**< accField pool entry+1, 0=none */
+} MSCAN_OBJFILTER;
+
+/**********************************************************************/
+/** queue header structure
+ *
+ * The entries form a ring of (2^n) elements. \em nxtIn and \em nxtOut
+ * are free running counters, the array index is obtained by masking
+ * them with \em ringMask. The number of filled entries is their
+ * difference (see MQUEUE_FILLED). \em totEntries (the number of entries
+ * requested by the user) limits the fill level, it may be smaller than
+ * the ring size.
+ *
+ * Each queue has a single producer and a single consumer (ISR and the
+ * caller, which is serialized by the device semaphore). Only the 
+ * producer writes \em nxtIn and only the consumer writes \em nxtOut,
+ * ordered against the entries with MSCAN_MEMBAR, so the fast paths
+ * need no irq masking.
+ */
+typedef struct {
 	union {
-		MSCAN_FRAME frm;			/**< data for rx/tx queues */
-		MSCAN_READERROR_PB err;		/**< data for error object */
-	} d;							/**< union to hold frm or err */
-} MQUEUE_ENT;
-			
-/** queue header structure */
-typedef struct {
-	MQUEUE_ENT 	*first,				/**< start of memory used for entries */
-		        *nxtIn,				/**< next entry to fill */
-		        *nxtOut;			/**< next entry to extract */
+		MSCAN_FRAME *frm;			/**< entries for rx/tx queues */
+		MSCAN_READERROR_PB *err;	/**< entries for error object */
+		void *mem;					/**< start of memory used for entries */
+	} ent;							/**< ring entries */
+	MQUEUE_TS	*ts;				/**< rx: timestamps parallel to ent */
+	MQUEUE_TXMETA *txMeta;			/**< tx: frame info parallel to ent */
 	u_int32		memAlloc;			/**< allocated mem for entries */
+	u_int32		ringMask;			/**< ring size - 1 */
+	volatile u_int32 nxtIn;			/**< counter of next entry to fill */
+	volatile u_int32 nxtOut;		/**< counter of next entry to extract */
+	u_int32		wakeLevel;			/**< rx: wake reader at this fill level */
 	u_int32		totEntries;			/**< total number of entries */
-	u_int32		filled;				/**< number of filled entries */
 	u_int8		ready;				/**< flags if queue is fully initialized */
 	u_int8		errSent;			/**< flags if overrun error has been sent*/
-	u_int8		waiting;			/**< flags read/write waiter waiting  */
+	volatile u_int8 waiting;		/**< flags read/write waiter waiting  */
 	u_int8		_pad;
 	MSCAN_DIR	dir;				/**< direction */
-	MSCAN_FILTER filter;			/**< rx: local filter */
+	MSCAN_OBJFILTER filter;			/**< rx: compiled local filter */
 	OSS_SEM_HANDLE *sem;			/**< semaphore to wake read/write waiter */
 } MQUEUE_HEAD;
 
+/** Rx dispatch: extended ID filter entry (one per ext. Rx object) */
+typedef struct {
+	u_int32			code;			/**< acceptance code & care bits */
+	u_int16			next;			/**< next entry in hash chain +1 */
+	u_int8			bkt;			/**< bucket (care mask) index */
+	u_int8			nr;				/**< target object number */
+	u_int8			rtrMask;		/**< MSCAN_RTR if RTR must match */
+	u_int8			rtrCode;		/**< required RTR flag */
+	u_int8			shared;			/**< target object is shared */
+	u_int8			_pad;
+} MSCAN_RXDISP_EXT;
+
+/** Rx dispatch: bucket of extended filters sharing the same mask */
+typedef struct {
+	u_int32			care;			/**< ID bits compared (inverted mask) */
+} MSCAN_RXDISP_BKT;
+
+/**********************************************************************/
+/** Rx dispatch table
+ *
+ * Precompiled from the local filters of all Rx objects whenever an 
+ * object is configured (BuildRxDispatch). IrqRx uses it to find the
+ * target object of a frame without evaluating every object's filter.
+ *
+ * Standard IDs are looked up directly in \em std, which holds the
+ * offset of the ID's target list in \em tgt: the lowest matching 
+ * object that is not shared, followed by all matching shared objects,
+ * terminated by MSCAN_RXDISP_NONE. Offset 0 is the empty list.
+ * Extended filters are grouped into buckets of identical masks; each 
+ * bucket is searched through a hash over (masked ID, bucket).
+ *
+ * The ext arrays and \em tgt follow this struct in the same memory 
+ * block.
+ */
+typedef struct {
+	u_int32			memAlloc;		/**< allocated size of this block */
+	u_int16	std[2][MSCAN_NUM_STD_IDS];	/**< target list by [RTR][ID] */
+	u_int32			numBkt;			/**< number of ext. buckets */
+	u_int32			hashMask;		/**< size of \em hash - 1 */
+	MSCAN_RXDISP_EXT *ext;			/**< ext. filter entries */
+	MSCAN_RXDISP_BKT *bkt;			/**< ext. buckets */
+	u_int16			*hash;			/**< ext. hash heads (entry idx+1) */
+	u_int8			*tgt;			/**< std. target lists */
+} MSCAN_RXDISP;
+
+/** cyclic tx table entry with state of the alarm routine */
+typedef struct {
+	MSCAN_CYCLIC	c;				/**< entry as set by user */
+	u_int32			lifetime;		/**< lifetime of queued frame (ticks) */
+	u_int32			due;			/**< next transmission (alarm ms) */
+	u_int32			left;			/**< transmissions left if c.count */
+	u_int8			restart;		/**< entry changed, restart timing */
+} MSCAN_CYCENT;
+
+/** tx mailbox slot: CAN ID bound to the slot and its FIFO entry */
+typedef struct {
+	u_int32			id;				/**< CAN ID */
+	u_int8			flags;			/**< MSCAN_EXTENDED/MSCAN_RTR */
+	u_int32			seq;			/**< FIFO counter of latest entry */
+} MSCAN_TXSLOT;
+
+/** rx mailbox slot: latest frame of one CAN ID */
+typedef struct {
+	volatile u_int32 seq;			/**< updates * 2, odd while ISR writes */
+	u_int32			key;			/**< MSCAN_RXSLOT_KEY of ID */
+	MSCAN_FRAME		frm;			/**< latest frame */
+	MQUEUE_TS		ts;				/**< its receive timestamp */
+} MSCAN_RXSLOT;
+
+/** geometry of one hardware filter mode ([0]=std, [1]=ext IDs) */
+typedef struct {
+	u_int8			idac;			/**< IDAC register value */
+	u_int8			num;			/**< number of filters */
+	u_int8			mixed;			/**< filter can't distinguish std/ext */
+	u_int8			bits[2];		/**< ID bits compared */
+	u_int8			shift[2];		/**< position of lowest compared ID bit */
+} MSCAN_HWFILT_GEO;
+
+/** one hw acceptance filter, in the ID space of the mode (see geo) */
+typedef struct {
+	u_int32			code;			/**< acceptance code */
+	u_int32			care;			/**< compared bits */
+	u_int32			lo;				/**< first ID of interval (not fixed) */
+	u_int32			hi;				/**< last ID of interval (not fixed) */
+	u_int8			ext;			/**< filter for extended IDs */
+	u_int8			fixed;			/**< code/care only, can't be split */
+} MSCAN_HWFILT_ITEM;
+
+/** compiled hardware filter set */
+typedef struct {
+	u_int32			num;			/**< filters used (0=closed) */
+	MSCAN_HWFILT_ITEM flt[MSCAN_HWFILT_NUM]; /**< filters */
+	MSCAN_HWFILT_INFO info;			/**< resulting acceptance */
+} MSCAN_HWFILT;
+
+/** rx mailbox lookup key of frame \a f: ID, IDE and RTR */
+#define MSCAN_RXSLOT_KEY(f) \
+	((f)->id | (((f)->flags & MSCAN_EXTENDED) ? 0x20000000 : 0) | \
+	 (((f)->flags & MSCAN_RTR) ? 0x40000000 : 0))
+
 /** per message object structure */
 typedef struct {
 	u_int32			nr;				/**< message object number (redundant) */
@@ -193,9 +494,90 @@ typedef struct {
 	 *	Used in the chronological buffer scheduling algorithm
 	 */
 	u_int8			txSentPrio;	
+
+	u_int32			txWeight;		/**< WRR: frames per turn (0=1) */
+	u_int32			txDeadline;		/**< EDF: rel. deadline (OS ticks) */
+	volatile u_int32 txExpired;		/**< frames dropped due to lifetime */
+	u_int32			txCyclic;		/**< cyclic table entries using obj */
+
+	/**********************************************************************/
+    /** Tx mailbox (MSCAN_DIR_XMTMBOX, else NULL)
+	 *	Each CAN ID has at most one frame in the FIFO. A write for an ID 
+	 *  whose frame is still in the FIFO overwrites that entry.
+	 *  Slots are behind the queue entries in the same memory block.
+	 */
+	MSCAN_TXSLOT	*txSlot;
+	u_int32			txSlotNum;		/**< slots bound to an ID */
+
+	/**********************************************************************/
+    /** Rx mailbox (MSCAN_DIR_RCVMBOX, else NULL)
+	 *	The ISR overwrites the slot of the frame's ID (seqlock) and marks 
+	 *  it in rxChanged. q.nxtIn counts slots getting marked, q.nxtOut 
+	 *  slots taken by the reader, so MQUEUE_FILLED is the number of 
+	 *  changed slots. Slots, hash and bitmap are the queue memory block.
+	 */
+	MSCAN_RXSLOT	*rxSlot;
+	u_int32			*rxHash;		/**< slot index+1 by key hash */
+	u_int32			rxHashMask;		/**< size of rxHash - 1 */
+	u_int32			*rxChanged;		/**< bitmap of changed slots */
+	u_int32			rxSlotNum;		/**< slots bound to an ID */
+	u_int32			rxSlotScan;		/**< slot where next read starts */
+
+	/**********************************************************************/
+    /** Rx/Tx ring shared with application (NULL if not mapped)
+	 *	q.ent/q.ts are behind this header in ringMem. The ISR mirrors
+	 *  q.nxtIn to the header and takes q.nxtOut from it, the application 
+	 *  reads the frames in place.
+	 *  Tx: the application fills q.ent, the doorbell takes over nxtIn
+	 *  and ISR mirrors q.nxtOut. q.txMeta stays behind the frames.
+	 */
+	MSCAN_RXRING	*rxRing;
+	MSCAN_TXRING	*txRing;
+	void			*ringMem;		/**< allocated block (unaligned) */
+	u_int32			ringAlloc;	/**< allocated size of ringMem */
+
+	/* CANID: frame aborted for preemption, sent before FIFO */
+	MSCAN_FRAME		txHold;			/**< held frame */
+	u_int32			txHoldSeq;		/**< seq. of held frame */
+	u_int8			txHoldValid;	/**< txHold contains a frame */
+	u_int8			txPreempting;	/**< abort of obj's tx buffer pending */
+
+	/* txabort: frames removed from tx buffers/hold slot by QueueClear */
+	MSCAN_FRAME		txAborted[MSCAN_TXABORT_MAX];	/**< aborted frames */
+	u_int32			txAbortedSeq[MSCAN_TXABORT_MAX];/**< their seq. */
+	u_int32			txAbortedCnt;	/**< entries in txAborted */
+	volatile u_int8 txAborting;		/**< TARQ issued, TAAK pending */
+	volatile u_int8 txAbortWait;	/**< mscan_tx_abort waits for sem */
+	OSS_SEM_HANDLE	*txAbortSem;	/**< wakeup sem for txabort */
+
+	/**********************************************************************/
+    /** Tx confirmation ring (NULL if disabled)
+	 *	Filled by ISR when a tx buffer of this object completed, 
+	 *  read by mscan_read_txconf. Same SPSC scheme as MQUEUE_HEAD.
+	 */
+	MSCAN_TXCONF	*txConf;
+	u_int32			txConfAlloc;	/**< allocated mem for txConf */
+	u_int32			txConfMask;		/**< ring size - 1 */
+	volatile u_int32 txConfIn;		/**< counter of next entry to fill */
+	volatile u_int32 txConfOut;		/**< counter of next entry to read */
+	volatile u_int32 txConfLost;	/**< lost entries (written by ISR) */
+	u_int32			txConfLostRd;	/**< txConfLost at last read */
+
+	int				shared;			/**< Rx: gets copies of frames that
+									   other objects receive, too */
+
+	/* filter rules (mscan_set_filter_rules), replace q.filter */
+	MSCAN_OBJFILTER	*rules;			/**< compiled rules (NULL if none) */
+	u_int32			numRules;		/**< entries in rules */
+	u_int32			rulesAlloc;		/**< allocated mem for rules */
 	
 } MSG_OBJ;
 
+/** compiled filters of object \a o: rules or local filter */
+#define MSCAN_OBJ_FILTERS(o)	((o)->rules ? (o)->rules : &(o)->q.filter)
+/** number of compiled filters of object \a o */
+#define MSCAN_OBJ_NFILTERS(o)	((o)->rules ? (o)->numRules : 1)
+
 /** ll handle */
 typedef struct {
 	/* general */
@@ -210,7 +592,9 @@ typedef struct {
     u_int32         dbgLevel;		/**< debug level */
 	DBG_HANDLE      *dbgHdl;        /**< debug handle */
 
-	MSG_OBJ			msgObj[MSCAN_NUM_OBJS]; /**< message object structures */
+	MSG_OBJ			*msgObj;		/**< message object structures */
+	u_int32			numObjs;		/**< number of message objects */
+	u_int32			msgObjAlloc;	/**< size allocated for msgObj */
 
 	/**********************************************************************/
     /** array to record which priority has been assigned to tx buffers
@@ -220,10 +604,27 @@ typedef struct {
 	 *  
 	 *  Once the frame has been transmitted, it is reset to MSCAN_UNASSIGNED.
 	 *	The buffer priority is coded as follows:
-	 *  upper 4 bits: msg obj number
+	 *  upper bits: msg obj number
 	 *  lower 4 bits: msg obj relative priority (0=highest)
+	 *
+	 *  TXBPR is only 8 bits wide, see MSCAN_TXBPR_VAL
 	 */
 	int				txPrio[MSCAN_NTXBUFS];
+	MSCAN_TXCONF	txShadow[MSCAN_NTXBUFS]; /**< frames in tx buffers */
+
+	/* tx scheduling */
+	int32			txSched;		/**< policy (MSCAN_TXSCHED) */
+	int32			txSchedNext;	/**< RR/WRR: object of current turn */
+	u_int32			txWrrCredit;	/**< WRR: frames left in turn */
+	u_int32			txSeqNxt;		/**< !PRIO: next tx buffer priority */
+	u_int8			txBpr[MSCAN_NTXBUFS];	/**< TXBPR of tx buffers */
+	u_int8			txPreempt;		/**< CANID: tx buffers being aborted */
+	u_int8			txAbort;		/**< txabort: tx buffers being aborted */
+	volatile u_int8 txHalt;			/**< schedule nothing (tx drain) */
+	volatile u_int8 txDrainWait;	/**< waiter blocks on txDrainSem */
+	OSS_SEM_HANDLE	*txDrainSem;	/**< wakeup sem for tx drain */
+	u_int32			txKey[MSCAN_NTXBUFS];	/**< CANID: arb. key of txb */
+	MSCAN_FRAME		txFrame[MSCAN_NTXBUFS];	/**< frame in txb */
 
 	int				canEnabled;		/**< CAN bus activity enabled  */
 	int				busTimingSet; 	/**< user has setup bustiming  */
@@ -238,9 +639,61 @@ typedef struct {
 	int32			firstTxObj;		/**< first object configured for Tx  */
 	int32			lastTxObj;		/**< last object configured for Tx  */
 
-	u_int32			maxIrqTime;
+	u_int32			maxIrqTime;		/**< max. ISR time (internal ticks) */
+	MSCAN_IRQSTAT_PB irqStat;		/**< ISR statistics */
+
+	MSCAN_RXDISP	*rxDisp;		/**< Rx dispatch table (or NULL) */
+	u_int32			rxShared;		/**< number of shared Rx objects */
+	u_int8	rxTgt[MSCAN_MAX_OBJS+2];	/**< IrqRx: ext. target list */
+	MSCAN_ACCENT	*accPool;		/**< accField pool, numObjs entries */
+	u_int32			accPoolAlloc;	/**< allocated mem for accPool */
+	MSCAN_HWFILT	hwFilt;			/**< current hw acceptance filter */
+	int				hwFiltPend;		/**< hwFilt written at next enable */
+	int				hwFiltAuto;		/**< derive hw filter from Rx objects */
+	u_int32			hwFiltAutoMode;	/**< MSCAN_HWFILT_xxx for auto */
+
+	/* Rx FIFO draining */
+	u_int32			rxDrainMax;		/**< max. frames read per irq  */
+	u_int32			rxIrqFrames;	/**< frames read in current irq  */
+	u_int32			rxIrqFramesMax;	/**< max. frames read in one irq  */
 
 	u_int32			minBrp;			/**< minimum baud rate prescaler  */
+
+	/* Rx timestamps */
+	u_int32			tsHigh;			/**< last timestamp, bits 63..32 */
+	u_int32			tsLow;			/**< last timestamp, bits 31..0 */
+	u_int32			tsLastRaw;		/**< last raw timer value */
+	u_int32			tsLastTick;		/**< OS tick at tsLastRaw (ODIN) */
+	u_int32			tsTickRate;		/**< OS ticks per second (ODIN) */
+	u_int32			bitRate;		/**< current bit rate (0=not set) */
+	int				tsValid;		/**< tsHigh/tsLow initialized */
+	u_int32			tsCycFreq;		/**< timestamp freq. of cycle counter
+									   (0=OS tick used) */
+	u_int32			tsCycShift;		/**< cycle counter shifted right */
+
+	/**********************************************************************/
+    /** Cyclic tx table (double buffered)
+	 *	mscan_set_cyclic builds the new table in the inactive buffer and
+	 *  posts it in \em cycPend. The alarm routine takes it over at its 
+	 *  next call, so only the alarm routine touches the active table.
+	 */
+	MSCAN_CYCENT	*cycTbl[2];		/**< tables (NULL if never used) */
+	u_int32			cycAlloc;		/**< allocated mem for cycTbl */
+	int				cycAct;			/**< index of active table */
+	volatile int	cycPend;		/**< index of posted table, -1=none */
+	OSS_ALARM_HANDLE *cycAlarm;		/**< alarm driving the table */
+	u_int32			cycMs;			/**< alarm period in ms */
+	u_int32			cycNow;			/**< alarm time in ms */
+	int				cycRunning;		/**< alarm is running */
+	OSS_SEM_HANDLE	*cycSem;		/**< wakeup sem for table takeover */
+	volatile u_int8 cycWait;		/**< waiter blocks on cycSem */
+
+	/* multi-object wait (mscan_wait) */
+	OSS_SEM_HANDLE	*waitSem;		/**< wakeup sem (NULL if never used) */
+	u_int32			waitRx;			/**< objects waited for frames */
+	u_int32			waitTx;			/**< objects waited for space */
+	volatile u_int8 waitActive;		/**< waiter blocks on waitSem */
+	u_int8			waitBusy;		/**< mscan_wait in progress */
 } MSCAN_HANDLE;
 
 
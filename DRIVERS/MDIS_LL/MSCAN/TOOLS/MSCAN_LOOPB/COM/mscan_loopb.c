@@ -62,7 +62,7 @@ static const char RCSid[]="$Id: mscan_loopb.c,v 1.9 2010/02/25 18:04:33 amorbach
 #include <MEN/mdis_err.h>
 #include <MEN/usr_err.h>
 #include <MEN/mscan_api.h>
-#include <MEN/mscan_drv.h>		/* only for MSCAN_MAXIRQTIME */
+#include <MEN/mscan_drv.h>		/* only for MSCAN_MAXIRQTIME/IRQSTAT */
 
 /*--------------------------------------+
 |   DEFINES                             |
@@ -75,6 +75,8 @@ static const char RCSid[]="$Id: mscan_loopb.c,v 1.9 2010/02/25 18:04:33 amorbach
      goto ABORT;\
  }
 
+#define MAX_CHK_FRAMES	32		/* max. frames per SendCheck */
+
 /*--------------------------------------+
 |   PROTOTYPES                          |
 +--------------------------------------*/
@@ -85,6 +87,40 @@ static int LoopbTxPrio( MDIS_PATH path );
 static int LoopbRxFilter( MDIS_PATH path );
 static int LoopbSignals( MDIS_PATH path );
 static int LoopbRxOverrun( MDIS_PATH path );
+static int LoopbHwFiltRanges( MDIS_PATH path );
+static int LoopbRxRules( MDIS_PATH path );
+static int LoopbRxShared( MDIS_PATH path );
+static int LoopbRxDrain( MDIS_PATH path );
+static int LoopbRxDispatch( MDIS_PATH path );
+static int LoopbNumObjs( MDIS_PATH path );
+static int LoopbFifoWrap( MDIS_PATH path );
+static int LoopbRxConcurrent( MDIS_PATH path );
+static int LoopbReadTimeout( MDIS_PATH path );
+static int LoopbNMsgCall( MDIS_PATH path );
+static int LoopbRxTimestamps( MDIS_PATH path );
+static int LoopbTxConf( MDIS_PATH path );
+static int LoopbIrqStat( MDIS_PATH path );
+static int LoopbTxSched( MDIS_PATH path );
+static int LoopbTxCanId( MDIS_PATH path );
+static int LoopbTxAbort( MDIS_PATH path );
+static int LoopbTxExpiry( MDIS_PATH path );
+static int LoopbTxCyclic( MDIS_PATH path );
+static int LoopbTxMbox( MDIS_PATH path );
+static int LoopbRxMbox( MDIS_PATH path );
+static int LoopbRxRing( MDIS_PATH path );
+static int LoopbTxRing( MDIS_PATH path );
+static int LoopbWait( MDIS_PATH path );
+static int LoopbFilterAuto( MDIS_PATH path );
+static int LoopbAccFields( MDIS_PATH path );
+
+static int SendAll( MDIS_PATH path, int txObj, const MSCAN_FRAME *frm, 
+					int n );
+static int SendCheck( MDIS_PATH path, int txObj, const MSCAN_FRAME *frm, 
+					  int n, u_int32 rxMask, const u_int32 *must, 
+					  const u_int32 *may );
+static int RecvCount( MDIS_PATH path, int rxObj, const MSCAN_FRAME *frm, 
+					  int n, int *cnt );
+static void ObjsDisable( MDIS_PATH path );
 
 static void DumpFrame( char *msg, const MSCAN_FRAME *frm );
 static int CmpFrames( const MSCAN_FRAME *frm1, const MSCAN_FRAME *frm2 );
@@ -123,6 +159,31 @@ static TEST_ELEM G_testList[] = {
 	{ 'c', "Rx filter", LoopbRxFilter },
 	{ 'd', "Rx/Tx signals", LoopbSignals },
 	{ 'e', "Rx FIFO overrun", LoopbRxOverrun },
+	{ 'f', "HW filter ranges", LoopbHwFiltRanges },
+	{ 'g', "Rx filter rules", LoopbRxRules },
+	{ 'h', "Shared Rx objects", LoopbRxShared },
+	{ 'i', "Rx FIFO drain per irq", LoopbRxDrain },
+	{ 'j', "Rx dispatch, overlapping filters", LoopbRxDispatch },
+	{ 'k', "All message objects", LoopbNumObjs },
+	{ 'l', "FIFO sizes and wrap around", LoopbFifoWrap },
+	{ 'm', "Read while receiving", LoopbRxConcurrent },
+	{ 'n', "Blocking batch read", LoopbReadTimeout },
+	{ 'o', "Batch I/O in one call", LoopbNMsgCall },
+	{ 'p', "Receive timestamps", LoopbRxTimestamps },
+	{ 'q', "Transmit confirmation", LoopbTxConf },
+	{ 'r', "ISR statistics", LoopbIrqStat },
+	{ 's', "Tx scheduling between objects", LoopbTxSched },
+	{ 't', "Tx by CAN ID, preemption", LoopbTxCanId },
+	{ 'u', "Tx abort", LoopbTxAbort },
+	{ 'v', "Tx frame lifetime", LoopbTxExpiry },
+	{ 'w', "Cyclic transmission", LoopbTxCyclic },
+	{ 'x', "Tx mailbox", LoopbTxMbox },
+	{ 'y', "Rx mailbox", LoopbRxMbox },
+	{ 'z', "Shared Rx ring", LoopbRxRing },
+	{ '1', "Shared Tx ring", LoopbTxRing },
+	{ '2', "Wait for several objects", LoopbWait },
+	{ '3', "Automatic hardware filter", LoopbFilterAuto },
+	{ '4', "Rx acceptance fields", LoopbAccFields },
 	{ 0, NULL, NULL }
 };
 
@@ -130,64 +191,107 @@ static int G_sigUos1Cnt, G_sigUos2Cnt;	/* signal counters */
 static int G_endMe;
 
 /*
-ToDo:
- - read with timeout
+Test coverage (one column per test):
+
+Test:                   abcdefghijklmnopqrstuvwxyz1234
+----------------------  ------------------------------
+mscan_init              ALL
+
+mscan_term              ALL
+
+mscan_set_filter        --*---*---------------------*-
+
+mscan_set_filter_ranges -----*------------------------
+
+mscan_filter_info       -----**---------------------*-
+
+mscan_filter_auto       ------*---------------------*-
+
+mscan_set_filter_rules  ------*-----------------------
+
+mscan_set_shared        -------*----------------------
+
+mscan_config_msg        ALL
+
+mscan_set_bitrate       ALL
+
+mscan_set_bustiming     ------------------------------
+
+mscan_read_msg          ***---------------------------
+
+mscan_read_nmsg         ----*********-*--*************
+
+mscan_read_nmsg_timeout -------------*------*---------
+
+mscan_read_msg_ts       ---------------*--------------
 
-Test coverage:
+mscan_read_nmsg_ts      ---------------*------*-------
 
-Test:                  A  B  C  D  E	
---------------------   -- -- -- -- --
-mscan_init             ALL
+mscan_ts_freq           ---------------*------*-------
 
-mscan_term             ALL  
+mscan_read_mbox         ------------------------*-----
 
-mscan_set_filter       -  -  *  -  -
+mscan_rxring_map        -------------------------*----
 
-mscan_config_msg	   ALL
+mscan_rxring_wait       -------------------------*----
 
-mscan_set_bitrate	   ALL
+mscan_txring_map        --------------------------*---
 
-mscan_set_bustiming    -  -  -  -  -
+mscan_txring_doorbell   --------------------------*---
 
-mscan_read_msg         *  *  *  -  -
+mscan_wait              ---------------------------*--
 
-mscan_read_nmsg        -  -  -  -  *
+mscan_txconf_enable     ----------------*-------------
 
-mscan_write_msg        *  -  *  *  *
+mscan_read_txconf       ----------------*-------------
 
-mscan_write_nmsg       -  *	 -	-  -
+mscan_tx_abort          --------------------*---------
 
-mscan_read_error       -  -  -  -  *
+mscan_write_msg         *-******-***-*-***----***-****
 
-mscan_set_rcvsig       -  -  -  *  *
+mscan_write_nmsg        -*------*---***---****-*-***--
 
-mscan_set_xmtsig       -  -  -  *  -
+mscan_write_msg_exp     ---------------------*--------
 
-mscan_clr_rcvsig       -  -  -  *  *
+mscan_tx_expired        ---------------------*--------
 
-mscan_clr_xmtsig       -  -  -  *  -
+mscan_set_cyclic        ----------------------*-------
 
-mscan_queue_status     -  -  *  *  *
+mscan_set_tx_sched      ------------------**----------
 
-mscan_queue_clear      -  -  -  -  *
- txabort               -  -  -  -  -
+mscan_set_tx_param      ------------------*-----------
 
-mscan_clear_busoff     -  -  -  -  -
+mscan_read_error        ----*---*---------------*--*--
 
-mscan_enable		   ALL
- disable               -  -  *  -  -
+mscan_set_rcvsig        ---**-------------------------
 
-mscan_rtr              -  -  *  -  -
+mscan_set_xmtsig        ---*--------------------------
 
-mscan_set_loopback	   ALL	
+mscan_clr_rcvsig        ---**-------------------------
 
-mscan_node_status      -  -  -  -  -
+mscan_clr_xmtsig        ---*--------------------------
 
-mscan_error_counters   -  -  -  -  -
+mscan_queue_status      --**********-**-******-**-*-**
 
-mscan_errmsg           ALL
+mscan_queue_clear       ----*-----------*---*--***----
+ txabort                --------------------*---------
 
-mscan_errobj_msg       -  -  -  -  *
+mscan_clear_busoff      ------------------------------
+
+mscan_enable            ALL
+ disable                --*---------------------------
+
+mscan_rtr               --*---*-----------------------
+
+mscan_set_loopback      ALL
+
+mscan_node_status       ------------------------------
+
+mscan_error_counters    ------------------------------
+
+mscan_errmsg            ALL
+
+mscan_errobj_msg        ----*-------------------------
 
 */
 
@@ -271,6 +375,7 @@ int main( int argc, char *argv[] )
 	CHK( (path = mscan_init(device)) >= 0 );
 
 	CHK( M_setstat( path, MSCAN_MAXIRQTIME, 0 ) == 0 );
+	CHK( M_setstat( path, MSCAN_CLEARIRQSTAT, 0 ) == 0 );
 	/*--------------------+
     |  config             |
     +--------------------*/
@@ -289,7 +394,7 @@ int main( int argc, char *argv[] )
 	|  Perform tests     |
 	+-------------------*/
 	testlist  = ((str = UTL_TSTOPT("t=")) ? 
-				 str : "abcde"/*mnopqrstuvxyz"*/);
+				 str : "abcdefghijklmnopqrstuvwxyz1234");
 
 	for( tCode=testlist; *tCode; tCode++ ){
 
@@ -330,6 +435,27 @@ int main( int argc, char *argv[] )
 		CHK( M_getstat( path, MSCAN_MAXIRQTIME, (int32*)&maxIrqTime ) == 0 );
 		printf("Max irqtime=%d (internal ticks)\n", maxIrqTime );
 	}
+	{
+		MSCAN_IRQSTAT_PB st;
+		M_SG_BLOCK blk;
+		int i;
+
+		blk.size = sizeof(st);
+		blk.data = (void *)&st;
+		CHK( M_getstat( path, MSCAN_IRQSTAT, (int32*)&blk ) == 0 );
+
+		printf("Irqs=%d irqtime min=%d avg=%.1f max=%d (internal ticks)\n",
+			   st.count, st.minTime, st.count ? 
+			   (st.sumHigh * 4294967296.0 + st.sumLow) / st.count : 0.0, 
+			   st.maxTime );
+		for( i=0; i<MSCAN_IRQSTAT_TBINS; i++ )
+			if( st.timeHist[i] )
+				printf(" irqtime <2^%-2d: %d\n", i, st.timeHist[i] );
+		for( i=0; i<MSCAN_IRQSTAT_FBINS; i++ )
+			if( st.framesHist[i] )
+				printf(" %2d%s frames/irq: %d\n", i, 
+					   i==MSCAN_IRQSTAT_FBINS-1 ? "+":" ", st.framesHist[i] );
+	}
 
 	ret = 0;
 	CHK( mscan_enable( path, FALSE ) == 0 );
@@ -892,6 +1018,2422 @@ static int LoopbRxOverrun( MDIS_PATH path )
 	return rv;
 }
 
+/**********************************************************************/
+/** Test f: Hardware filter ranges
+ * 
+ * Sets the global filter with mscan_set_filter_ranges for the ranges
+ * - Std Ids 0x100..0x10f and 0x200
+ * - Ext Ids 0x18feef00..0x18feefff
+ * in each filter mode, then without any range. Rx objects pass all IDs:
+ * - Obj 1: Std Id  ALL
+ * - Obj 2: Ext Id  ALL
+ *
+ * Checks that mscan_filter_info reports the wanted IDs and not less 
+ * accepted IDs, that all frames inside the ranges are received once, 
+ * and that frames outside are not received where the hardware filter 
+ * is exact (accepted == wanted).
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbHwFiltRanges( MDIS_PATH path )
+{
+	static const MSCAN_IDRANGE rng[] = {
+		/* first, last, flags */
+		{ 0x100, 0x10f, 0 },
+		{ 0x200, 0x200, 0 },
+		{ 0x18feef00, 0x18feefff, MSCAN_EXTENDED }
+	};
+	static const MSCAN_HWFILT_MODE mode[] = {
+		MSCAN_HWFILT_2X32, MSCAN_HWFILT_4X16, MSCAN_HWFILT_8X8,
+		MSCAN_HWFILT_AUTO
+	};
+	/* frames to send, the first nInside are inside the ranges */
+	static const MSCAN_FRAME txFrm[] = {
+		/* ID,  flags,          dlen, data */
+		{ 0x100, 0,				0,   { 0 } },
+		{ 0x10f, 0,				0,   { 0 } },
+		{ 0x200, 0,				0,   { 0 } },
+		{ 0x18feef00, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x18feefff, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x0ff, 0,				0,   { 0 } },
+		{ 0x110, 0,				0,   { 0 } },
+		{ 0x201, 0,				0,   { 0 } },
+		{ 0x7ff, 0,				0,   { 0 } },
+		{ 0x18feeeff, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x18fef000, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x200, MSCAN_EXTENDED,	0,   { 0 } }
+	};
+	const int nInside = 5;
+	const int nTx = sizeof(txFrm)/sizeof(MSCAN_FRAME);
+	const int txObj=8, rxObj1=1, rxObj2=2;
+	u_int32 must[sizeof(txFrm)/sizeof(MSCAN_FRAME)];
+	u_int32 may[sizeof(txFrm)/sizeof(MSCAN_FRAME)];
+	int m, i, exact, rv = -1;
+	u_int32 nRng, rxBit;
+	MSCAN_HWFILT_MODE md;
+	MSCAN_HWFILT_INFO info, info2;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj1, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, rxObj2, MSCAN_DIR_RCV, 20, 
+						   &G_extOpenFilter ) == 0 );
+
+	/* last run without ranges: everything rejected */
+	for( m=0; m<=sizeof(mode)/sizeof(mode[0]); m++ ){
+		nRng = (m < sizeof(mode)/sizeof(mode[0])) ? 3 : 0;
+		md	 = nRng ? mode[m] : MSCAN_HWFILT_AUTO;
+
+		CHK( mscan_set_filter_ranges( path, md, nRng, rng, &info ) == 0 );
+		CHK( mscan_filter_info( path, &info2 ) == 0 );
+		CHK( memcmp( &info, &info2, sizeof(info) ) == 0 );
+
+		printf(" mode %d->%ld: std %ld/%ld ext %ld/%ld precision %ld\n", 
+			   md, info.mode, info.stdWanted, info.stdAccepted,
+			   info.extWanted, info.extAccepted, info.precision );
+
+		if( nRng == 0 ){
+			CHK( info.mode == MSCAN_HWFILT_CLOSED );
+		}
+		else if( md == MSCAN_HWFILT_AUTO ){
+			CHK( info.mode <= MSCAN_HWFILT_8X8 );
+		}
+		else {
+			CHK( info.mode == md );
+		}
+
+		CHK( info.stdWanted == (nRng ? 0x11 : 0) );
+		CHK( info.extWanted == (nRng ? 0x100 : 0) );
+		CHK( info.stdAccepted >= info.stdWanted );
+		CHK( info.extAccepted >= info.extWanted );
+
+		/*--- send frames and check which ones got through ---*/
+		for( i=0; i<nTx; i++ ){
+			if( txFrm[i].flags & MSCAN_EXTENDED ){
+				rxBit = 1 << rxObj2;
+				exact = (info.extAccepted == info.extWanted);
+			}
+			else {
+				rxBit = 1 << rxObj1;
+				exact = (info.stdAccepted == info.stdWanted);
+			}
+			must[i] = (nRng && (i < nInside)) ? rxBit : 0;
+			may[i]	= exact ? 0 : rxBit;
+		}
+		CHK( SendCheck( path, txObj, txFrm, nTx, 
+						(1 << rxObj1) | (1 << rxObj2), must, may ) == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test g: Rx filter rules
+ * 
+ * Configures the Rx objects
+ * - Obj 1: Std Id  0x300 with the filter rules
+ *   - Std Ids 0x100..0x17f and 0x230
+ *   - Ext Ids 0x18fe0000 code, 0x0000ffff mask
+ *   - Ext Ids 0x1000..0x1003
+ * - Obj 2: Std Id  ALL
+ * - Obj 3: Ext Id  ALL
+ *
+ * Checks that frames matching the rules (including RTR frames) go to
+ * obj 1 only, and all others to obj 2/3. Then clears the rules and
+ * checks that obj 1 receives 0x300 again. Finally disables obj 2/3,
+ * sets the rules again and calls mscan_filter_auto. Checks the wanted
+ * IDs reported by mscan_filter_info and that only frames matching the
+ * rules are received.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxRules( MDIS_PATH path )
+{
+	static const MSCAN_FILTER filter300 = {
+		0x300,
+		0x00000000,
+		0,
+		0 
+	};
+	static const MSCAN_FILTER_RULE rules[] = {
+		/* type, flags, code, mask */
+		{ MSCAN_RULE_RANGE, 0, 0x100, 0x17f },
+		{ MSCAN_RULE_RANGE, 0, 0x230, 0x230 },
+		{ MSCAN_RULE_MASK, MSCAN_EXTENDED, 0x18fe0000, 0x0000ffff },
+		{ MSCAN_RULE_RANGE, MSCAN_EXTENDED, 0x1000, 0x1003 }
+	};
+	/* frames to send, the first nInside match the rules */
+	static const MSCAN_FRAME txFrm[] = {
+		/* ID,  flags,          dlen, data */
+		{ 0x100, 0,				0,   { 0 } },
+		{ 0x17f, 0,				0,   { 0 } },
+		{ 0x230, 0,				0,   { 0 } },
+		{ 0x150, MSCAN_RTR,		0,   { 0 } },
+		{ 0x18fe0000, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x18feffff, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x1000, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x1003, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x0ff, 0,				0,   { 0 } },
+		{ 0x180, 0,				0,   { 0 } },
+		{ 0x22f, 0,				0,   { 0 } },
+		{ 0x231, 0,				0,   { 0 } },
+		{ 0x300, 0,				0,   { 0 } },
+		{ 0x18fd0000, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x18ff0000, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0xfff, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x1004, MSCAN_EXTENDED,	0,   { 0 } }
+	};
+	const int nInside = 8, idx300 = 12;
+	const int nRules = sizeof(rules)/sizeof(MSCAN_FILTER_RULE);
+	const int nTx = sizeof(txFrm)/sizeof(MSCAN_FRAME);
+	const int txObj=8, rxObj1=1, rxObj2=2, rxObj3=3;
+	u_int32 must[sizeof(txFrm)/sizeof(MSCAN_FRAME)];
+	int run, i, rv = -1;
+	MSCAN_HWFILT_INFO info;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj1, MSCAN_DIR_RCV, 20, 
+						   &filter300 ) == 0 );
+	CHK( mscan_config_msg( path, rxObj2, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, rxObj3, MSCAN_DIR_RCV, 20, 
+						   &G_extOpenFilter ) == 0 );
+	CHK( mscan_set_filter_rules( path, rxObj1, nRules, rules ) == 0 );
+
+	/* run 0: rules, run 1: config filter, run 2: rules + auto filter */
+	for( run=0; run<3; run++ ){
+		if( run == 1 ){
+			CHK( mscan_set_filter_rules( path, rxObj1, 0, NULL ) == 0 );
+		}
+		if( run == 2 ){
+			CHK( mscan_config_msg( path, rxObj2, MSCAN_DIR_DIS, 0, 
+								   NULL ) == 0 );
+			CHK( mscan_config_msg( path, rxObj3, MSCAN_DIR_DIS, 0, 
+								   NULL ) == 0 );
+			CHK( mscan_set_filter_rules( path, rxObj1, nRules, 
+										 rules ) == 0 );
+			CHK( mscan_filter_auto( path, MSCAN_HWFILT_AUTO ) == 0 );
+			CHK( mscan_filter_info( path, &info ) == 0 );
+
+			printf(" auto filter %ld: std %ld/%ld ext %ld/%ld\n", 
+				   info.mode, info.stdWanted, info.stdAccepted,
+				   info.extWanted, info.extAccepted );
+
+			CHK( info.stdWanted == 0x81 );
+			CHK( info.extWanted == 0x10004 );
+			CHK( info.stdAccepted >= info.stdWanted );
+			CHK( info.extAccepted >= info.extWanted );
+		}
+
+		for( i=0; i<nTx; i++ ){
+			if( (run == 1) ? (i == idx300) : (i < nInside) )
+				must[i] = 1 << rxObj1;
+			else if( run == 2 )
+				must[i] = 0;			/* obj 2/3 disabled */
+			else if( txFrm[i].flags & MSCAN_EXTENDED )
+				must[i] = 1 << rxObj3;
+			else
+				must[i] = 1 << rxObj2;
+		}
+		CHK( SendCheck( path, txObj, txFrm, nTx, (run < 2) ? 
+						(1 << rxObj1) | (1 << rxObj2) | (1 << rxObj3) :
+						(1 << rxObj1), must, NULL ) == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test h: Shared Rx objects
+ * 
+ * Configures the Rx objects
+ * - Obj 1: Std Id  ALL (shared)
+ * - Obj 2: Std Id  0x100..0x1ff
+ * - Obj 3: Std Id  ALL
+ * - Obj 4: Std Id  0x180..0x1ff (shared)
+ *
+ * Checks that the shared objects receive a copy of each matching frame
+ * and the first matching non-shared object receives the frame as well.
+ * Then makes obj 1 non-shared and checks that obj 2/3 no longer 
+ * receive frames, but obj 4 still does. Also checks that 
+ * mscan_set_shared fails on a Tx object.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxShared( MDIS_PATH path )
+{
+	static const MSCAN_FILTER filter1xx = {
+		0x100,
+		0x000000ff,
+		0,
+		0 
+	};
+	static const MSCAN_FILTER filter18x = {
+		0x180,
+		0x0000007f,
+		0,
+		0 
+	};
+	static const MSCAN_FRAME txFrm[] = {
+		/* ID,  flags,          dlen, data */
+		{ 0x100, 0,				0,   { 0 } },
+		{ 0x180, 0,				0,   { 0 } },
+		{ 0x050, 0,				0,   { 0 } },
+		{ 0x1ff, 0,				0,   { 0 } },
+		{ 0x7ff, 0,				0,   { 0 } }
+	};
+	/* expected receivers per frame (bit n: obj n), obj 1 shared/not */
+	static const u_int32 expShared[] = { 0x06, 0x16, 0x0a, 0x16, 0x0a };
+	static const u_int32 expExcl[]	 = { 0x02, 0x12, 0x02, 0x12, 0x02 };
+	const int nTx = sizeof(txFrm)/sizeof(MSCAN_FRAME);
+	const int txObj=8;
+	int run, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+	CHK( mscan_config_msg( path, 1, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, 2, MSCAN_DIR_RCV, 20, &filter1xx ) == 0 );
+	CHK( mscan_config_msg( path, 3, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, 4, MSCAN_DIR_RCV, 20, &filter18x ) == 0 );
+
+	CHK( mscan_set_shared( path, 1, TRUE ) == 0 );
+	CHK( mscan_set_shared( path, 4, TRUE ) == 0 );
+	CHK( mscan_set_shared( path, txObj, TRUE ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	/* run 0: obj 1 shared, run 1: obj 1 not shared */
+	for( run=0; run<2; run++ ){
+		if( run == 1 ){
+			CHK( mscan_set_shared( path, 1, FALSE ) == 0 );
+		}
+		CHK( SendCheck( path, txObj, txFrm, nTx, 0x1e, 
+						run ? expExcl : expShared, NULL ) == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test i: Rx FIFO drain per irq
+ * 
+ * Sends a burst of frames with mscan_write_nmsg, once with a budget 
+ * (MSCAN_RXDRAINMAX) of one frame per irq, once with the previous 
+ * budget. Checks that the max. frames read per irq (MSCAN_RXIRQFRAMES)
+ * is within the budget. With the previous budget, also checks that
+ * - all frames are received in order
+ * - no error (e.g. MSCAN_DATA_OVERRUN) is put into the error object
+ *
+ * Also checks that a budget of 0 is rejected.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxDrain( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nBurst 50
+	MSCAN_FRAME txFrm[nBurst], rxFrm[nBurst];
+	int32 drainMax=0, budget, irqFrames, n;
+	u_int32 entries, errCode, objNr;
+	int run, i, rv = -1;
+
+	CHK( M_getstat( path, MSCAN_RXDRAINMAX, &drainMax ) == 0 );
+	CHK( drainMax >= 1 );
+	CHK( M_setstat( path, MSCAN_RXDRAINMAX, 0 ) == -1 );
+	CHK( UOS_ErrnoGet() == ERR_LL_ILL_PARAM );
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nBurst, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nBurst, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( i=0; i<nBurst; i++ ){
+		txFrm[i].id = 0x100 + i;
+		txFrm[i].flags = 0;
+		txFrm[i].dataLen = 0;
+	}
+
+	/* run 0: one frame per irq, run 1: previous budget */
+	for( run=0; run<2; run++ ){
+		budget = run ? drainMax : 1;
+		CHK( M_setstat( path, MSCAN_RXDRAINMAX, budget ) == 0 );
+		CHK( M_setstat( path, MSCAN_RXIRQFRAMES, 0 ) == 0 );
+
+		/* empty error object */
+		CHK( mscan_queue_status( path, 0, &entries, NULL ) == 0 );
+		while( entries-- )
+			CHK( mscan_read_error( path, &errCode, &objNr ) == 0 );
+
+		CHK( mscan_write_nmsg( path, txObj, nBurst, txFrm ) == nBurst );
+		do {
+			CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+		} while( entries != nBurst );
+		UOS_Delay( 100 );			/* last frames received */
+
+		CHK( (n = mscan_read_nmsg( path, rxObj, nBurst, rxFrm )) >= 0 );
+		CHK( M_getstat( path, MSCAN_RXIRQFRAMES, &irqFrames ) == 0 );
+		printf(" budget %d: %d frames received, max. %d per irq\n", 
+			   budget, n, irqFrames);
+		CHK( irqFrames >= 1 && irqFrames <= budget );
+
+		/* with one frame per irq, frames are lost if the irq is late */
+		if( run == 0 )
+			continue;
+
+		CHK( n == nBurst );
+		for( i=0; i<nBurst; i++ ){
+			if( CmpFrames( &rxFrm[i], &txFrm[i] ) != 0 ){
+				printf("Incorrect Frame received\n");
+				DumpFrame( "Exp.", &txFrm[i] );
+				DumpFrame( "Recv", &rxFrm[i] );
+				CHK(0);
+			}
+		}
+		CHK( mscan_queue_status( path, 0, &entries, NULL ) == 0 );
+		CHK( entries == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	if( drainMax >= 1 )
+		M_setstat( path, MSCAN_RXDRAINMAX, drainMax );
+	ObjsDisable( path );
+
+	return rv;
+	#undef nBurst
+}
+
+/**********************************************************************/
+/** Test j: Rx dispatch with overlapping filters
+ * 
+ * Configures the Rx objects
+ * - Obj 1: Std Id  0x120, no RTR
+ * - Obj 2: Std Id  0x120, RTR only
+ * - Obj 3: Std Id  0x100..0x1ff
+ * - Obj 4: Std Id  ALL
+ * - Obj 5: Ext Id  0x18feef01
+ * - Obj 6: Ext Id  0x1000..0x10ff
+ * - Obj 7: Ext Id  ALL
+ *
+ * Checks that each frame is received only by the lowest matching 
+ * object. Then disables obj 3 and 6 and checks that their frames go to 
+ * obj 4 and 7 instead, and that they are received by obj 3 and 6 again
+ * after configuring them again.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxDispatch( MDIS_PATH path )
+{
+	static const MSCAN_FILTER flt[] = { 
+		/* code, mask, cflags, mflags */
+		{ 0x120, 0x000, 0, MSCAN_RTR },					/* obj1 */
+		{ 0x120, 0x000, MSCAN_RTR, MSCAN_RTR },			/* obj2 */
+		{ 0x100, 0x0ff, 0, 0 },							/* obj3 */
+		{ 0x000, 0xffffffff, 0, 0 },					/* obj4 */
+		{ 0x18feef01, 0x000, MSCAN_EXTENDED, 0 },		/* obj5 */
+		{ 0x1000, 0x0ff, MSCAN_EXTENDED, 0 },			/* obj6 */
+		{ 0x000, 0xffffffff, MSCAN_EXTENDED, 0 }		/* obj7 */
+	};
+	static const MSCAN_FRAME txFrm[] = {
+		/* ID,  flags,          dlen, data */
+		{ 0x120, 0,				1,   { 0x01 } },
+		{ 0x120, MSCAN_RTR,		0,   { 0 } },
+		{ 0x121, 0,				2,   { 0x02, 0x03 } },
+		{ 0x1ff, MSCAN_RTR,		0,   { 0 } },
+		{ 0x000, 0,				0,   { 0 } },
+		{ 0x7ff, 0,				0,   { 0 } },
+		{ 0x200, 0,				0,   { 0 } },
+		{ 0x18feef01, MSCAN_EXTENDED, 8, { 1, 2, 3, 4, 5, 6, 7, 8 } },
+		{ 0x18feef01, MSCAN_EXTENDED | MSCAN_RTR, 0, { 0 } },
+		{ 0x1000, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x10ff, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x18feef00, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x120, MSCAN_EXTENDED,	0,   { 0 } },
+		{ 0x1fffffff, MSCAN_EXTENDED, 0, { 0 } }
+	};
+	/* receiving object per frame with all objects configured */
+	static const int expObj[] = { 1, 2, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 7, 7 };
+	const int nTx = sizeof(txFrm)/sizeof(MSCAN_FRAME);
+	const int txObj=8;
+	u_int32 must[sizeof(txFrm)/sizeof(MSCAN_FRAME)];
+	int run, i, obj, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+	for( obj=1; obj<=7; obj++ )
+		CHK( mscan_config_msg( path, obj, MSCAN_DIR_RCV, 20, 
+							   &flt[obj-1] ) == 0 );
+
+	/* run 0: all objects, run 1: obj 3/6 disabled, run 2: obj 3/6 again */
+	for( run=0; run<3; run++ ){
+		if( run == 1 ){
+			CHK( mscan_config_msg( path, 3, MSCAN_DIR_DIS, 0, NULL ) == 0 );
+			CHK( mscan_config_msg( path, 6, MSCAN_DIR_DIS, 0, NULL ) == 0 );
+		}
+		if( run == 2 ){
+			CHK( mscan_config_msg( path, 3, MSCAN_DIR_RCV, 20, 
+								   &flt[3-1] ) == 0 );
+			CHK( mscan_config_msg( path, 6, MSCAN_DIR_RCV, 20, 
+								   &flt[6-1] ) == 0 );
+		}
+
+		for( i=0; i<nTx; i++ ){
+			obj = expObj[i];
+			if( run == 1 && (obj == 3 || obj == 6) )
+				obj++;				/* next matching object */
+			must[i] = 1 << obj;
+		}
+		CHK( SendCheck( path, txObj, txFrm, nTx, 0xfe, must, NULL ) == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test k: All message objects
+ * 
+ * Gets the number of message objects (NUM_OBJS descriptor key) with
+ * M_LL_CH_NUMBER and configures
+ * - Obj 1..NUM_OBJS-2: Rx, Std Id  same as object number
+ * - Obj NUM_OBJS-1:	Tx
+ *
+ * Sends one frame to each Rx object and checks that it is received 
+ * there. Checks that object number NUM_OBJS is rejected.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbNumObjs( MDIS_PATH path )
+{
+	int32 numObjs;
+	int obj, txObj, nRx=0, rv = -1;
+	MSCAN_FRAME *txFrm=NULL, rxFrm[2];
+	MSCAN_FILTER flt;
+
+	CHK( M_getstat( path, M_LL_CH_NUMBER, &numObjs ) == 0 );
+	printf(" %d message objects\n", numObjs);
+	CHK( numObjs >= 3 );
+
+	txObj = numObjs - 1;
+	nRx	  = numObjs - 2;
+	CHK( (txFrm = (MSCAN_FRAME *)malloc( nRx * sizeof(MSCAN_FRAME) )) 
+		 != NULL );
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+
+	flt.mask   = 0x000;
+	flt.cflags = 0;
+	flt.mflags = 0;
+	for( obj=1; obj<=nRx; obj++ ){
+		flt.code = obj;
+		CHK( mscan_config_msg( path, obj, MSCAN_DIR_RCV, 2, &flt ) == 0 );
+
+		txFrm[obj-1].id		 = obj;
+		txFrm[obj-1].flags	 = 0;
+		txFrm[obj-1].dataLen = 1;
+		txFrm[obj-1].data[0] = obj & 0xff;
+	}
+
+	/* objects beyond NUM_OBJS */
+	CHK( mscan_config_msg( path, numObjs, MSCAN_DIR_RCV, 2, 
+						   &G_stdOpenFilter ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADMSGNUM );
+	CHK( mscan_read_nmsg( path, numObjs, 2, rxFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADMSGNUM );
+
+	CHK( SendAll( path, txObj, txFrm, nRx ) == 0 );
+
+	for( obj=1; obj<=nRx; obj++ ){
+		if( mscan_read_nmsg( path, obj, 2, rxFrm ) != 1 ||
+			CmpFrames( &rxFrm[0], &txFrm[obj-1] ) != 0 ){
+			printf("Rx object %d: frame not received once\n", obj);
+			DumpFrame( "Sent", &txFrm[obj-1] );
+			CHK(0);
+		}
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+	if( txFrm )
+		free( txFrm );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test l: FIFO sizes and wrap around
+ * 
+ * Configures FIFO sizes that are no power of two:
+ * - Obj 1: Rx, 5 entries, Std Id  ALL
+ * - Obj 8: Tx, 3 entries
+ *
+ * Checks that mscan_queue_status reports exactly these sizes. Then sends
+ * 1..5 frames per round, so that the FIFO read and write positions 
+ * wrap at different places, and reads them back in two parts. Checks 
+ * that all frames are received in order.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbFifoWrap( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1, rxEntries=5, txEntries=3;
+	MSCAN_FRAME txFrm[5], rxFrm[5];
+	u_int32 entries, seq=0;
+	int round, n, got, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, txEntries, 
+						   NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, rxEntries, 
+						   &G_stdOpenFilter ) == 0 );
+
+	CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+	CHK( entries == txEntries );
+	CHK( mscan_queue_status( path, rxObj, &entries, NULL ) == 0 );
+	CHK( entries == 0 );
+
+	for( round=0; round<20; round++ ){
+		n = 1 + round % rxEntries;
+
+		for( i=0; i<n; i++, seq++ ){
+			txFrm[i].id		 = 0x200 + (seq & 0xff);
+			txFrm[i].flags	 = 0;
+			txFrm[i].dataLen = 2;
+			txFrm[i].data[0] = (u_int8)(seq >> 8);
+			txFrm[i].data[1] = (u_int8)seq;
+		}
+		CHK( SendAll( path, txObj, txFrm, n ) == 0 );
+
+		CHK( mscan_queue_status( path, rxObj, &entries, NULL ) == 0 );
+		CHK( entries == n );
+
+		/* read in two parts */
+		CHK( (got = mscan_read_nmsg( path, rxObj, (n+1)/2, rxFrm )) == 
+			 (n+1)/2 );
+		CHK( mscan_read_nmsg( path, rxObj, rxEntries, &rxFrm[got] ) == 
+			 n - got );
+
+		for( i=0; i<n; i++ ){
+			if( CmpFrames( &rxFrm[i], &txFrm[i] ) != 0 ){
+				printf("round %d: Incorrect Frame received\n", round);
+				DumpFrame( "Exp.", &txFrm[i] );
+				DumpFrame( "Recv", &rxFrm[i] );
+				CHK(0);
+			}
+		}
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test m: Read while receiving
+ * 
+ * - Obj 1: Rx, 200 entries, Std Id  ALL
+ * - Obj 8: Tx, 200 entries
+ *
+ * Queues 200 frames with one mscan_write_nmsg call and reads Obj 1 in 
+ * chunks of up to 7 frames while the irq routine still fills it. Checks
+ * that every frame is received exactly once and in order.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxConcurrent( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 200
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	u_int32 startTime;
+	int32 n;
+	int got=0, reads=0, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x300 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 1;
+		txFrm[i].data[0] = (u_int8)i;
+	}
+
+	CHK( mscan_write_nmsg( path, txObj, nFrm, txFrm ) == nFrm );
+
+	startTime = UOS_MsecTimerGet();
+	while( got < nFrm && UOS_MsecTimerGet() - startTime < 2000 ){
+		n = nFrm - got;
+		if( n > 7 )
+			n = 7;
+
+		CHK( (n = mscan_read_nmsg( path, rxObj, n, &rxFrm[got] )) >= 0 );
+		if( n ){
+			got += n;
+			reads++;
+		}
+	}
+	printf(" %d frames received with %d reads\n", got, reads);
+	CHK( got == nFrm );
+
+	for( i=0; i<nFrm; i++ ){
+		if( CmpFrames( &rxFrm[i], &txFrm[i] ) != 0 ){
+			printf("Incorrect Frame received\n");
+			DumpFrame( "Exp.", &txFrm[i] );
+			DumpFrame( "Recv", &rxFrm[i] );
+			CHK(0);
+		}
+	}
+
+	/* no duplicates left */
+	UOS_Delay( 100 );
+	CHK( mscan_read_nmsg( path, rxObj, 1, rxFrm ) == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test n: Blocking batch read
+ * 
+ * - Obj 1: Rx, 20 entries, Std Id  ALL
+ * - Obj 8: Tx, 20 entries
+ *
+ * Checks mscan_read_nmsg_timeout:
+ * - no wait with timeout -1, ERR_OSS_TIMEOUT if no frame arrives
+ * - waits until \a minFrames frames are queued
+ * - returns less than \a minFrames frames on timeout
+ * - returns at most \a maxFrames frames
+ * - \a minFrames is limited to the FIFO size
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbReadTimeout( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 20
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	u_int32 startTime, elapsed;
+	int i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x400 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 0;
+	}
+
+	/* wrong direction */
+	CHK( mscan_read_nmsg_timeout( path, txObj, 1, 1, -1, rxFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	/* empty FIFO */
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 1, nFrm, -1, rxFrm ) == 0 );
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 1, nFrm, 100, rxFrm ) 
+		 == -1 );
+	CHK( UOS_ErrnoGet() == ERR_OSS_TIMEOUT );
+
+	/* wait for 10 frames still being sent */
+	CHK( mscan_write_nmsg( path, txObj, 10, txFrm ) == 10 );
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 10, nFrm, 2000, rxFrm ) 
+		 == 10 );
+	for( i=0; i<10; i++ )
+		CHK( CmpFrames( &rxFrm[i], &txFrm[i] ) == 0 );
+
+	/* timeout with less than minFrames */
+	CHK( SendAll( path, txObj, txFrm, 3 ) == 0 );
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 5, nFrm, 200, rxFrm ) 
+		 == 3 );
+
+	/* maxFrames limits */
+	CHK( SendAll( path, txObj, txFrm, 6 ) == 0 );
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 2, 4, 1000, rxFrm ) == 4 );
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 0, nFrm, 1000, &rxFrm[4] )
+		 == 2 );
+	for( i=0; i<6; i++ )
+		CHK( CmpFrames( &rxFrm[i], &txFrm[i] ) == 0 );
+
+	/* minFrames beyond FIFO size: returns when FIFO full */
+	CHK( mscan_write_nmsg( path, txObj, nFrm, txFrm ) == nFrm );
+	startTime = UOS_MsecTimerGet();
+	CHK( mscan_read_nmsg_timeout( path, rxObj, 100, nFrm, 5000, rxFrm ) 
+		 == nFrm );
+	elapsed = UOS_MsecTimerGet() - startTime;
+	printf(" FIFO full after %d ms\n", elapsed );
+	CHK( elapsed < 4000 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test o: Batch I/O in one call
+ * 
+ * - Obj 1: Rx, 20 entries, Std Id  ALL
+ * - Obj 8: Tx, 4 entries
+ *
+ * Checks that mscan_write_nmsg and mscan_read_nmsg leave the current 
+ * channel (M_MK_CH_CURRENT) of the path alone, and that 
+ * mscan_write_nmsg returns the number of frames that fit into the FIFO,
+ * so the rest can be written with further calls.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbNMsgCall( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1, txEntries=4, chCur=3;
+	#define nFrm 10
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	u_int32 entries;
+	int32 ch, n;
+	int sent, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, txEntries, 
+						   NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm+nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( M_setstat( path, M_MK_CH_CURRENT, chCur ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x500 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 1;
+		txFrm[i].data[0] = (u_int8)~i;
+	}
+
+	/* first call queues only what fits into the FIFO */
+	CHK( (n = mscan_write_nmsg( path, txObj, nFrm, txFrm )) >= txEntries );
+	CHK( n < nFrm );
+	printf(" first write_nmsg: %d frames queued\n", n);
+
+	for( sent=n; sent<nFrm; sent+=n )
+		CHK( (n = mscan_write_nmsg( path, txObj, nFrm-sent, 
+									&txFrm[sent] )) >= 0 );
+
+	do {
+		CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+	} while( entries != txEntries );
+	UOS_Delay( 100 );			/* last frames received */
+
+	CHK( mscan_read_nmsg( path, rxObj, nFrm+nFrm, rxFrm ) == nFrm );
+	for( i=0; i<nFrm; i++ ){
+		if( CmpFrames( &rxFrm[i], &txFrm[i] ) != 0 ){
+			printf("Incorrect Frame received\n");
+			DumpFrame( "Exp.", &txFrm[i] );
+			DumpFrame( "Recv", &rxFrm[i] );
+			CHK(0);
+		}
+	}
+
+	/* also after a failed call */
+	CHK( mscan_read_nmsg( path, txObj, 1, rxFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	CHK( M_getstat( path, M_MK_CH_CURRENT, &ch ) == 0 );
+	CHK( ch == chCur );
+
+	rv = 0;
+ ABORT:
+	M_setstat( path, M_MK_CH_CURRENT, 0 );
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test p: Receive timestamps
+ * 
+ * - Obj 1: Rx, 10 entries, Std Id  ALL
+ * - Obj 8: Tx, 10 entries
+ *
+ * Sends 10 frames 20ms apart and reads them with mscan_read_msg_ts and
+ * mscan_read_nmsg_ts. Checks that the timestamps do not decrease and 
+ * that the time between first and last frame is plausible 
+ * (see mscan_ts_freq).
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxTimestamps( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 10
+	MSCAN_FRAME txFrm[nFrm];
+	MSCAN_FRAME_TS rxFrm[nFrm];
+	u_int32 freq, span, ms;
+	int i, rv = -1;
+
+	CHK( mscan_ts_freq( path, &freq ) == 0 );
+	CHK( freq != 0 );
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x600 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 0;
+
+		CHK( mscan_write_msg( path, txObj, 1000, &txFrm[i] ) == 0 );
+		UOS_Delay( 20 );
+	}
+
+	CHK( mscan_read_msg_ts( path, rxObj, 1000, &rxFrm[0] ) == 0 );
+	CHK( mscan_read_nmsg_ts( path, rxObj, nFrm-1, nFrm, 1000, 
+							 &rxFrm[1] ) == nFrm-1 );
+
+	for( i=0; i<nFrm; i++ ){
+		if( CmpFrames( &rxFrm[i].frm, &txFrm[i] ) != 0 ){
+			printf("Incorrect Frame received\n");
+			DumpFrame( "Exp.", &txFrm[i] );
+			DumpFrame( "Recv", &rxFrm[i].frm );
+			CHK(0);
+		}
+		if( i && (rxFrm[i].tsHigh < rxFrm[i-1].tsHigh ||
+				  (rxFrm[i].tsHigh == rxFrm[i-1].tsHigh && 
+				   rxFrm[i].tsLow < rxFrm[i-1].tsLow)) ){
+			printf("Frame %d: timestamp 0x%08x%08x before 0x%08x%08x\n",
+				   i, rxFrm[i].tsHigh, rxFrm[i].tsLow, 
+				   rxFrm[i-1].tsHigh, rxFrm[i-1].tsLow );
+			CHK(0);
+		}
+	}
+
+	/* 9 gaps of at least 20ms, span fits into 32 bit */
+	span = rxFrm[nFrm-1].tsLow - rxFrm[0].tsLow;
+	CHK( rxFrm[nFrm-1].tsHigh - rxFrm[0].tsHigh == 
+		 (rxFrm[nFrm-1].tsLow < rxFrm[0].tsLow ? 1 : 0) );
+	ms = freq >= 1000 ? span / (freq / 1000) : span * 1000 / freq;
+	printf(" ts freq %u Hz, %d ms between first and last frame\n", 
+		   freq, ms );
+	CHK( ms >= 100 && ms <= 2000 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test q: Transmit confirmation
+ * 
+ * - Obj 1: Rx, 10 entries, Std Id  ALL
+ * - Obj 8: Tx, 10 entries
+ *
+ * Run 0: confirmation ring of 16 entries. Checks that each sent frame
+ *        is confirmed once, with its sequence number, ID and flags and
+ *        completion times that do not decrease.
+ * Run 1: confirmation ring of 4 entries. Checks that the first 4 frames
+ *        are confirmed and the others counted as lost.
+ *
+ * Also checks the errors of mscan_txconf_enable/mscan_read_txconf and 
+ * that mscan_config_msg disables the confirmation.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxConf( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 10
+	MSCAN_FRAME txFrm[nFrm];
+	MSCAN_TXCONF conf[16];
+	u_int32 lost;
+	int32 n;
+	int run, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	CHK( mscan_read_txconf( path, txObj, 16, conf, &lost ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_NOTINIT );
+	CHK( mscan_txconf_enable( path, rxObj, 16 ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x700 + i;
+		txFrm[i].flags	 = (i & 1) ? MSCAN_RTR : 0;
+		txFrm[i].dataLen = 0;
+	}
+
+	for( run=0; run<2; run++ ){
+		CHK( mscan_txconf_enable( path, txObj, run ? 4 : 16 ) == 0 );
+		CHK( SendAll( path, txObj, txFrm, nFrm ) == 0 );
+		CHK( mscan_queue_clear( path, rxObj, 0 ) == 0 );
+
+		CHK( (n = mscan_read_txconf( path, txObj, 16, conf, &lost )) >= 0 );
+		printf(" %d confirmations, %d lost\n", n, lost);
+		CHK( n == (run ? 4 : nFrm) );
+		CHK( n + lost == nFrm );
+
+		for( i=0; i<n; i++ ){
+			/* sequence numbers count on over both runs */
+			if( conf[i].seq != run * nFrm + i ||
+				conf[i].id != txFrm[i].id || 
+				conf[i].flags != txFrm[i].flags ||
+				(i && (conf[i].tsHigh < conf[i-1].tsHigh ||
+					   (conf[i].tsHigh == conf[i-1].tsHigh && 
+						conf[i].tsLow < conf[i-1].tsLow))) ){
+				printf("Confirmation %d: seq %d id 0x%x flags 0x%x "
+					   "ts 0x%08x%08x\n", i, conf[i].seq, conf[i].id, 
+					   conf[i].flags, conf[i].tsHigh, conf[i].tsLow);
+				CHK(0);
+			}
+		}
+
+		/* all read */
+		CHK( mscan_read_txconf( path, txObj, 16, conf, &lost ) == 0 );
+		CHK( lost == 0 );
+	}
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_read_txconf( path, txObj, 16, conf, &lost ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_NOTINIT );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test r: ISR statistics
+ * 
+ * - Obj 1: Rx, 20 entries, Std Id  ALL
+ * - Obj 8: Tx, 20 entries
+ *
+ * Sends 20 frames and compares the MSCAN_IRQSTAT block before and 
+ * after. Checks that:
+ * - irqs have been measured and both histograms count each of them
+ * - the frames per irq histogram accounts for the 20 Rx frames
+ * - the sum of ISR times lies between count*min and count*max
+ * - min/max match the lowest/highest time histogram bin and 
+ *   MSCAN_MAXIRQTIME
+ *
+ * The statistics are not cleared, since main prints them at the end.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbIrqStat( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 20
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	MSCAN_IRQSTAT_PB st[2];
+	M_SG_BLOCK blk;
+	u_int32 maxIrqTime, cnt, tCnt, fCnt, rxCnt, sum, v;
+	int i, lo, hi, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x080 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 0;
+	}
+
+	blk.size = sizeof(st[0]);
+	blk.data = (void *)&st[0];
+	CHK( M_getstat( path, MSCAN_IRQSTAT, (int32*)&blk ) == 0 );
+
+	CHK( SendAll( path, txObj, txFrm, nFrm ) == 0 );
+	CHK( mscan_read_nmsg( path, rxObj, nFrm, rxFrm ) == nFrm );
+
+	blk.data = (void *)&st[1];
+	CHK( M_getstat( path, MSCAN_IRQSTAT, (int32*)&blk ) == 0 );
+	CHK( M_getstat( path, MSCAN_MAXIRQTIME, (int32*)&maxIrqTime ) == 0 );
+
+	/* this test's irqs */
+	cnt = st[1].count - st[0].count;
+	for( i=0, tCnt=0; i<MSCAN_IRQSTAT_TBINS; i++ )
+		tCnt  += st[1].timeHist[i] - st[0].timeHist[i];
+	for( i=0, fCnt=rxCnt=0; i<MSCAN_IRQSTAT_FBINS; i++ ){
+		fCnt  += st[1].framesHist[i] - st[0].framesHist[i];
+		rxCnt += i * (st[1].framesHist[i] - st[0].framesHist[i]);
+	}
+	sum = st[1].sumLow - st[0].sumLow;
+	printf(" %d irqs, %d Rx frames, ISR time sum %d\n", cnt, rxCnt, sum);
+
+	CHK( cnt >= 1 && tCnt == cnt && fCnt == cnt );
+	/* exact unless the last bin (n or more frames) was hit */
+	CHK( st[1].framesHist[MSCAN_IRQSTAT_FBINS-1] != 
+		 st[0].framesHist[MSCAN_IRQSTAT_FBINS-1] || rxCnt == nFrm );
+	CHK( st[1].sumHigh - st[0].sumHigh == 
+		 (st[1].sumLow < st[0].sumLow ? 1 : 0) );
+	CHK( sum >= cnt * st[1].minTime && sum <= cnt * st[1].maxTime );
+
+	/* lowest/highest bin since MSCAN_CLEARIRQSTAT in main */
+	for( lo=0; !st[1].timeHist[lo]; lo++ )
+		;
+	for( hi=MSCAN_IRQSTAT_TBINS-1; !st[1].timeHist[hi]; hi-- )
+		;
+	for( i=0, v=st[1].minTime; v && i<MSCAN_IRQSTAT_TBINS-1; i++ )
+		v >>= 1;
+	CHK( i == lo );
+	for( i=0, v=st[1].maxTime; v && i<MSCAN_IRQSTAT_TBINS-1; i++ )
+		v >>= 1;
+	CHK( i == hi );
+	CHK( maxIrqTime == st[1].maxTime );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test s: Tx scheduling between objects
+ * 
+ * - Obj 1:   Rx, 36 entries, Std Id  ALL
+ * - Obj 5-7: Tx, 12 entries each, weight 1/2/3, deadline 200/100/0ms
+ *
+ * Writes 12 frames to each Tx object, in object order, and checks the
+ * order on the bus for each policy. The first 3 frames of Obj 5 are
+ * ignored, they are moved into the controller before the other objects 
+ * have frames:
+ * - PRIO: object 5, 6, 7
+ * - RR:   never the same object twice in a row
+ * - WRR:  each 6 frames contain 1/2/3 frames of Obj 5/6/7
+ * - EDF:  object 7, 6, 5
+ *
+ * Within each object the frames must be sent in FIFO order.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxSched( MDIS_PATH path )
+{
+	const int rxObj=1, txObj=5, skip=3;
+	#define nObj 3
+	#define nPerObj 12
+	#define nFrm (nObj*nPerObj)
+	static const MSCAN_TXSCHED pol[] = { 
+		MSCAN_TXSCHED_PRIO, MSCAN_TXSCHED_RR, MSCAN_TXSCHED_WRR, 
+		MSCAN_TXSCHED_EDF };
+	static const char *polName[] = { "PRIO", "RR", "WRR", "EDF" };
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	int obj[nFrm], next[nObj], cnt[nObj];
+	u_int32 entries;
+	int p, o, i, j, rv = -1;
+
+	CHK( mscan_set_tx_sched( path, (MSCAN_TXSCHED)99 ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADPARAMETER );
+
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( o=0; o<nObj; o++ ){
+		CHK( mscan_config_msg( path, txObj+o, MSCAN_DIR_XMT, nPerObj, 
+							   NULL ) == 0 );
+		CHK( mscan_set_tx_param( path, txObj+o, o+1, 
+								 (nObj-1-o) * 100 ) == 0 );
+
+		for( i=0; i<nPerObj; i++ ){
+			txFrm[o*nPerObj+i].id	   = ((txObj+o) << 8) | i;
+			txFrm[o*nPerObj+i].flags   = 0;
+			txFrm[o*nPerObj+i].dataLen = 0;
+		}
+	}
+
+	for( p=0; p<sizeof(pol)/sizeof(pol[0]); p++ ){
+		CHK( mscan_set_tx_sched( path, pol[p] ) == 0 );
+
+		for( o=0; o<nObj; o++ )
+			CHK( mscan_write_nmsg( path, txObj+o, nPerObj, 
+								   &txFrm[o*nPerObj] ) == nPerObj );
+		for( o=0; o<nObj; o++ ){
+			do {
+				CHK( mscan_queue_status( path, txObj+o, &entries, 
+										 NULL ) == 0 );
+			} while( entries != nPerObj );
+		}
+		UOS_Delay( 100 );			/* last frames received */
+
+		CHK( mscan_read_nmsg( path, rxObj, nFrm, rxFrm ) == nFrm );
+
+		/* object of each frame, FIFO order within object */
+		memset( next, 0, sizeof(next) );
+		printf(" %-4s: ", polName[p]);
+		for( i=0; i<nFrm; i++ ){
+			o = (rxFrm[i].id >> 8) - txObj;
+			printf("%d", txObj+o);
+			CHK( o >= 0 && o < nObj );
+			CHK( (rxFrm[i].id & 0xff) == next[o] );
+			next[o]++;
+			obj[i] = o;
+		}
+		printf("\n");
+
+		for( i=skip+1; i<nFrm; i++ ){
+			switch( pol[p] ){
+			case MSCAN_TXSCHED_PRIO: CHK( obj[i] >= obj[i-1] ); break;
+			case MSCAN_TXSCHED_RR:	 CHK( obj[i] != obj[i-1] ); break;
+			case MSCAN_TXSCHED_EDF:	 CHK( obj[i] <= obj[i-1] ); break;
+			default: break;
+			}
+		}
+
+		/* WRR: all objects busy for the first 3 turns */
+		for( i=skip; pol[p] == MSCAN_TXSCHED_WRR && i<=skip+12; i++ ){
+			memset( cnt, 0, sizeof(cnt) );
+			for( j=i; j<i+6; j++ )
+				cnt[obj[j]]++;
+			for( o=0; o<nObj; o++ )
+				CHK( cnt[o] == o+1 );
+		}
+	}
+
+	rv = 0;
+ ABORT:
+	mscan_set_tx_sched( path, MSCAN_TXSCHED_PRIO );
+	for( o=0; o<nObj; o++ )
+		mscan_set_tx_param( path, txObj+o, 0, 0 );
+	ObjsDisable( path );
+
+	return rv;
+	#undef nObj
+	#undef nPerObj
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test t: Tx by CAN ID, preemption
+ * 
+ * - Obj 1: Rx, 15 entries, Std Id  ALL
+ * - Obj 5: Tx, 12 entries, bulk frames, IDs 0x700..
+ * - Obj 6: Tx, 3 entries, urgent frames, IDs 0x010..
+ *
+ * Policy MSCAN_TXSCHED_CANID. Writes 12 bulk frames and waits until 
+ * the first one is received, so the bulk frames occupy all controller
+ * Tx buffers. Then writes 3 urgent frames. Checks that:
+ * - the urgent frames overtake the bulk frames: they are sent after at
+ *   most 2 further bulk frames (one in transmission, one that may 
+ *   complete meanwhile)
+ * - preempted bulk frames are sent again, nothing is lost or duplicated 
+ *   and each object's frames stay in FIFO order
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxCanId( MDIS_PATH path )
+{
+	const int rxObj=1, bulkObj=5, urgObj=6;
+	#define nBulk 12
+	#define nUrg 3
+	MSCAN_FRAME txFrm[nBulk+nUrg], rxFrm[nBulk+nUrg];
+	u_int32 entries;
+	int run, nextBulk, nextUrg, n0, i, rv = -1;
+
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nBulk+nUrg, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, bulkObj, MSCAN_DIR_XMT, nBulk, 
+						   NULL ) == 0 );
+	CHK( mscan_config_msg( path, urgObj, MSCAN_DIR_XMT, nUrg, 
+						   NULL ) == 0 );
+	CHK( mscan_set_tx_sched( path, MSCAN_TXSCHED_CANID ) == 0 );
+
+	for( i=0; i<nBulk+nUrg; i++ ){
+		txFrm[i].id		 = (i < nBulk) ? 0x700 + i : 0x010 + i - nBulk;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 1;
+		txFrm[i].data[0] = (u_int8)i;
+	}
+
+	for( run=0; run<3; run++ ){
+		CHK( mscan_write_nmsg( path, bulkObj, nBulk, txFrm ) == nBulk );
+		CHK( (n0 = mscan_read_nmsg_timeout( path, rxObj, 1, nBulk, 1000,
+											rxFrm )) >= 1 );
+		CHK( mscan_write_nmsg( path, urgObj, nUrg, &txFrm[nBulk] ) 
+			 == nUrg );
+
+		do {
+			CHK( mscan_queue_status( path, bulkObj, &entries, NULL ) == 0 );
+		} while( entries != nBulk );
+		UOS_Delay( 100 );			/* last frames received */
+
+		CHK( mscan_read_nmsg( path, rxObj, nBulk+nUrg, &rxFrm[n0] ) == 
+			 nBulk+nUrg-n0 );
+
+		printf(" run %d:", run);
+		for( i=0; i<nBulk+nUrg; i++ )
+			printf(" %03x", rxFrm[i].id);
+		printf("\n");
+
+		for( i=0, nextBulk=0, nextUrg=nBulk; i<nBulk+nUrg; i++ ){
+			if( rxFrm[i].id < 0x700 ){
+				CHK( i < n0 + 2 + nUrg );
+				CHK( CmpFrames( &rxFrm[i], &txFrm[nextUrg++] ) == 0 );
+			}
+			else
+				CHK( CmpFrames( &rxFrm[i], &txFrm[nextBulk++] ) == 0 );
+		}
+	}
+
+	rv = 0;
+ ABORT:
+	mscan_set_tx_sched( path, MSCAN_TXSCHED_PRIO );
+	ObjsDisable( path );
+
+	return rv;
+	#undef nBulk
+	#undef nUrg
+}
+
+/**********************************************************************/
+/** Test u: Tx abort
+ * 
+ * - Obj 1: Rx, 20 entries, Std Id  ALL
+ * - Obj 8: Tx, 20 entries
+ *
+ * Writes 20 frames and waits until the first one is received, so the 
+ * controller Tx buffers are busy. Then
+ * - run 0: mscan_tx_abort. Checks that the FIFO is empty, that the 
+ *   returned frames are the ones following the received frames, and 
+ *   that at least one frame was aborted.
+ * - run 1: mscan_queue_clear with \a txabort. Checks that at most 2
+ *   further frames are sent (one in transmission, one that may complete
+ *   meanwhile), not the content of all 3 buffers.
+ *
+ * In both runs the received frames must be the first ones, in order.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxAbort( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 20
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm], abFrm[MSCAN_TXABORT_MAX];
+	u_int32 entries;
+	int32 n0, n, nAb;
+	int run, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+
+	CHK( mscan_tx_abort( path, rxObj, -1, NULL ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x100 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 1;
+		txFrm[i].data[0] = (u_int8)i;
+	}
+
+	for( run=0; run<2; run++ ){
+		CHK( mscan_write_nmsg( path, txObj, nFrm, txFrm ) == nFrm );
+		CHK( (n0 = mscan_read_nmsg_timeout( path, rxObj, 1, nFrm, 1000,
+											rxFrm )) >= 1 );
+		if( run == 0 ){
+			CHK( (nAb = mscan_tx_abort( path, txObj, 1000, abFrm )) >= 0 );
+		}
+		else {
+			CHK( mscan_queue_clear( path, txObj, 1 ) == 0 );
+		}
+
+		CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+		CHK( entries == nFrm );
+		UOS_Delay( 100 );			/* last frames received */
+
+		CHK( (n = mscan_read_nmsg( path, rxObj, nFrm, &rxFrm[n0] )) >= 0 );
+		n += n0;
+		printf(" %s: %d frames sent before, %d after\n", 
+			   run ? "queue_clear" : "tx_abort", n0, n - n0 );
+
+		for( i=0; i<n; i++ )
+			CHK( CmpFrames( &rxFrm[i], &txFrm[i] ) == 0 );
+
+		if( run == 0 ){
+			printf(" %d frames aborted\n", nAb );
+			CHK( nAb >= 1 && nAb <= MSCAN_TXABORT_MAX && n + nAb <= nFrm );
+			for( i=0; i<nAb; i++ )
+				CHK( CmpFrames( &abFrm[i], &txFrm[n+i] ) == 0 );
+		}
+		else {
+			CHK( n <= n0 + 2 );
+		}
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test v: Tx frame lifetime
+ * 
+ * - Obj 1: Rx, 410 entries, Std Id  ALL
+ * - Obj 5: Tx, 400 entries, bulk frames
+ * - Obj 8: Tx, 10 entries, frames with lifetime
+ *
+ * Writes 400 bulk frames to Obj 5, which keep Obj 8 from sending for 
+ * about 45ms at 1 MBit/s (policy PRIO). Then writes 10 frames to Obj 8,
+ * alternately with a lifetime of 1ms and 0 (unlimited). Checks that 
+ * the frames with lifetime are dropped and counted by mscan_tx_expired,
+ * and that all other frames are sent.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxExpiry( MDIS_PATH path )
+{
+	const int rxObj=1, bulkObj=5, txObj=8;
+	#define nBulk 400
+	#define nFrm 10
+	MSCAN_FRAME *bulkFrm=NULL, *rxFrm=NULL, txFrm[nFrm];
+	u_int32 expired, entries;
+	int32 n;
+	int i, rv = -1;
+
+	CHK( (bulkFrm = malloc( nBulk * sizeof(*bulkFrm) )) != NULL );
+	CHK( (rxFrm = malloc( (nBulk+nFrm) * sizeof(*rxFrm) )) != NULL );
+
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nBulk+nFrm, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, bulkObj, MSCAN_DIR_XMT, nBulk, 
+						   NULL ) == 0 );
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+
+	for( i=0; i<nBulk; i++ ){
+		bulkFrm[i].id	   = 0x200 + (i & 0xff);
+		bulkFrm[i].flags   = 0;
+		bulkFrm[i].dataLen = 8;
+		memset( bulkFrm[i].data, i, 8 );
+	}
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x400 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 0;
+	}
+
+	CHK( mscan_write_msg_exp( path, txObj, -1, 0xffffffff, txFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADPARAMETER );
+
+	CHK( mscan_write_nmsg( path, bulkObj, nBulk, bulkFrm ) == nBulk );
+	for( i=0; i<nFrm; i++ )
+		CHK( mscan_write_msg_exp( path, txObj, -1, (i & 1) ? 0 : 1, 
+								  &txFrm[i] ) == 0 );
+
+	do {
+		CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+	} while( entries != nFrm );
+	UOS_Delay( 100 );			/* last frames received */
+
+	CHK( mscan_tx_expired( path, txObj, &expired ) == 0 );
+	CHK( (n = mscan_read_nmsg( path, rxObj, nBulk+nFrm, rxFrm )) >= 0 );
+	printf(" %d frames received, %d expired\n", n, expired );
+
+	CHK( expired == nFrm/2 );
+	CHK( n == nBulk + nFrm/2 );
+	for( i=0; i<nBulk; i++ )
+		CHK( CmpFrames( &rxFrm[i], &bulkFrm[i] ) == 0 );
+	for( i=0; i<nFrm/2; i++ )
+		CHK( CmpFrames( &rxFrm[nBulk+i], &txFrm[2*i+1] ) == 0 );
+
+	/* reset by mscan_config_msg */
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_tx_expired( path, txObj, &expired ) == 0 );
+	CHK( expired == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+	if( bulkFrm )
+		free( bulkFrm );
+	if( rxFrm )
+		free( rxFrm );
+
+	return rv;
+	#undef nBulk
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test w: Cyclic transmission
+ * 
+ * - Obj 1: Rx, 100 entries, Std Id  ALL
+ * - Obj 8: Tx, 4 entries, used by cyclic table
+ *
+ * Table entries:
+ * - 0: ID 0x111, period 20ms, 5 times
+ * - 1: ID 0x222, period 50ms, endless, phase 100ms
+ *
+ * Runs the table for 500ms, then removes entry 1. Checks that entry 0
+ * was sent 5 times within about 80ms (receive timestamps; single 
+ * frames may be shifted by a late alarm), that entry 1
+ * was sent about 8 times and that nothing is sent after the removal.
+ * Also checks that the object cannot be written or configured while 
+ * used by the table, and the parameter errors of mscan_set_cyclic.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxCyclic( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nRx 100
+	MSCAN_CYCLIC ent[2];
+	MSCAN_FRAME_TS rxFrm[nRx];
+	u_int32 freq, ms, firstLow=0, lastLow=0;
+	int32 n;
+	int cnt0=0, cnt1=0, i, rv = -1;
+
+	CHK( mscan_ts_freq( path, &freq ) == 0 );
+	CHK( freq != 0 );
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 4, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nRx, 
+						   &G_stdOpenFilter ) == 0 );
+
+	memset( ent, 0, sizeof(ent) );
+	ent[0].objNr	  = txObj;
+	ent[0].period	  = 20;
+	ent[0].count	  = 5;
+	ent[0].frm.id	  = 0x111;
+	ent[1].objNr	  = txObj;
+	ent[1].period	  = 50;
+	ent[1].phase	  = 100;
+	ent[1].frm.id	  = 0x222;
+	ent[1].frm.dataLen = 2;
+	ent[1].frm.data[0] = 0x12;
+	ent[1].frm.data[1] = 0x34;
+
+	/* bad entry number / direction */
+	CHK( mscan_set_cyclic( path, MSCAN_CYCLIC_MAX-1, 2, ent ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADPARAMETER );
+	ent[0].objNr = rxObj;
+	CHK( mscan_set_cyclic( path, 0, 2, ent ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+	ent[0].objNr = txObj;
+
+	CHK( mscan_set_cyclic( path, 0, 2, ent ) == 0 );
+
+	/* object owned by table */
+	CHK( mscan_write_msg( path, txObj, -1, &ent[0].frm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_CYCLIC );
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 4, NULL ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_CYCLIC );
+
+	UOS_Delay( 500 );
+	ent[1].period = 0;
+	CHK( mscan_set_cyclic( path, 1, 1, &ent[1] ) == 0 );
+	UOS_Delay( 100 );			/* last frames received */
+
+	CHK( (n = mscan_read_nmsg_ts( path, rxObj, 0, nRx, -1, rxFrm )) >= 0 );
+
+	for( i=0; i<n; i++ ){
+		if( CmpFrames( &rxFrm[i].frm, &ent[0].frm ) == 0 ){
+			if( cnt0++ == 0 )
+				firstLow = rxFrm[i].tsLow;
+			lastLow = rxFrm[i].tsLow;
+		}
+		else if( CmpFrames( &rxFrm[i].frm, &ent[1].frm ) == 0 )
+			cnt1++;
+		else {
+			DumpFrame( "Unexpected frame", &rxFrm[i].frm );
+			CHK(0);
+		}
+	}
+	/* 4 periods of 20ms, 20ms tolerance */
+	ms = lastLow - firstLow;
+	ms = freq >= 1000 ? ms / (freq / 1000) : ms * 1000 / freq;
+	printf(" entry 0 sent %d times within %d ms, entry 1 %d times\n", 
+		   cnt0, ms, cnt1);
+	CHK( cnt0 == 5 );
+	CHK( ms >= 60 && ms <= 100 );
+	CHK( cnt1 >= 6 && cnt1 <= 10 );
+
+	/* nothing after removal */
+	UOS_Delay( 100 );
+	CHK( mscan_read_nmsg( path, rxObj, 1, &rxFrm[0].frm ) == 0 );
+
+	rv = 0;
+ ABORT:
+	ent[0].period = ent[1].period = 0;
+	mscan_set_cyclic( path, 0, 2, ent );
+	ObjsDisable( path );
+
+	return rv;
+	#undef nRx
+}
+
+/**********************************************************************/
+/** Test x: Tx mailbox
+ * 
+ * - Obj 1: Rx, 410 entries, Std Id  ALL
+ * - Obj 5: Tx, 400 entries, bulk frames
+ * - Obj 8: Tx mailbox, 3 IDs
+ *
+ * Writes 400 bulk frames to Obj 5, which keep Obj 8 from sending 
+ * (policy PRIO). Meanwhile writes values 1..50 for each of the IDs
+ * 0x301..0x303 to Obj 8. Checks that a 4th ID is rejected, and that 
+ * Obj 8 sends each ID only once, with the latest value, in the order 
+ * of the first write. The IDs stay assigned after sending, the 4th ID
+ * can be sent after mscan_queue_clear.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxMbox( MDIS_PATH path )
+{
+	const int rxObj=1, bulkObj=5, txObj=8;
+	#define nBulk 400
+	#define nIds 3
+	MSCAN_FRAME *bulkFrm=NULL, *rxFrm=NULL, frm;
+	u_int32 entries;
+	int32 n;
+	int i, v, rv = -1;
+
+	CHK( (bulkFrm = malloc( nBulk * sizeof(*bulkFrm) )) != NULL );
+	CHK( (rxFrm = malloc( (nBulk+10) * sizeof(*rxFrm) )) != NULL );
+
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, nBulk+10, 
+						   &G_stdOpenFilter ) == 0 );
+	CHK( mscan_config_msg( path, bulkObj, MSCAN_DIR_XMT, nBulk, 
+						   NULL ) == 0 );
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMTMBOX, nIds, 
+						   NULL ) == 0 );
+
+	for( i=0; i<nBulk; i++ ){
+		bulkFrm[i].id	   = 0x200 + (i & 0xff);
+		bulkFrm[i].flags   = 0;
+		bulkFrm[i].dataLen = 8;
+		memset( bulkFrm[i].data, i, 8 );
+	}
+	frm.flags	= 0;
+	frm.dataLen = 1;
+
+	CHK( mscan_write_nmsg( path, bulkObj, nBulk, bulkFrm ) == nBulk );
+
+	for( v=1; v<=50; v++ ){
+		for( i=0; i<nIds; i++ ){
+			frm.id		= 0x301 + i;
+			frm.data[0] = (u_int8)v;
+			CHK( mscan_write_msg( path, txObj, -1, &frm ) == 0 );
+		}
+	}
+	frm.id		= 0x304;
+	frm.data[0] = 0;
+	CHK( mscan_write_msg( path, txObj, -1, &frm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_QFULL );
+
+	do {
+		CHK( mscan_queue_status( path, bulkObj, &entries, NULL ) == 0 );
+	} while( entries != nBulk );
+	UOS_Delay( 100 );			/* last frames received */
+
+	CHK( (n = mscan_read_nmsg( path, rxObj, nBulk+10, rxFrm )) >= 0 );
+	printf(" %d frames received\n", n);
+	CHK( n == nBulk + nIds );
+	for( i=0; i<nBulk; i++ )
+		CHK( CmpFrames( &rxFrm[i], &bulkFrm[i] ) == 0 );
+	for( i=0; i<nIds; i++ ){
+		frm.id		= 0x301 + i;
+		frm.data[0] = 50;
+		if( CmpFrames( &rxFrm[nBulk+i], &frm ) != 0 ){
+			DumpFrame( "Exp.", &frm );
+			DumpFrame( "Recv", &rxFrm[nBulk+i] );
+			CHK(0);
+		}
+	}
+
+	frm.id		= 0x304;
+	frm.data[0] = 0;
+
+	/* IDs stay assigned after sending until mscan_queue_clear */
+	CHK( mscan_write_msg( path, txObj, -1, &frm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_QFULL );
+	CHK( mscan_queue_clear( path, txObj, 0 ) == 0 );
+	CHK( SendAll( path, txObj, &frm, 1 ) == 0 );
+	CHK( mscan_read_nmsg( path, rxObj, 10, rxFrm ) == 1 );
+	CHK( CmpFrames( &rxFrm[0], &frm ) == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+	if( bulkFrm )
+		free( bulkFrm );
+	if( rxFrm )
+		free( rxFrm );
+
+	return rv;
+	#undef nBulk
+	#undef nIds
+}
+
+/**********************************************************************/
+/** Check changed slots of an Rx mailbox
+ *
+ * Reads up to \a max slots of \a rxObj. Each slot must contain the frame
+ * with ID 0x301+i and data byte \a val[i] and report \a val[i] updates, 
+ * where i is one of the IDs in \a idMask (bit i: ID 0x301+i). 
+ *
+ * \return number of slots read, -1=error
+ */
+static int RxMboxChk( MDIS_PATH path, int rxObj, int max, 
+					  const u_int8 *val, u_int32 idMask )
+{
+	MSCAN_MBOX_ENTRY ent[4];
+	int32 n;
+	int i, k;
+
+	CHK( max <= 4 );
+	CHK( (n = mscan_read_mbox( path, rxObj, max, -1, ent )) >= 0 );
+
+	for( i=0; i<n; i++ ){
+		k = ent[i].frm.id - 0x301;
+
+		if( k < 0 || k > 31 || !((idMask >> k) & 1) || 
+			ent[i].frm.dataLen != 1 || ent[i].frm.data[0] != val[k] ||
+			ent[i].updates != val[k] ){
+			printf("slot %d: %d updates\n", i, ent[i].updates);
+			DumpFrame( "Recv", &ent[i].frm );
+			CHK(0);
+		}
+		idMask &= ~(1 << k);	/* only once */
+	}
+	return n;
+
+ ABORT:
+	return -1;
+}
+
+/**********************************************************************/
+/** Test y: Rx mailbox
+ * 
+ * - Obj 1: Rx mailbox, 3 IDs, Std Id  ALL
+ * - Obj 8: Tx, 40 entries
+ *
+ * Sends frames with the IDs 0x301..0x304, data byte = number of the 
+ * frame of that ID. Checks that
+ * - each of the first 3 IDs is returned once by mscan_read_mbox, with 
+ *   the latest value and the number of updates
+ * - the 4th ID is discarded and reported once as MSCAN_QOVERRUN
+ * - only slots changed since the last read are returned, also when 
+ *   read in parts
+ * - mscan_queue_clear releases the IDs
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxMbox( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	static const int nPerId[4] = { 10, 5, 1, 2 };
+	MSCAN_FRAME txFrm[40];
+	MSCAN_MBOX_ENTRY ent[4];
+	u_int8 val[4] = { 0, 0, 0, 0 };
+	u_int32 entries, errCode, objNr;
+	int i, k, n, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 40, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCVMBOX, 3, 
+						   &G_stdOpenFilter ) == 0 );
+
+	/* empty error object */
+	CHK( mscan_queue_status( path, 0, &entries, NULL ) == 0 );
+	while( entries-- )
+		CHK( mscan_read_error( path, &errCode, &objNr ) == 0 );
+
+	CHK( mscan_read_mbox( path, rxObj, 4, -1, ent ) == 0 );
+	CHK( mscan_read_mbox( path, rxObj, 4, 100, ent ) == -1 );
+	CHK( UOS_ErrnoGet() == ERR_OSS_TIMEOUT );
+	CHK( mscan_read_nmsg( path, rxObj, 1, txFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	/* 10/5/1/2 frames of 0x301..0x304, interleaved */
+	for( i=n=0; i<10; i++ ){
+		for( k=0; k<4; k++ ){
+			if( i >= nPerId[k] )
+				continue;
+			txFrm[n].id		 = 0x301 + k;
+			txFrm[n].flags	 = 0;
+			txFrm[n].dataLen = 1;
+			txFrm[n].data[0] = ++val[k];
+			n++;
+		}
+	}
+	CHK( SendAll( path, txObj, txFrm, n ) == 0 );
+
+	CHK( mscan_queue_status( path, rxObj, &entries, NULL ) == 0 );
+	CHK( entries == 3 );
+	CHK( RxMboxChk( path, rxObj, 4, val, 0x7 ) == 3 );
+	CHK( RxMboxChk( path, rxObj, 4, val, 0 ) == 0 );
+
+	/* 4th ID reported once */
+	CHK( mscan_queue_status( path, 0, &entries, NULL ) == 0 );
+	CHK( entries == 1 );
+	CHK( mscan_read_error( path, &errCode, &objNr ) == 0 );
+	CHK( errCode == MSCAN_QOVERRUN && objNr == rxObj );
+
+	/* only changed slots, read in parts */
+	for( k=0, n=0; k<3; k+=2, n++ ){
+		txFrm[n].id		 = 0x301 + k;
+		txFrm[n].flags	 = 0;
+		txFrm[n].dataLen = 1;
+		txFrm[n].data[0] = ++val[k];
+	}
+	CHK( SendAll( path, txObj, txFrm, n ) == 0 );
+	CHK( RxMboxChk( path, rxObj, 1, val, 0x5 ) == 1 );
+	CHK( RxMboxChk( path, rxObj, 1, val, 0x5 ) == 1 );
+	CHK( RxMboxChk( path, rxObj, 1, val, 0 ) == 0 );
+
+	/* IDs released: 0x304 gets a slot */
+	CHK( mscan_queue_clear( path, rxObj, 0 ) == 0 );
+	txFrm[0].id		 = 0x304;
+	txFrm[0].data[0] = val[3] = 1;
+	CHK( SendAll( path, txObj, txFrm, 1 ) == 0 );
+	CHK( RxMboxChk( path, rxObj, 4, val, 0x8 ) == 1 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test z: Shared Rx ring
+ * 
+ * - Obj 1: Rx, 20 entries, shared ring, Std Id  ALL
+ * - Obj 8: Tx, 20 entries
+ *
+ * Skipped if the driver was built without shared rings 
+ * (ERR_LL_ILL_FUNC). Checks the ring header, then sends 4 rounds of 
+ * 15 frames, so the ring wraps, waits for them with mscan_rxring_wait
+ * and checks the frames in place. Also checks that the FIFO read 
+ * functions are refused and that mscan_queue_clear resets the counters.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbRxRing( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 15
+	MSCAN_FRAME txFrm[nFrm];
+	MSCAN_RXRING *r;
+	int round, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 20, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+
+	if( mscan_rxring_map( path, rxObj, &r ) != 0 ){
+		CHK( UOS_ErrnoGet() == ERR_LL_ILL_FUNC );
+		printf(" shared rings not supported by driver, skipped\n");
+		rv = 0;
+		goto ABORT;
+	}
+
+	CHK( r->totEntries == 20 && r->ringMask >= 19 && 
+		 ((r->ringMask + 1) & r->ringMask) == 0 );
+	CHK( MSCAN_RXRING_FILLED( r ) == 0 );
+	CHK( mscan_rxring_wait( path, rxObj, 1, -1 ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_NOMESSAGE );
+	CHK( mscan_read_nmsg( path, rxObj, 1, txFrm ) == -1 );
+
+	for( round=0; round<4; round++ ){
+		for( i=0; i<nFrm; i++ ){
+			txFrm[i].id		 = 0x500 + round * nFrm + i;
+			txFrm[i].flags	 = 0;
+			txFrm[i].dataLen = 1;
+			txFrm[i].data[0] = (u_int8)round;
+		}
+		CHK( mscan_write_nmsg( path, txObj, nFrm, txFrm ) == nFrm );
+		CHK( mscan_rxring_wait( path, rxObj, nFrm, 1000 ) == 0 );
+		CHK( MSCAN_RXRING_FILLED( r ) >= nFrm );
+
+		for( i=0; i<nFrm; i++ ){
+			if( CmpFrames( MSCAN_RXRING_FRM( r, r->nxtOut ), 
+						   &txFrm[i] ) != 0 ){
+				printf("round %d: Incorrect Frame received\n", round);
+				DumpFrame( "Exp.", &txFrm[i] );
+				DumpFrame( "Recv", MSCAN_RXRING_FRM( r, r->nxtOut ) );
+				CHK(0);
+			}
+			r->nxtOut++;
+		}
+	}
+	UOS_Delay( 100 );
+	CHK( MSCAN_RXRING_FILLED( r ) == 0 );
+
+	CHK( mscan_queue_clear( path, rxObj, 0 ) == 0 );
+	CHK( r->nxtIn == 0 && r->nxtOut == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test 1: Shared Tx ring
+ * 
+ * - Obj 1: Rx, 20 entries, Std Id  ALL
+ * - Obj 8: Tx, 20 entries, shared ring
+ *
+ * Skipped if the driver was built without shared rings 
+ * (ERR_LL_ILL_FUNC). Checks the ring header, then puts 4 rounds of 
+ * 15 frames into the ring, so it wraps, rings the doorbell once per 
+ * round and checks that the frames are received in order. Also checks
+ * that the FIFO write functions are refused and the doorbell errors.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbTxRing( MDIS_PATH path )
+{
+	const int txObj=8, rxObj=1;
+	#define nFrm 15
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	MSCAN_TXRING *r, *r2;
+	u_int32 entries;
+	int round, i, tries, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 20, NULL ) == 0 );
+	CHK( mscan_config_msg( path, rxObj, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+
+	/* doorbell on object that is not shared */
+	CHK( mscan_txring_doorbell( path, txObj ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	if( mscan_txring_map( path, txObj, &r ) != 0 ){
+		CHK( UOS_ErrnoGet() == ERR_LL_ILL_FUNC );
+		printf(" shared rings not supported by driver, skipped\n");
+		rv = 0;
+		goto ABORT;
+	}
+
+	CHK( r->totEntries == 20 && r->ringMask >= 19 && 
+		 ((r->ringMask + 1) & r->ringMask) == 0 );
+	CHK( MSCAN_TXRING_FREE( r ) == 20 );
+	CHK( mscan_txring_map( path, txObj, &r2 ) == 0 && r2 == r );
+
+	/* FIFO write functions refused */
+	txFrm[0].id		 = 0x123;
+	txFrm[0].flags	 = 0;
+	txFrm[0].dataLen = 0;
+	CHK( mscan_write_msg( path, txObj, 0, &txFrm[0] ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+	CHK( mscan_write_nmsg( path, txObj, 1, txFrm ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADDIR );
+
+	for( round=0; round<4; round++ ){
+		for( i=0; i<nFrm; i++ ){
+			txFrm[i].id		 = 0x500 + round * nFrm + i;
+			txFrm[i].flags	 = 0;
+			txFrm[i].dataLen = 1;
+			txFrm[i].data[0] = (u_int8)round;
+
+			CHK( MSCAN_TXRING_FREE( r ) > 0 );
+			*MSCAN_TXRING_FRM( r, r->nxtIn ) = txFrm[i];
+			r->nxtIn++;
+		}
+		CHK( mscan_txring_doorbell( path, txObj ) == 0 );
+
+		/* wait until all taken by driver */
+		for( tries=0; MSCAN_TXRING_FREE( r ) != r->totEntries; tries++ ){
+			CHK( tries < 100 );
+			UOS_Delay( 10 );
+		}
+		UOS_Delay( 100 );			/* last frames received */
+
+		CHK( mscan_queue_status( path, rxObj, &entries, NULL ) == 0 );
+		CHK( entries == nFrm );
+		CHK( mscan_read_nmsg( path, rxObj, nFrm, rxFrm ) == nFrm );
+
+		for( i=0; i<nFrm; i++ ){
+			if( CmpFrames( &rxFrm[i], &txFrm[i] ) != 0 ){
+				printf("round %d: Incorrect Frame received\n", round);
+				DumpFrame( "Exp.", &txFrm[i] );
+				DumpFrame( "Recv", &rxFrm[i] );
+				CHK(0);
+			}
+		}
+	}
+
+	/* more frames put than free entries: refused, nothing sent */
+	r->nxtIn += r->totEntries + 1;
+	CHK( mscan_txring_doorbell( path, txObj ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_QFULL );
+	r->nxtIn -= r->totEntries + 1;
+	CHK( mscan_txring_doorbell( path, txObj ) == 0 );
+	UOS_Delay( 100 );
+	CHK( mscan_queue_status( path, rxObj, &entries, NULL ) == 0 );
+	CHK( entries == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test 2: Wait for several objects
+ * 
+ * - Obj 1: Rx,  5 entries, Std Id  0x100
+ * - Obj 2: Rx,  5 entries, Std Id  0x200
+ * - Obj 8: Tx, 20 entries
+ *
+ * Checks mscan_wait:
+ * - parameter error with both masks 0
+ * - poll (timeout -1) returns empty masks, ERR_OSS_TIMEOUT on timeout
+ * - returns only the objects that have frames, when frames arrive 
+ *   while waiting
+ * - error object (bit 0) ready after an Rx overrun
+ * - Tx object ready when \a txSpace entries are free, \a txSpace is
+ *   limited to the FIFO size
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbWait( MDIS_PATH path )
+{
+	static const MSCAN_FILTER flt[] = { 
+		/* code, mask, cflags, mflags */
+		{ 0x100, 0x000, 0, 0 },							/* obj1 */
+		{ 0x200, 0x000, 0, 0 }							/* obj2 */
+	};
+	const int txObj=8;
+	const u_int32 txBit=1<<8;
+	#define nFrm 20
+	MSCAN_FRAME txFrm[nFrm], rxFrm[nFrm];
+	u_int32 rx, tx, errCode, objNr, startTime, elapsed;
+	int i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, nFrm, NULL ) == 0 );
+	CHK( mscan_config_msg( path, 1, MSCAN_DIR_RCV, 5, &flt[0] ) == 0 );
+	CHK( mscan_config_msg( path, 2, MSCAN_DIR_RCV, 5, &flt[1] ) == 0 );
+
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x100;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 8;
+		memset( txFrm[i].data, i, 8 );
+	}
+
+	/* nothing to wait for */
+	rx = tx = 0;
+	CHK( mscan_wait( path, &rx, &tx, 0, -1 ) == -1 );
+	CHK( UOS_ErrnoGet() == MSCAN_ERR_BADPARAMETER );
+
+	/* nothing ready: poll and timeout */
+	rx = 0x7;
+	tx = 0;
+	CHK( mscan_wait( path, &rx, &tx, 0, -1 ) == 0 );
+	CHK( rx == 0 && tx == 0 );
+
+	rx = 0x7;
+	startTime = UOS_MsecTimerGet();
+	CHK( mscan_wait( path, &rx, &tx, 0, 100 ) == -1 );
+	elapsed = UOS_MsecTimerGet() - startTime;
+	CHK( UOS_ErrnoGet() == ERR_OSS_TIMEOUT );
+	CHK( elapsed >= 90 && elapsed < 1000 );
+
+	/* frame arrives while waiting: only obj 2 ready */
+	txFrm[0].id = 0x200;
+	CHK( mscan_write_msg( path, txObj, 0, &txFrm[0] ) == 0 );
+	rx = 0x7;
+	tx = 0;
+	CHK( mscan_wait( path, &rx, &tx, 0, 1000 ) == 0 );
+	CHK( rx == 0x4 && tx == 0 );
+	CHK( mscan_read_nmsg( path, 2, nFrm, rxFrm ) == 1 );
+	CHK( CmpFrames( &rxFrm[0], &txFrm[0] ) == 0 );
+	txFrm[0].id = 0x100;
+
+	/* objects not in mask are not reported */
+	CHK( SendAll( path, txObj, txFrm, 1 ) == 0 );
+	rx = 0x5;
+	CHK( mscan_wait( path, &rx, &tx, 0, -1 ) == 0 );
+	CHK( rx == 0 );
+	rx = 0x7;
+	CHK( mscan_wait( path, &rx, &tx, 0, 100 ) == 0 );
+	CHK( rx == 0x2 );
+
+	/* overrun obj 1: error object ready */
+	CHK( SendAll( path, txObj, txFrm, 5 ) == 0 );
+	rx = 0x1;
+	CHK( mscan_wait( path, &rx, &tx, 0, 100 ) == 0 );
+	CHK( rx == 0x1 );
+	CHK( mscan_read_error( path, &errCode, &objNr ) == 0 );
+	CHK( errCode == MSCAN_QOVERRUN && objNr == 1 );
+	CHK( mscan_read_nmsg( path, 1, nFrm, rxFrm ) == 5 );
+	rx = 0x7;
+	CHK( mscan_wait( path, &rx, &tx, 0, -1 ) == 0 );
+	CHK( rx == 0 );
+
+	/* Tx space */
+	rx = 0;
+	tx = txBit | 0x2;			/* obj 1 is no Tx object */
+	CHK( mscan_wait( path, &rx, &tx, nFrm, -1 ) == 0 );
+	CHK( rx == 0 && tx == txBit );
+	tx = txBit;
+	CHK( mscan_wait( path, &rx, &tx, 1000, -1 ) == 0 );
+	CHK( tx == txBit );
+
+	CHK( mscan_write_nmsg( path, txObj, nFrm, txFrm ) == nFrm );
+	tx = txBit;
+	CHK( mscan_wait( path, &rx, &tx, nFrm, -1 ) == 0 );
+	CHK( tx == 0 );
+	tx = txBit;
+	CHK( mscan_wait( path, &rx, &tx, nFrm, 2000 ) == 0 );
+	CHK( tx == txBit );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Test 3: Automatic hardware filter
+ * 
+ * Starts mscan_filter_auto with
+ * - Obj 1: Std Id  0x120
+ * and then changes the Rx objects:
+ * - Obj 2: Std Id  0x200..0x2ff added
+ * - Obj 3: Ext Id  0x18feef00..0x18feefff added
+ * - Obj 2: disabled
+ * - Obj 2: Std Id  ALL
+ *
+ * After each change, checks the wanted IDs reported by 
+ * mscan_filter_info and that the frames of the objects are received.
+ * Then checks that the filter stays when the automatic setup is 
+ * stopped, and that mscan_set_filter switches back to manual setup.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbFilterAuto( MDIS_PATH path )
+{
+	static const MSCAN_FILTER flt[] = { 
+		/* code, mask, cflags, mflags */
+		{ 0x120, 0x000, 0, 0 },							/* obj1 */
+		{ 0x200, 0x0ff, 0, 0 },							/* obj2 */
+		{ 0x18feef00, 0x0ff, MSCAN_EXTENDED, 0 }		/* obj3 */
+	};
+	static const MSCAN_FRAME txFrm[] = {
+		/* ID,  flags,          dlen, data */
+		{ 0x120, 0,				0,   { 0 } },
+		{ 0x250, 0,				0,   { 0 } },
+		{ 0x18feef33, MSCAN_EXTENDED, 0, { 0 } },
+		{ 0x7ff, 0,				0,   { 0 } }
+	};
+	/* per step: obj 2 filter (-1=disabled, 3=open), wanted IDs, 
+	   receiving object per frame */
+	static const struct {
+		int obj2, obj3;
+		u_int32 stdWanted, extWanted;
+		int rcv[4];
+	} step[] = {
+		{ -1, 0, 0x001, 0x000, { 1, 0, 0, 0 } },
+		{  1, 0, 0x101, 0x000, { 1, 2, 0, 0 } },
+		{  1, 1, 0x101, 0x100, { 1, 2, 3, 0 } },
+		{ -1, 1, 0x001, 0x100, { 1, 0, 3, 0 } },
+		{  3, 1, 0x800, 0x100, { 1, 2, 3, 2 } }
+	};
+	const int nTx = sizeof(txFrm)/sizeof(MSCAN_FRAME);
+	const int txObj=8;
+	u_int32 must[sizeof(txFrm)/sizeof(MSCAN_FRAME)];
+	MSCAN_HWFILT_INFO info, info2;
+	int s, i, rv = -1;
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 10, NULL ) == 0 );
+	CHK( mscan_config_msg( path, 1, MSCAN_DIR_RCV, 20, &flt[0] ) == 0 );
+
+	CHK( mscan_filter_auto( path, MSCAN_HWFILT_AUTO ) == 0 );
+
+	for( s=0; s<sizeof(step)/sizeof(step[0]); s++ ){
+		if( step[s].obj2 == -1 ){
+			CHK( mscan_config_msg( path, 2, MSCAN_DIR_DIS, 0, NULL ) == 0 );
+		}
+		else {
+			CHK( mscan_config_msg( path, 2, MSCAN_DIR_RCV, 20, 
+								   step[s].obj2 == 3 ? &G_stdOpenFilter :
+								   &flt[1] ) == 0 );
+		}
+		if( step[s].obj3 ){
+			CHK( mscan_config_msg( path, 3, MSCAN_DIR_RCV, 20, 
+								   &flt[2] ) == 0 );
+		}
+		CHK( mscan_filter_info( path, &info ) == 0 );
+
+		printf(" step %d: filter %ld: std %ld/%ld ext %ld/%ld\n", s,
+			   info.mode, info.stdWanted, info.stdAccepted,
+			   info.extWanted, info.extAccepted );
+
+		CHK( info.stdWanted == step[s].stdWanted );
+		CHK( info.extWanted == step[s].extWanted );
+		CHK( info.stdAccepted >= info.stdWanted );
+		CHK( info.extAccepted >= info.extWanted );
+
+		for( i=0; i<nTx; i++ )
+			must[i] = step[s].rcv[i] ? 1 << step[s].rcv[i] : 0;
+
+		CHK( SendCheck( path, txObj, txFrm, nTx, 0xe, must, NULL ) == 0 );
+	}
+
+	/* stopped: filter stays when objects change */
+	CHK( mscan_filter_auto( path, -1 ) == 0 );
+	CHK( mscan_config_msg( path, 2, MSCAN_DIR_DIS, 0, NULL ) == 0 );
+	CHK( mscan_filter_info( path, &info2 ) == 0 );
+	CHK( memcmp( &info, &info2, sizeof(info) ) == 0 );
+
+	/* restarted, then switched back to manual filter */
+	CHK( mscan_filter_auto( path, MSCAN_HWFILT_AUTO ) == 0 );
+	CHK( mscan_filter_info( path, &info ) == 0 );
+	CHK( info.stdWanted == 0x001 && info.extWanted == 0x100 );
+	CHK( mscan_set_filter( path, &G_stdOpenFilter, &G_extOpenFilter ) 
+		 == 0 );
+	CHK( mscan_config_msg( path, 2, MSCAN_DIR_RCV, 20, &flt[1] ) == 0 );
+	CHK( mscan_filter_info( path, &info ) == 0 );
+	CHK( info.stdWanted == 0 && info.extWanted == 0 );
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Test 4: Rx acceptance fields
+ * 
+ * Configures the Rx objects 20 times, each time with other acceptance
+ * fields for the Std Ids 0x100..0x10f. Sets A and B overlap in one ID:
+ * - Obj 1: Std Id  0x100..0x1ff, accField A (even runs) or B (odd runs)
+ * - Obj 2: Std Id  0x100..0x1ff, accField B
+ * - Obj 3: Std Id  0x100..0x1ff, accField A
+ * - Obj 4: Std Id  ALL
+ *
+ * Checks that each frame is received only by the lowest object whose
+ * accField matches, so obj 3 receives frames only in odd runs, when it
+ * no longer has the same accField as obj 1. Since more fields are used
+ * than there are objects, the driver must release the fields of 
+ * reconfigured objects.
+ *
+ * \return 0=ok, -1=error
+ */
+static int LoopbAccFields( MDIS_PATH path )
+{
+	const int txObj=8;
+	#define nFrm 17
+	MSCAN_FILTER fltA, fltB;
+	MSCAN_FRAME txFrm[nFrm];
+	u_int32 must[nFrm];
+	int run, i, inA, inB, rv = -1;
+
+	fltA.code	= 0x100;
+	fltA.mask	= 0x0ff;
+	fltA.cflags = 0;
+	fltA.mflags = MSCAN_USE_ACCFIELD;
+	fltB = fltA;
+
+	/* 0x100..0x10f, 0x110 never in accField */
+	for( i=0; i<nFrm; i++ ){
+		txFrm[i].id		 = 0x100 + i;
+		txFrm[i].flags	 = 0;
+		txFrm[i].dataLen = 1;
+		txFrm[i].data[0] = (u_int8)i;
+	}
+
+	CHK( mscan_config_msg( path, txObj, MSCAN_DIR_XMT, 20, NULL ) == 0 );
+	CHK( mscan_config_msg( path, 4, MSCAN_DIR_RCV, 20, 
+						   &G_stdOpenFilter ) == 0 );
+
+	for( run=0; run<20; run++ ){
+		memset( fltA.accField, 0, sizeof(fltA.accField) );
+		memset( fltB.accField, 0, sizeof(fltB.accField) );
+		MSCAN_ACCFIELD_SET( fltA.accField, 0x100 + run % 16 );
+		MSCAN_ACCFIELD_SET( fltA.accField, 0x100 + (run + 5) % 16 );
+		MSCAN_ACCFIELD_SET( fltB.accField, 0x100 + (run + 1) % 16 );
+		MSCAN_ACCFIELD_SET( fltB.accField, 0x100 + (run + 5) % 16 );
+
+		CHK( mscan_config_msg( path, 1, MSCAN_DIR_RCV, 20, 
+							   (run & 1) ? &fltB : &fltA ) == 0 );
+		CHK( mscan_config_msg( path, 2, MSCAN_DIR_RCV, 20, &fltB ) == 0 );
+		CHK( mscan_config_msg( path, 3, MSCAN_DIR_RCV, 20, &fltA ) == 0 );
+
+		for( i=0; i<nFrm; i++ ){
+			inA = MSCAN_ACCFIELD_GET( fltA.accField, txFrm[i].id ) != 0;
+			inB = MSCAN_ACCFIELD_GET( fltB.accField, txFrm[i].id ) != 0;
+
+			if( !(run & 1) )
+				must[i] = inA ? 1<<1 : inB ? 1<<2 : 1<<4;
+			else
+				must[i] = inB ? 1<<1 : inA ? 1<<3 : 1<<4;
+		}
+		CHK( SendCheck( path, txObj, txFrm, nFrm, 0x1e, must, NULL ) == 0 );
+	}
+
+	rv = 0;
+ ABORT:
+	ObjsDisable( path );
+
+	return rv;
+	#undef nFrm
+}
+
+/**********************************************************************/
+/** Send \a n frames on \a txObj and wait until all are sent
+ *
+ * \return 0=ok, -1=error
+ */
+static int SendAll( MDIS_PATH path, int txObj, const MSCAN_FRAME *frm, 
+					int n )
+{
+	u_int32 entries, nFree;
+	int i;
+
+	CHK( mscan_queue_status( path, txObj, &nFree, NULL ) == 0 );
+
+	for( i=0; i<n; i++ )
+		CHK( mscan_write_msg( path, txObj, 1000, &frm[i] ) == 0 );
+
+	do {
+		CHK( mscan_queue_status( path, txObj, &entries, NULL ) == 0 );
+	} while( entries != nFree );
+
+	UOS_Delay( 100 );			/* last frames received */
+	return 0;
+
+ ABORT:
+	return -1;
+}
+
+/**********************************************************************/
+/** Read all frames of \a rxObj and count them per sent frame
+ *
+ * \a cnt[i] is incremented for each received copy of \a frm[i].
+ *
+ * \return 0=ok, -1=frame not in \a frm received
+ */
+static int RecvCount( MDIS_PATH path, int rxObj, const MSCAN_FRAME *frm, 
+					  int n, int *cnt )
+{
+	MSCAN_FRAME rxFrm;
+	int i;
+
+	while( mscan_read_nmsg( path, rxObj, 1, &rxFrm ) == 1 ){
+
+		for( i=0; i<n; i++ )
+			if( CmpFrames( &rxFrm, &frm[i] ) == 0 )
+				break;
+
+		if( i == n ){
+			printf("Rx object %d: Unexpected Frame received\n", rxObj);
+			DumpFrame( "Recv", &rxFrm );
+			return -1;
+		}
+		cnt[i]++;
+	}
+	return 0;
+}
+
+/**********************************************************************/
+/** Send \a n frames on \a txObj and check where they are received
+ *
+ * Reads all frames of the Rx objects in \a rxMask (bit n: obj n).
+ * \a frm[i] must be received once on the objects in \a must[i], may be
+ * received once on the objects in \a may[i] (\a may NULL: none) and 
+ * must not be received on the other objects.
+ *
+ * \return 0=ok, -1=error
+ */
+static int SendCheck( MDIS_PATH path, int txObj, const MSCAN_FRAME *frm, 
+					  int n, u_int32 rxMask, const u_int32 *must, 
+					  const u_int32 *may )
+{
+	int cnt[MAX_CHK_FRAMES];
+	int i, obj, lo, hi;
+
+	CHK( n <= MAX_CHK_FRAMES );
+	CHK( SendAll( path, txObj, frm, n ) == 0 );
+
+	for( obj=1; obj<32; obj++ ){
+		if( !((rxMask >> obj) & 1) )
+			continue;
+
+		memset( cnt, 0, sizeof(cnt) );
+		CHK( RecvCount( path, obj, frm, n, cnt ) == 0 );
+
+		for( i=0; i<n; i++ ){
+			lo = (must[i] >> obj) & 1;
+			hi = lo | (may ? (may[i] >> obj) & 1 : 0);
+
+			if( cnt[i] < lo || cnt[i] > hi ){
+				printf("Rx object %d: frame received %d times\n", 
+					   obj, cnt[i]);
+				DumpFrame( "Sent", &frm[i] );
+				CHK(0);
+			}
+		}
+	}
+	return 0;
+
+ ABORT:
+	return -1;
+}
+
+/**********************************************************************/
+/** Disable all message objects except the error object
+ *
+ * Also stops the automatic hardware filter and opens the global filters
+ * again, so the next test starts from the state set up by main.
+ */
+static void ObjsDisable( MDIS_PATH path )
+{
+	int32 numObjs;
+	int obj;
+
+	if( M_getstat( path, M_LL_CH_NUMBER, &numObjs ) != 0 )
+		numObjs = 10;
+
+	mscan_filter_auto( path, -1 );
+
+	for( obj=1; obj<numObjs; obj++ )
+		mscan_config_msg( path, obj, MSCAN_DIR_DIS, 0, NULL );
+
+	mscan_set_filter( path, &G_stdOpenFilter, &G_extOpenFilter );
+}
 
 static int CmpFrames( const MSCAN_FRAME *frm1, const MSCAN_FRAME *frm2 )
 {
@@ -168,9 +168,10 @@ static void ConfigMsgObj(void)
 	MSCAN_DIR d=MSCAN_DIR_DIS;
 
 	GetInteger( "Mesage object number", &objNr );
-	dir = GetChoice( "direction: (D)isable (R)x (T)x", dir, "DRT" );
+	dir = GetChoice( "direction: (D)isable (R)x (T)x (M)ailbox tx "
+					 "mail(B)ox rx", dir, "DRTMB" );
 	GetInteger( "FIFO entries", &qEntries );
-	if( dir == 'R' ){
+	if( dir == 'R' || dir == 'B' ){
 		GetHex(" Filter code", &flt.code );
 		GetHex(" Filter mask", &flt.mask );
 		GetHex(" Filter cflags", &flt.cflags );
@@ -179,6 +180,8 @@ static void ConfigMsgObj(void)
 	switch(dir){
 	case 'R': d=MSCAN_DIR_RCV; break;
 	case 'T': d=MSCAN_DIR_XMT; break;
+	case 'M': d=MSCAN_DIR_XMTMBOX; break;
+	case 'B': d=MSCAN_DIR_RCVMBOX; break;
 	case 'D': d=MSCAN_DIR_DIS; break;
 	}
 
@@ -327,6 +330,12 @@ static void FifoStatus( u_int32 objNr )
 	case MSCAN_DIR_XMT:
 		printf("free tx entries=%ld\n", entries );
 		break;
+	case MSCAN_DIR_XMTMBOX:
+		printf("free tx mailbox entries=%ld\n", entries );
+		break;
+	case MSCAN_DIR_RCVMBOX:
+		printf("changed rx mailbox entries=%ld\n", entries );
+		break;
 	case MSCAN_DIR_DIS:
 		printf("object disabled\n");
 		break;
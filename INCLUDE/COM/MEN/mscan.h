@@ -198,11 +198,17 @@
 /*--- register bits ---*/
 
 #define MSCAN_CTL0_INITRQ	0x01	/* init mode request */
+#define MSCAN_CTL0_TIME		0x08	/* timer enable (timestamps) */
 
 #define MSCAN_CTL1_INITAK	0x01	/* init mode ack */
 #define MSCAN_CTL1_LOOPB	0x20	/* loopback mode */
 #define MSCAN_CTL1_CANE		0x80 	/* enable CAN */
 
+#define MSCAN_IDAC_2X32		0x00	/* two 32 bit filters */
+#define MSCAN_IDAC_4X16		0x10	/* four 16 bit filters */
+#define MSCAN_IDAC_8X8		0x20	/* eight 8 bit filters */
+#define MSCAN_IDAC_CLOSED	0x30	/* filter closed */
+
 #define MSCAN_RFLG_RXF		0x01	/* receive fifo not empty */
 #define MSCAN_RFLG_OVRIF	0x02	/* receive buffer overrun */
 #define MSCAN_RFLG_CSCIF	0x40	/* status change interrupt */
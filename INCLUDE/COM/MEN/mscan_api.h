@@ -83,9 +83,20 @@ typedef enum {
 typedef enum {
 	MSCAN_DIR_DIS,				/**< object disabled  */
 	MSCAN_DIR_RCV,				/**< direction=receive  */
-	MSCAN_DIR_XMT				/**< direction=transmit  */
+	MSCAN_DIR_XMT,				/**< direction=transmit  */
+	MSCAN_DIR_XMTMBOX,			/**< transmit, latest frame per ID */
+	MSCAN_DIR_RCVMBOX			/**< receive, latest frame per ID */
 } MSCAN_DIR;
 
+/** Transmit scheduling policy between message objects */
+typedef enum {
+	MSCAN_TXSCHED_PRIO,			/**< lowest object number first (default) */
+	MSCAN_TXSCHED_RR,			/**< round robin, one frame per object */
+	MSCAN_TXSCHED_WRR,			/**< weighted round robin */
+	MSCAN_TXSCHED_EDF,			/**< earliest deadline first */
+	MSCAN_TXSCHED_CANID			/**< lowest CAN ID first, preemptive */
+} MSCAN_TXSCHED;
+
 /** CAN message and filter flags */
 typedef enum {
 	MSCAN_EXTENDED=0x1,			/**< interpret ID as extended ID */
@@ -101,6 +112,92 @@ typedef struct{
 	u_int8 	data[8];			/**< data */
 } MSCAN_FRAME;
 
+/** max. number of objects that can be waited for with mscan_wait */
+#define MSCAN_WAIT_MAXOBJ		32
+
+/** CAN frame with receive timestamp (see mscan_ts_freq) */
+typedef struct{
+	MSCAN_FRAME frm;			/**< received frame */
+	u_int32 tsHigh;				/**< timestamp bits 63..32 */
+	u_int32 tsLow;				/**< timestamp bits 31..0 */
+} MSCAN_FRAME_TS;
+
+/** Rx mailbox entry (see mscan_read_mbox) */
+typedef struct{
+	MSCAN_FRAME frm;			/**< latest frame of CAN ID */
+	u_int32 updates;			/**< frames received for ID (wraps) */
+	u_int32 tsHigh;				/**< timestamp bits 63..32 */
+	u_int32 tsLow;				/**< timestamp bits 31..0 */
+} MSCAN_MBOX_ENTRY;
+
+/** 
+ * Header of rx ring shared with the application (see mscan_rxring_map).
+ * Frames and timestamps are arrays behind the header, located by
+ * \em frmOff / \em tsOff. Use the MSCAN_RXRING_xxx macros to access them.
+ */
+typedef struct{
+	volatile u_int32 nxtIn;		/**< counter of next frame to fill (driver) */
+	volatile u_int32 nxtOut;	/**< counter of next frame to read (appl.) */
+	u_int32 ringMask;			/**< ring size - 1 */
+	u_int32 totEntries;			/**< max. number of frames in ring */
+	u_int32 frmOff;				/**< offset of frame array */
+	u_int32 tsOff;				/**< offset of timestamp array */
+} MSCAN_RXRING;
+
+/** number of frames ready in shared rx ring \a r */
+#define MSCAN_RXRING_FILLED(r)	((r)->nxtIn - (r)->nxtOut)
+
+/** frame with counter \a n in shared rx ring \a r */
+#define MSCAN_RXRING_FRM(r,n) \
+	((const MSCAN_FRAME *)((const u_int8 *)(r) + (r)->frmOff) + \
+	 ((n) & (r)->ringMask))
+
+/** receive timestamp (high, low) of frame \a n in shared rx ring \a r */
+#define MSCAN_RXRING_TS(r,n) \
+	((const u_int32 *)((const u_int8 *)(r) + (r)->tsOff) + \
+	 2 * ((n) & (r)->ringMask))
+
+/** 
+ * Header of tx ring shared with the application (see mscan_txring_map).
+ * Frames are an array behind the header, located by \em frmOff.
+ */
+typedef struct{
+	volatile u_int32 nxtIn;		/**< counter of next frame to fill (appl.) */
+	volatile u_int32 nxtOut;	/**< counter of next frame to send (driver) */
+	u_int32 ringMask;			/**< ring size - 1 */
+	u_int32 totEntries;			/**< max. number of frames in ring */
+	u_int32 frmOff;				/**< offset of frame array */
+} MSCAN_TXRING;
+
+/** number of free entries in shared tx ring \a r */
+#define MSCAN_TXRING_FREE(r)	((r)->totEntries - ((r)->nxtIn - (r)->nxtOut))
+
+/** entry with counter \a n in shared tx ring \a r */
+#define MSCAN_TXRING_FRM(r,n) \
+	((MSCAN_FRAME *)((u_int8 *)(r) + (r)->frmOff) + ((n) & (r)->ringMask))
+
+/** Tx confirmation (see mscan_read_txconf) */
+typedef struct{
+	u_int32 seq;				/**< frame number within object's FIFO */
+	u_int32 id;					/**< CAN ID of frame */
+	u_int8  flags;				/**< flags of frame */
+	u_int8  _pad[3];
+	u_int32 tsHigh;				/**< completion time bits 63..32 */
+	u_int32 tsLow;				/**< completion time bits 31..0 */
+} MSCAN_TXCONF;
+
+/** Cyclic transmit table entry (see mscan_set_cyclic) */
+typedef struct{
+	u_int32 objNr;				/**< tx object the frame is queued into */
+	u_int32 period;				/**< period in ms, 0=entry unused */
+	u_int32 phase;				/**< delay of first transmission in ms */
+	u_int32 count;				/**< number of transmissions, 0=endless */
+	MSCAN_FRAME frm;			/**< frame to send */
+} MSCAN_CYCLIC;
+
+/** number of entries in cyclic transmit table */
+#define MSCAN_CYCLIC_MAX	64
+
 /** CAN node status */
 typedef enum {
     /** node is error active (normal operation)  */
@@ -120,6 +217,9 @@ typedef enum {
 /** macro to clear an ID of the individual ID filter */
 #define MSCAN_ACCFIELD_CLR(field,id)  (field[(id)>>3] &= ~(0x80>>((id)&7)))
 
+/** max. number of frames returned by mscan_tx_abort */
+#define MSCAN_TXABORT_MAX	4
+
 /** MSCAN filter definition */
 typedef struct{
 
@@ -181,6 +281,57 @@ typedef struct{
 
 } MSCAN_FILTER;
 
+/** max. number of filter rules per Rx object (see mscan_set_filter_rules) */
+#define MSCAN_RULES_MAX		64
+
+/** filter rule types */
+typedef enum {
+	MSCAN_RULE_RANGE=0,			/**< IDs code..mask (first..last) */
+	MSCAN_RULE_MASK=1			/**< IDs matching code/mask */
+} MSCAN_RULE_TYPE;
+
+/** filter rule of an Rx object (see mscan_set_filter_rules) */
+typedef struct {
+	u_int8  type;				/**< MSCAN_RULE_RANGE or MSCAN_RULE_MASK */
+	u_int8  flags;				/**< MSCAN_EXTENDED for extended IDs */
+	u_int32 code;				/**< RANGE: first ID, MASK: acceptance code */
+	u_int32 mask;				/**< RANGE: last ID, MASK: acceptance mask
+								   (bit set: ignore ID bit) */
+} MSCAN_FILTER_RULE;
+
+/** hardware acceptance filter modes (see mscan_set_filter_ranges) */
+typedef enum {
+	MSCAN_HWFILT_2X32=0,		/**< two 32 bit filters */
+	MSCAN_HWFILT_4X16=1,		/**< four 16 bit filters */
+	MSCAN_HWFILT_8X8=2,			/**< eight 8 bit filters */
+	MSCAN_HWFILT_CLOSED=3,		/**< all frames rejected (reported only) */
+	MSCAN_HWFILT_AUTO=4			/**< let driver select best mode */
+} MSCAN_HWFILT_MODE;
+
+/** max. number of ID ranges for mscan_set_filter_ranges */
+#define MSCAN_FILTER_MAXRANGES	32
+
+/** range of wanted CAN identifiers */
+typedef struct {
+	u_int32 first;				/**< first ID of range */
+	u_int32 last;				/**< last ID of range (inclusive) */
+	u_int8  flags;				/**< MSCAN_EXTENDED for extended IDs */
+} MSCAN_IDRANGE;
+
+/** result of hardware filter setup (see mscan_filter_info) 
+ *
+ * Accepted counts are the number of identifiers that pass the hardware
+ * filter. Counts are 0 if the filter was set by mscan_set_filter().
+ */
+typedef struct {
+	u_int32 mode;				/**< MSCAN_HWFILT_xxx mode in use */
+	u_int32 stdWanted;			/**< standard IDs in ranges */
+	u_int32 stdAccepted;		/**< standard IDs accepted by hardware */
+	u_int32 extWanted;			/**< extended IDs in ranges */
+	u_int32 extAccepted;		/**< extended IDs accepted by hardware */
+	u_int32 precision;			/**< wanted IDs per 1000 accepted IDs */
+} MSCAN_HWFILT_INFO;
+
 
 /*--------------------------------------+
 |   DEFINES                             |
@@ -196,6 +347,9 @@ typedef struct{
 #define	MSCAN_ERR_BADPARAMETER	(ERR_LL_ILL_PARAM) /**< bad parameter */
 #define	MSCAN_ERR_NOTINIT		(ERR_DEV+17) /**< controller not completely initialized */
 #define	MSCAN_ERR_ONLINE		(ERR_DEV+18) /**< controller not disabled */
+#define	MSCAN_ERR_CYCLIC		(ERR_DEV+19) /**< object used by cyclic table */
+#define	MSCAN_ERR_WAITBUSY		(ERR_DEV+20) /**< mscan_wait already waiting */
+#define	MSCAN_ERR_TXBUSY		(ERR_DEV+21) /**< frames in tx buffers */
 
 /*--------------------------------------+
 |   PROTOTYPES                          |
@@ -206,6 +360,27 @@ int32 __MAPILIB mscan_set_filter(
 	MDIS_PATH path,
 	const MSCAN_FILTER *filter1,
 	const MSCAN_FILTER *filter2);
+int32 __MAPILIB mscan_set_filter_ranges(
+	MDIS_PATH path,
+	MSCAN_HWFILT_MODE mode,
+	u_int32 nRanges,
+	const MSCAN_IDRANGE *ranges,
+	MSCAN_HWFILT_INFO *infoP );
+int32 __MAPILIB mscan_filter_info(
+	MDIS_PATH path,
+	MSCAN_HWFILT_INFO *infoP );
+int32 __MAPILIB mscan_filter_auto(
+	MDIS_PATH path,
+	int32 mode );
+int32 __MAPILIB mscan_set_filter_rules(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 nRules,
+	const MSCAN_FILTER_RULE *rules );
+int32 __MAPILIB mscan_set_shared(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 shared );
 int32 __MAPILIB mscan_config_msg(
 	MDIS_PATH path,
 	u_int32 nr,	
@@ -233,11 +408,99 @@ int32 __MAPILIB mscan_read_nmsg(
 	u_int32 nr,
 	int32 nFrames,
 	MSCAN_FRAME *msg );
+int32 __MAPILIB mscan_read_nmsg_timeout(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	u_int32 maxFrames,
+	int32 timeout,
+	MSCAN_FRAME *msg );
+int32 __MAPILIB mscan_read_msg_ts(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	MSCAN_FRAME_TS *msg );
+int32 __MAPILIB mscan_read_nmsg_ts(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	u_int32 maxFrames,
+	int32 timeout,
+	MSCAN_FRAME_TS *msg );
+int32 __MAPILIB mscan_ts_freq(
+	MDIS_PATH path,
+	u_int32 *freqP );
+int32 __MAPILIB mscan_read_mbox(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 maxEntries,
+	int32 timeout,
+	MSCAN_MBOX_ENTRY *ent );
+int32 __MAPILIB mscan_rxring_map(
+	MDIS_PATH path,
+	u_int32 nr,
+	MSCAN_RXRING **ringP );
+int32 __MAPILIB mscan_rxring_wait(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	int32 timeout );
+int32 __MAPILIB mscan_txring_map(
+	MDIS_PATH path,
+	u_int32 nr,
+	MSCAN_TXRING **ringP );
+int32 __MAPILIB mscan_txring_doorbell(
+	MDIS_PATH path,
+	u_int32 nr );
+int32 __MAPILIB mscan_wait(
+	MDIS_PATH path,
+	u_int32 *rxMaskP,
+	u_int32 *txMaskP,
+	u_int32 txSpace,
+	int32 timeout );
+int32 __MAPILIB mscan_set_tx_sched(
+	MDIS_PATH path,
+	MSCAN_TXSCHED policy );
+int32 __MAPILIB mscan_set_tx_param(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 weight,
+	u_int32 deadline );
+int32 __MAPILIB mscan_txconf_enable(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 entries );
+int32 __MAPILIB mscan_read_txconf(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 maxEntries,
+	MSCAN_TXCONF *conf,
+	u_int32 *lostP );
+int32 __MAPILIB mscan_tx_abort(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	MSCAN_FRAME *frames );
 int32 __MAPILIB mscan_write_msg(
 	MDIS_PATH path,
 	u_int32 nr,
 	int32 timeout,
 	const MSCAN_FRAME *msg);
+int32 __MAPILIB mscan_write_msg_exp(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	u_int32 lifetime,
+	const MSCAN_FRAME *msg );
+int32 __MAPILIB mscan_tx_expired(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 *expiredP );
+int32 __MAPILIB mscan_set_cyclic(
+	MDIS_PATH path,
+	u_int32 first,
+	u_int32 nEntries,
+	const MSCAN_CYCLIC *ent );
 int32 __MAPILIB mscan_write_nmsg(
 	MDIS_PATH path,
 	u_int32 nr,
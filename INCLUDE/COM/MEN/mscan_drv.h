@@ -70,6 +70,123 @@ typedef struct {
 	MSCAN_FRAME msg;			/* out for mscan_read_msg */
 } MSCAN_READWRITEMSG_PB;
 
+/** variable length PB for mscan_read_nmsg(_timeout)/mscan_write_nmsg */
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;				/* read only */
+	u_int32 minFrames;			/* read: frames to wait for */
+	u_int32 nFrames;			/* in: size of frm[], out: frames copied */
+	MSCAN_FRAME frm[1];			/* nFrames entries */
+} MSCAN_READWRITENMSG_PB;
+
+/** size of MSCAN_READWRITENMSG_PB holding \a n frames */
+#define MSCAN_NMSG_PB_SIZE(n) \
+	(sizeof(MSCAN_READWRITENMSG_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_FRAME))
+
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;
+	MSCAN_FRAME_TS msg;			/* out */
+} MSCAN_READMSG_TS_PB;
+
+/** variable length PB for mscan_read_nmsg_ts */
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;
+	u_int32 minFrames;			/* frames to wait for */
+	u_int32 nFrames;			/* in: size of frm[], out: frames copied */
+	MSCAN_FRAME_TS frm[1];		/* nFrames entries */
+} MSCAN_READNMSG_TS_PB;
+
+/** size of MSCAN_READNMSG_TS_PB holding \a n frames */
+#define MSCAN_NMSG_TS_PB_SIZE(n) \
+	(sizeof(MSCAN_READNMSG_TS_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_FRAME_TS))
+
+/** variable length PB for mscan_read_mbox */
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;
+	u_int32 nEntries;			/* in: size of ent[], out: entries copied */
+	MSCAN_MBOX_ENTRY ent[1];	/* nEntries entries */
+} MSCAN_READMBOX_PB;
+
+/** size of MSCAN_READMBOX_PB holding \a n entries */
+#define MSCAN_READMBOX_PB_SIZE(n) \
+	(sizeof(MSCAN_READMBOX_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_MBOX_ENTRY))
+
+typedef struct {
+	u_int32 objNr;
+	MSCAN_RXRING *ring;			/* out: shared ring header */
+} MSCAN_RXRINGMAP_PB;
+
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;
+	u_int32 minFrames;			/* frames to wait for */
+} MSCAN_RXRINGWAIT_PB;
+
+typedef struct {
+	u_int32 objNr;
+	MSCAN_TXRING *ring;			/* out: shared ring header */
+} MSCAN_TXRINGMAP_PB;
+
+typedef struct {
+	u_int32 rxMask;				/* in: objects to wait for frames, out:ready*/
+	u_int32 txMask;				/* in: objects to wait for space, out:ready */
+	u_int32 txSpace;			/* free tx entries to wait for */
+	int32 timeout;
+} MSCAN_WAIT_PB;
+
+/** variable length PB for mscan_set_filter_ranges */
+typedef struct {
+	u_int32 mode;				/* MSCAN_HWFILT_xxx */
+	u_int32 nRanges;			/* number of entries in range[] */
+	MSCAN_IDRANGE range[1];		/* nRanges entries */
+} MSCAN_SETFILTERRANGES_PB;
+
+/** size of MSCAN_SETFILTERRANGES_PB holding \a n entries */
+#define MSCAN_SETFILTERRANGES_PB_SIZE(n) \
+	(sizeof(MSCAN_SETFILTERRANGES_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_IDRANGE))
+
+/** variable length PB for mscan_set_filter_rules */
+typedef struct {
+	u_int32 objNr;
+	u_int32 nRules;				/* number of entries in rule[] */
+	MSCAN_FILTER_RULE rule[1];	/* nRules entries */
+} MSCAN_SETRULES_PB;
+
+/** size of MSCAN_SETRULES_PB holding \a n entries */
+#define MSCAN_SETRULES_PB_SIZE(n) \
+	(sizeof(MSCAN_SETRULES_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_FILTER_RULE))
+
+typedef struct {
+	u_int32 objNr;
+	u_int32 shared;				/* receive copies of frames (fan-out) */
+} MSCAN_SETSHARED_PB;
+
+typedef struct {
+	u_int32 objNr;
+	u_int32 entries;			/* size of confirmation ring, 0=disable */
+} MSCAN_TXCONFENABLE_PB;
+
+/** variable length PB for mscan_read_txconf */
+typedef struct {
+	u_int32 objNr;
+	u_int32 lost;				/* out: entries lost since last read */
+	u_int32 nEntries;			/* in: size of ent[], out: entries copied */
+	MSCAN_TXCONF ent[1];		/* nEntries entries */
+} MSCAN_READTXCONF_PB;
+
+/** size of MSCAN_READTXCONF_PB holding \a n entries */
+#define MSCAN_TXCONF_PB_SIZE(n) \
+	(sizeof(MSCAN_READTXCONF_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_TXCONF))
+
 typedef struct {
 	u_int32 errCode;			/* out */
 	u_int32 objNr;				/* out */
@@ -96,6 +213,58 @@ typedef struct {
 	u_int8 rxErrCnt;
 } MSCAN_ERRORCOUNTERS_PB;
 
+typedef struct {
+	u_int32 objNr;
+	u_int32 weight;				/* WRR: frames per turn */
+	u_int32 deadline;			/* EDF: relative deadline in ms */
+} MSCAN_TXOBJPARAM_PB;
+
+typedef struct {
+	u_int32 objNr;
+	int32 timeout;				/* wait for tx buffers, -1=don't wait */
+	u_int32 nFrames;			/* out: number of aborted frames */
+	MSCAN_FRAME frm[MSCAN_TXABORT_MAX];	/* out: aborted frames, FIFO order */
+} MSCAN_TXABORT_PB;
+
+typedef struct {
+	MSCAN_READWRITEMSG_PB m;
+	u_int32 lifetime;			/* ms, 0=unlimited */
+} MSCAN_WRITEMSG_EXP_PB;
+
+typedef struct {
+	u_int32 objNr;
+	u_int32 expired;			/* out: dropped frames since config */
+} MSCAN_TXEXPIRED_PB;
+
+/** variable length PB for mscan_set_cyclic */
+typedef struct {
+	u_int32 first;				/* first table entry to update */
+	u_int32 nEntries;			/* number of entries in ent[] */
+	MSCAN_CYCLIC ent[1];		/* nEntries entries */
+} MSCAN_SETCYCLIC_PB;
+
+/** size of MSCAN_SETCYCLIC_PB holding \a n entries */
+#define MSCAN_CYCLIC_PB_SIZE(n) \
+	(sizeof(MSCAN_SETCYCLIC_PB) + \
+	 ((n) ? (n)-1 : 0) * sizeof(MSCAN_CYCLIC))
+
+#define MSCAN_IRQSTAT_TBINS	32	/* time histogram bins */
+#define MSCAN_IRQSTAT_FBINS	32	/* frames per irq histogram bins */
+
+/** ISR statistics (MSCAN_IRQSTAT), times in internal ticks */
+typedef struct {
+	u_int32 tickFreq;			/* freq. of internal ticks, 0=unknown */
+	u_int32 count;				/* number of irqs measured */
+	u_int32 minTime;			/* min. ISR time */
+	u_int32 maxTime;			/* max. ISR time */
+	u_int32 sumHigh;			/* sum of ISR times bits 63..32 */
+	u_int32 sumLow;				/* sum of ISR times bits 31..0 */
+	/* [i]: irqs with 2^(i-1) <= time < 2^i ([0]: 0, last: larger) */
+	u_int32 timeHist[MSCAN_IRQSTAT_TBINS];	
+	/* [i]: irqs which read i Rx frames (last: i or more) */
+	u_int32 framesHist[MSCAN_IRQSTAT_FBINS];
+} MSCAN_IRQSTAT_PB;
+
 
 /*-----------------------------------------+
 |  DEFINES                                 |
@@ -106,6 +275,13 @@ typedef struct {
 #define MSCAN_ENABLE		(M_DEV_OF+0x02) /*   S: enable/disable CAN */
 #define MSCAN_LOOPBACK		(M_DEV_OF+0x03) /*   S: enable/disable loopback */
 #define MSCAN_NODESTATUS 	(M_DEV_OF+0x04) /* G  : get node status */
+#define MSCAN_RXDRAINMAX 	(M_DEV_OF+0x05) /* G,S: max. Rx frames per irq */
+#define MSCAN_RXIRQFRAMES 	(M_DEV_OF+0x06) /* G,S: max. Rx frames seen in irq*/
+#define MSCAN_TSFREQ	 	(M_DEV_OF+0x07) /* G  : Rx timestamp freq. (Hz) */
+#define MSCAN_CLEARIRQSTAT 	(M_DEV_OF+0x08) /*   S: clear ISR statistics */
+#define MSCAN_TXSCHEDPOL 	(M_DEV_OF+0x09) /* G,S: tx scheduling policy */
+#define MSCAN_TXDOORBELL 	(M_DEV_OF+0x0a) /*   S: send frames of tx ring */
+#define MSCAN_FILTERAUTO 	(M_DEV_OF+0x0b) /* G,S: auto hw filter mode */
 #define MSCAN_MAXIRQTIME 	(M_DEV_OF+0x10) /* G,S: for internal tests */
 /* ICANL2 specific status codes (BLK) */		/* S,G: S=setstat, G=getstat */
 #define MSCAN_SETFILTER 	(M_DEV_BLK_OF+0x00) /*   S: set filter */
@@ -123,6 +299,27 @@ typedef struct {
 #define MSCAN_SETBITRATE 	(M_DEV_BLK_OF+0x0c) /*   S: set bitrate */
 #define MSCAN_ERRORCOUNTERS	(M_DEV_BLK_OF+0x0d) /* G  : read error counters */
 #define MSCAN_DUMPINTERNALS	(M_DEV_BLK_OF+0x0e) /* G  : dump internals */
+#define MSCAN_READNMSG		(M_DEV_BLK_OF+0x0f) /* G  : read multiple frames */
+#define MSCAN_WRITENMSG		(M_DEV_BLK_OF+0x10) /* G  : write multiple frames */
+#define MSCAN_READMSG_TS	(M_DEV_BLK_OF+0x11) /* G  : read frame+timestamp */
+#define MSCAN_READNMSG_TS	(M_DEV_BLK_OF+0x12) /* G  : read frames+timestamps*/
+#define MSCAN_TXCONFENABLE	(M_DEV_BLK_OF+0x13) /*   S: setup tx confirmation */
+#define MSCAN_READTXCONF	(M_DEV_BLK_OF+0x14) /* G  : read tx confirmations */
+#define MSCAN_IRQSTAT		(M_DEV_BLK_OF+0x15) /* G  : get ISR statistics */
+#define MSCAN_TXOBJPARAM	(M_DEV_BLK_OF+0x16) /*   S: tx sched. obj params */
+#define MSCAN_TXABORT		(M_DEV_BLK_OF+0x17) /* G  : abort pending tx */
+#define MSCAN_WRITEMSG_EXP	(M_DEV_BLK_OF+0x18) /*   S: write frame+lifetime */
+#define MSCAN_TXEXPIRED		(M_DEV_BLK_OF+0x19) /* G  : get expired tx frames */
+#define MSCAN_SETCYCLIC		(M_DEV_BLK_OF+0x1a) /*   S: update cyclic tx table */
+#define MSCAN_READMBOX		(M_DEV_BLK_OF+0x1b) /* G  : read changed rx mbox */
+#define MSCAN_RXRINGMAP		(M_DEV_BLK_OF+0x1c) /* G  : share rx ring w. appl.*/
+#define MSCAN_RXRINGWAIT	(M_DEV_BLK_OF+0x1d) /* G  : wait for shared ring */
+#define MSCAN_TXRINGMAP		(M_DEV_BLK_OF+0x1e) /* G  : share tx ring w. appl.*/
+#define MSCAN_WAIT			(M_DEV_BLK_OF+0x1f) /* G  : wait for several objs */
+#define MSCAN_SETFILTERRANGES (M_DEV_BLK_OF+0x20) /*   S: compile hw filter */
+#define MSCAN_FILTERINFO	(M_DEV_BLK_OF+0x21) /* G  : hw filter info */
+#define MSCAN_SETRULES		(M_DEV_BLK_OF+0x22) /*   S: rx obj filter rules */
+#define MSCAN_SETSHARED		(M_DEV_BLK_OF+0x23) /*   S: shared rx object */
 
 /*-----------------------------------------+
 |  PROTOTYPES                              |
@@ -71,7 +71,8 @@
     remote frames 
   - programmable global acceptance filter (mask and code), standard or
     extended 	
-  - 10 message objects with FIFOs (provided by driver)
+  - 10 message objects with FIFOs (provided by driver), configurable
+    up to 256 via descriptor key \c NUM_OBJS
   - programmable acceptance filter for each RX object
 
   The package consists of an MDIS5 low-level driver and a C library
@@ -109,15 +110,16 @@
 
   \subsection FIFOs Message Objects and FIFOs 
 
-  The driver provides up to 10 message object to the user, numbered
-  from 0 to 9.  Each object has it's own FIFO. 
+  The driver provides 10 message objects to the user by default, numbered
+  from 0 to 9.  The number of objects can be changed with the descriptor
+  key \c NUM_OBJS (2..256).  Each object has it's own FIFO. 
 
   Message object 0 is the error FIFO and is maintained by the driver
   to buffer error events on the CAN bus. It can be configured for
   receive only.  
 
-  Message objects 1..9 can be configured for receive or transmit,
-  but not for both.
+  Message objects 1..NUM_OBJS-1 (1..9 by default) can be configured 
+  for receive or transmit, but not for both.
 
   Each message object's FIFO buffers a configurable number of entries
   (frames).  API function #mscan_config_msg configures any message
@@ -194,6 +196,11 @@
   available. The timeout parameter specifies how long to wait until a
   frame arrives. #mscan_read_nmsg is always non-blocking.
 
+  #mscan_read_nmsg_timeout reads a batch of frames with a single call.
+  It waits until a minimum number of frames is present in the FIFO
+  (or timeout) and then returns as many frames as are available,
+  up to the size of the user's buffer.
+
   The number of entries in the receive FIFO can be determined at any
   time by calling #mscan_queue_status. The FIFO can be cleared using
   #mscan_queue_clear.  
@@ -202,6 +209,77 @@
   processes. For example, one process can wait for frames on object
   1, while a second process can wait for frames on object 2.  
 
+  \subsubsection RxTs Receive Timestamps
+
+  The driver records a 64 bit timestamp for each received frame when
+  it fetches the frame from the controller. #mscan_read_msg_ts and
+  #mscan_read_nmsg_ts work like #mscan_read_msg and 
+  #mscan_read_nmsg_timeout, but return #MSCAN_FRAME_TS entries that
+  include the timestamp. #mscan_ts_freq returns the timestamp frequency.
+
+  On MGT5100/MPC5200 (ODIN), the controller's 16 bit receive timer is
+  used, which counts CAN bit times; the driver extends it to 64 bit. 
+  The frequency is therefore the bit rate and is only known after
+  the bit timing has been set. On other implementations (e.g. Z15),
+  the CPU's cycle counter (x86 TSC, PowerPC time base) is used, whose
+  frequency the driver measures at init. Only if there is no such 
+  counter, the OS tick is used, so timestamps then have OS tick 
+  resolution (typically 1..10 ms); the driver can be built with a
+  faster free running counter (MSCAN_TS_GET/MSCAN_TS_FREQ).
+
+  \subsubsection RxMbox Receive Mailbox Objects
+
+  For state-style traffic, where only the newest value of each CAN ID
+  matters, configure the receive object with #MSCAN_DIR_RCVMBOX. 
+  Instead of appending to a FIFO, the driver keeps one slot per CAN ID
+  (and frame type) that is overwritten by each received frame, so a slow
+  reader never causes FIFO overruns. \em qEntries is the number of
+  distinct IDs; frames of further IDs are discarded and reported once 
+  as #MSCAN_QOVERRUN.
+
+  #mscan_read_mbox returns only the slots that changed since they were
+  last read, each with the number of frames received for that ID so 
+  far (a difference larger than one means intermediate values were
+  overwritten) and the receive timestamp. #mscan_queue_status reports
+  the number of changed slots, #mscan_queue_clear releases all IDs.
+  The FIFO read functions are not available for mailbox objects.
+
+  \subsubsection RxRing Shared Receive Rings
+
+  For high frame rates (e.g. logging), the copy of each frame into the
+  application's buffer and the call per batch of frames can be avoided:
+  #mscan_rxring_map moves the FIFO of a receive object into a page 
+  aligned memory block that is shared with the application and returns
+  its #MSCAN_RXRING header. The driver stores received frames directly
+  into this ring and advances \em nxtIn; the application reads the
+  frames in place and advances \em nxtOut:
+
+  \code
+  MSCAN_RXRING *r;
+  
+  mscan_rxring_map( path, nr, &r );
+  while( 1 ){
+      while( MSCAN_RXRING_FILLED( r ) == 0 )
+          mscan_rxring_wait( path, nr, 1, 0 );	  // or poll
+      
+      Process( MSCAN_RXRING_FRM( r, r->nxtOut ) );
+      r->nxtOut++;		// after frame was read (memory barrier on SMP)
+  }
+  \endcode
+
+  The ring stays shared until the object is reconfigured with 
+  #mscan_config_msg, which invalidates the pointer. The FIFO read 
+  functions are not available for shared objects. #mscan_queue_clear
+  resets both counters. 
+
+  The application gets a pointer to driver memory, the ring is not
+  mapped into another address space. Shared rings therefore require 
+  driver and application to run in one address space without memory
+  protection (e.g. VxWorks) and must be enabled by building the driver
+  with \c MSCAN_SHRING defined. Otherwise, and always under Linux, 
+  #mscan_rxring_map fails with \c ERR_LL_ILL_FUNC. The same applies to
+  shared transmit rings (see \ref TxRing).
+
   \subsubsection RxUseSigs Using Signals for Receive
 
   The application can use #mscan_set_rcvsig to install a signal that
@@ -211,6 +289,33 @@
   application. Sending of signals can be cleared using
   #mscan_clr_rcvsig.
 
+  \subsubsection MultiWait Waiting for Several Objects
+
+  A single thread can serve several objects with #mscan_wait. It takes
+  a bitmask of receive objects (bit n = object n, bit 0 = error object)
+  that shall have frames or errors, and a bitmask of transmit objects 
+  that shall have at least \em txSpace free FIFO entries. It blocks 
+  until one of the conditions is met and returns the masks of the ready
+  objects, which can then be served without blocking:
+
+  \code
+  u_int32 rx, tx;
+  
+  while( 1 ){
+      rx = 0x7;				// error object, rx objects 1 and 2
+      tx = 0x8;				// tx object 3
+      if( mscan_wait( path, &rx, &tx, 10, 0 ) < 0 )
+          break;
+      if( rx & 0x1 ) ... mscan_read_error()
+      if( rx & 0x6 ) ... mscan_read_nmsg() 
+      if( tx & 0x8 ) ... mscan_write_nmsg()
+  }
+  \endcode
+
+  Only objects 0..#MSCAN_WAIT_MAXOBJ-1 can be waited for. Shared rings
+  and mailbox objects are supported; for receive mailboxes, "ready" 
+  means that slots changed.
+
   \subsubsection ConfFilt Configure Filters
 
   MSCAN driver supports three different types of filters:
@@ -287,6 +392,118 @@
   The filter can be configured through commands #mscan_set_filter
   (global filter) and #mscan_config_msg (local filter).
 
+  \b Hardware-Filter-Modes
+
+  #mscan_set_filter always uses two 32 bit hardware filters. When the
+  application is interested in more than two groups of IDs, a single
+  mask must cover all of them and the controller interrupts the CPU for
+  many frames that are discarded by the local filters.
+
+  Instead, the application can pass a list of wanted ID ranges to
+  #mscan_set_filter_ranges. The driver computes the acceptance codes
+  and masks for one of the controller's filter modes:
+
+  - #MSCAN_HWFILT_2X32: two filters, each for standard or extended IDs,
+    compares all ID bits
+  - #MSCAN_HWFILT_4X16: four filters, each for standard or extended IDs,
+    compares all bits of standard IDs, but only bits 28..15 of
+    extended IDs
+  - #MSCAN_HWFILT_8X8: eight filters, compares bits 10..3 of standard
+    IDs or bits 28..21 of extended IDs. Each filter accepts both
+    standard and extended frames.
+
+  With #MSCAN_HWFILT_AUTO, the driver selects the mode that accepts
+  the fewest unwanted IDs. A falsely accepted standard ID is
+  considered as bad as 2^18 falsely accepted extended IDs (the ratio
+  of the ID spaces). The RTR bit is not compared.
+
+  The resulting acceptance is reported by #mscan_filter_info: the
+  number of wanted IDs, the number of IDs that pass the hardware, and
+  the ratio of both. The local filters are still required to
+  distribute the frames to the message objects.
+
+  \code
+      MSCAN_IDRANGE rng[3] = {
+          { 0x100, 0x10f, 0 },            // standard IDs 0x100..0x10f
+          { 0x200, 0x200, 0 },            // standard ID 0x200
+          { 0x18feef00, 0x18feefff, MSCAN_EXTENDED }
+      };
+      MSCAN_HWFILT_INFO info;
+
+      mscan_set_filter_ranges( path, MSCAN_HWFILT_AUTO, 3, rng, &info );
+  \endcode
+
+  \b Automatic-Hardware-Filter
+
+  Keeping the global filter consistent with the local filters of the
+  Rx objects is tedious. After #mscan_filter_auto has been called, the
+  driver derives the global filter from the local filters of all Rx
+  objects itself, and recomputes it whenever an object is configured
+  with #mscan_config_msg. Bus activity is only interrupted if the
+  filter registers actually change.
+
+  To change the filter registers of a running controller, the driver 
+  holds transmission until the frames in the controller's transmit
+  buffers have been sent, then briefly disables bus activity. If the 
+  buffers are not sent within 100ms (e.g. no other node acknowledges),
+  the new filter is only written by the next #mscan_enable; 
+  #mscan_set_filter_ranges and #mscan_filter_auto then fail with
+  #MSCAN_ERR_TXBUSY, the automatic update by #mscan_config_msg does not.
+
+  Standard IDs are taken exactly, including the acceptance fields.
+  The masks of extended object filters are used as they are, so the
+  wanted count of #mscan_filter_info may be too high for overlapping
+  extended filters.
+
+  Calling #mscan_set_filter or #mscan_set_filter_ranges switches back
+  to manual filter setup.
+
+  \b Filter-Rules
+
+  A single code/mask filter cannot express a list of unrelated IDs or
+  an ID range that is not aligned to a power of two. With
+  #mscan_set_filter_rules, an Rx object accepts all frames that match
+  any of up to #MSCAN_RULES_MAX rules, each of which is either an ID
+  range (MSCAN_RULE_RANGE) or an acceptance code/mask 
+  (MSCAN_RULE_MASK):
+
+  \code
+  static const MSCAN_FILTER_RULE rules[] = {
+	{ MSCAN_RULE_RANGE, 0, 0x100, 0x17f },
+	{ MSCAN_RULE_RANGE, 0, 0x230, 0x230 },
+	{ MSCAN_RULE_MASK, MSCAN_EXTENDED, 0x18fe0000, 0x0000ffff }
+  };
+
+  mscan_config_msg( path, 3, MSCAN_DIR_RCV, 20, &filter );
+  mscan_set_filter_rules( path, 3, 3, rules );
+  \endcode
+
+  The driver compiles the rules into its Rx dispatch table, so the
+  number of rules does not affect the interrupt latency. The rules 
+  replace the local filter of the object until the object is 
+  configured again with #mscan_config_msg.
+
+  \b Shared-Objects
+
+  A received frame is normally put into the lowest numbered Rx object
+  whose filter matches. If an object is made shared with 
+  #mscan_set_shared, it receives a copy of each frame matching its 
+  filter, even if the frame is also put into another object. Frames
+  are still put into the lowest numbered matching object that is not
+  shared. So a bus monitor can get all frames through a catch-all
+  shared object, without taking them away from the application's 
+  other objects:
+
+  \code
+  filter.code = 0; filter.mask = 0xffffffff;		// accept all
+  mscan_config_msg( path, 9, MSCAN_DIR_RCV, 200, &filter );
+  mscan_set_shared( path, 9, TRUE );
+  \endcode
+
+  The driver precomputes the target objects of each standard ID, so
+  each frame is read from the controller once and copied to all 
+  targets.
+
 
   \subsection Transm Transmitting Frames
 
@@ -312,6 +529,11 @@
   Frames in transmit object #4 are not sent before all frames of transmit
   object #3 have been sent.
 
+  Note: The hardware priority register distinguishes only 16 objects.
+  Transmit objects 15 and above share the lowest priority, so frames
+  already scheduled from these objects may be sent in any order
+  against eachother (but still in FIFO order within each object).
+
   When the frame has been transmitted over the bus, the driver fetches
   the next frame from the lowest numbered available transmit FIFO and
   puts it into the CAN controller.
@@ -324,9 +546,50 @@
   The number of \em free entries in the transmit FIFO can be
   determined at any time by calling #mscan_queue_status.
 
+  Frames that are useless when sent late (e.g. cyclic setpoints) can be
+  queued with #mscan_write_msg_exp, which attaches a lifetime to the
+  frame. When the frame is at the head of the FIFO after its lifetime
+  has expired (e.g. during bus overload or after a bus off), the driver
+  drops it instead of sending it. #mscan_tx_expired returns the number
+  of dropped frames per object. A frame that is already in the 
+  controller's transmit buffer is never dropped.
+
   The FIFO can be cleared using #mscan_queue_clear. The \em txabort
   parameter can be used to abort any pending transmission that has not
-  been competed yet. (The txabort feature is not yet implemented!).
+  been competed yet. The frames in the controller's transmit buffers
+  are aborted only if they did not win arbitration yet, so some of them
+  may still be sent. #mscan_tx_abort does the same, but waits until
+  the controller has finished the abort and returns the frames that were
+  not sent (at most #MSCAN_TXABORT_MAX), e.g. to resend them later.
+
+  \subsubsection TxSched Transmit Scheduling between Objects
+
+  The priority by object number described above is the default policy
+  (#MSCAN_TXSCHED_PRIO). A busy low numbered object can starve all
+  higher numbered objects. #mscan_set_tx_sched selects another policy
+  for the device:
+
+  - #MSCAN_TXSCHED_RR: objects with pending frames are served in turn,
+    one frame each.
+  - #MSCAN_TXSCHED_WRR: like round robin, but each object sends up to
+    its \em weight frames per turn, set by #mscan_set_tx_param.
+  - #MSCAN_TXSCHED_EDF: the object whose next frame has the earliest
+    deadline is served first. The deadline of a frame is the time it
+    was written plus the object's \em deadline, set by 
+    #mscan_set_tx_param. With all deadlines 0, frames are sent in the
+    order they were written, across all objects.
+  - #MSCAN_TXSCHED_CANID: the object whose next frame has the lowest
+    CAN ID (like bus arbitration) is served first. When all CAN 
+    controller transmit buffers are busy with higher IDs, the driver
+    aborts the lowest priority one and sends it again later. 
+
+  In the RR, WRR and EDF modes, frames that have been moved into the
+  CAN controller are sent in the order they were scheduled, regardless
+  of the object number. In CANID mode, they are sent ordered by the 
+  upper 8 bits of the CAN ID. Within each object, frames are always 
+  sent in FIFO order, so a frame with a low CAN ID can still wait for
+  the frames in front of it in the same object. Put urgent frames into
+  an own object.
 
   \subsubsection TxUseSigs Using Signals for Transmit
 
@@ -337,6 +600,84 @@
   transmitted frame. Signals can be disabled by using #mscan_clr_xmtsig.
 
 
+  \subsubsection TxConf Transmit Confirmation
+
+  An application can request a confirmation for each frame of a transmit
+  object that has been sent on the bus by calling #mscan_txconf_enable.
+  The driver then puts an #MSCAN_TXCONF entry into a per object ring 
+  each time a transmission completes. The entry contains the frame's ID,
+  its sequence number and the completion time, using the same time base 
+  as the receive timestamps (see \ref RxTs).
+
+  The sequence number is the index of the frame in the stream of frames
+  written to the object, counting from 0 after #mscan_config_msg or
+  #mscan_queue_clear. This allows to measure the transmit latency of
+  each frame.
+
+  Confirmations are fetched with #mscan_read_txconf. If the application
+  does not read them fast enough, confirmations are lost and counted.
+  #mscan_config_msg disables the confirmation for that object.
+
+  \subsubsection TxCyclic Cyclic Transmission
+
+  Frames that are sent periodically can be handed over to the driver's
+  cyclic transmit table with #mscan_set_cyclic, so no call per frame is
+  needed. Each of the #MSCAN_CYCLIC_MAX entries specifies the frame, the
+  transmit object, the period, the delay of the first transmission 
+  (phase) and optionally the number of transmissions. 
+
+  A driver timer (one OS tick or finer, depending on the OS) queues due
+  frames into the FIFO of the entry's transmit object, from where they
+  are scheduled like any other frame. A frame that could not be sent
+  within its period is dropped (see #mscan_write_msg_exp). Periods 
+  shorter than the timer period are rejected with 
+  #MSCAN_ERR_BADPARAMETER, e.g. periods below 10ms on a 100Hz OS tick.
+
+  Changed entries are taken over all at once, so frame data can be 
+  updated consistently while the table is running. Unchanged entries
+  keep their timing. Objects used by the table cannot be written,
+  cleared or configured by the application (#MSCAN_ERR_CYCLIC).
+
+  \subsubsection TxMbox Transmit Mailbox Objects
+
+  For signals where only the latest value matters, configure the transmit
+  object with #MSCAN_DIR_XMTMBOX. Such an object keeps at most one frame
+  per CAN ID (and frame type) in its FIFO: when a frame is written while
+  the previous frame of the same ID is still waiting, the waiting frame 
+  is replaced in place and keeps its position in the FIFO. Frames that 
+  already went to a transmit buffer are not affected.
+
+  Writers never block on a mailbox object. The FIFO depth \em qEntries 
+  is the number of distinct IDs the object can handle; writing a frame
+  with a further ID fails with #MSCAN_ERR_QFULL. #mscan_queue_clear
+  releases all IDs.
+
+  \subsubsection TxRing Shared Transmit Rings
+
+  Like receive FIFOs (see \ref RxRing), the FIFO of a transmit object 
+  can be shared with the application using #mscan_txring_map. The 
+  application writes frames directly into the ring, advances \em nxtIn
+  and then calls #mscan_txring_doorbell once, which hands all new frames 
+  to the driver and starts transmission. A burst of frames thus costs a
+  single call:
+
+  \code
+  MSCAN_TXRING *r;
+  
+  mscan_txring_map( path, nr, &r );
+  for( i=0; i<n && MSCAN_TXRING_FREE( r ); i++ ){
+      *MSCAN_TXRING_FRM( r, r->nxtIn ) = frm[i];
+      r->nxtIn++;		// after frame was written (memory barrier on SMP)
+  }
+  mscan_txring_doorbell( path, nr );
+  \endcode
+
+  The driver advances \em nxtOut when a frame went to a transmit buffer.
+  Use the object's transmit signal (#mscan_set_xmtsig) to get notified
+  about free entries. The FIFO write functions and the cyclic table 
+  are not available for shared objects. Shared transmit rings have the
+  same address space restriction and build switch as receive rings.
+
   \subsubsection SendRtr Sending RTR Frames
 
   The application can force a remote CAN bus station to send a
@@ -413,7 +754,9 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <MEN/men_typs.h>
 #include <MEN/mdis_err.h>
 #include <MEN/mdis_api.h>
@@ -439,6 +782,29 @@
        rv = M_getstat( path, code, (int32 *)&blk );\
    }
 
+/** max. frames for which nmsg parameter blocks are kept on stack */
+#define NMSG_STACK_FRAMES	32
+
+/*--------------------------------+
+|  TYPEDEFS                       |
++--------------------------------*/
+/** 
+ * variable length parameter block, either on stack or allocated
+ * (room for NMSG_STACK_FRAMES frames, used for all variable PBs)
+ */
+typedef union {
+	MSCAN_READWRITENMSG_PB pb;
+	u_int8 mem[MSCAN_NMSG_PB_SIZE(NMSG_STACK_FRAMES)];
+} NMSG_STACK_PB;
+
+/*--------------------------------+
+|  PROTOTYPES                     |
++--------------------------------*/
+static void *NMsgPbGet( NMSG_STACK_PB *stk, u_int32 size );
+static void NMsgPbFree( NMSG_STACK_PB *stk, void *pb );
+static int32 ReadNMsg( MDIS_PATH path, u_int32 nr, u_int32 minFrames, 
+					   u_int32 maxFrames, int32 timeout, MSCAN_FRAME *msg );
+
 
 /**********************************************************************/
 /** Open path to CAN device
@@ -521,11 +887,208 @@ int32 __MAPILIB mscan_set_filter(
 	return rv;
 }
 
+/**********************************************************************/
+/** Set global acceptance filter from a list of wanted ID ranges
+ *
+ * The driver computes the hardware acceptance filters in the specified
+ * mode, so that all IDs in the ranges pass, and as few other IDs as
+ * possible. This replaces any filter set by mscan_set_filter().
+ *
+ * See \ref ConfFilt for more information.
+ *
+ * \remark Bus activity is temporarily disabled during this call.
+ *  
+ * \param 	path 	MDIS path number for device
+ * \param	mode	hardware filter mode, MSCAN_HWFILT_AUTO to select
+ *					the mode with the fewest unwanted IDs
+ * \param	nRanges	number of entries in \a ranges 
+ *					(max. #MSCAN_FILTER_MAXRANGES). If 0, all
+ *					frames are rejected.
+ * \param	ranges	wanted ID ranges
+ * \param	infoP	if not NULL, receives the resulting acceptance
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADPARAMETER:	 if mode or ranges invalid
+ *			- \c MSCAN_ERR_TXBUSY:		 tx buffers not sent, filter
+ *										 written by next mscan_enable()
+ *
+ * \sa mscan_filter_info
+ */
+int32 __MAPILIB mscan_set_filter_ranges(
+	MDIS_PATH path,
+	MSCAN_HWFILT_MODE mode,
+	u_int32 nRanges,
+	const MSCAN_IDRANGE *ranges,
+	MSCAN_HWFILT_INFO *infoP )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_SETFILTERRANGES_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	blk.size = MSCAN_SETFILTERRANGES_PB_SIZE( nRanges );
+
+	if( (pb = (MSCAN_SETFILTERRANGES_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->mode	= mode;
+	pb->nRanges	= nRanges;
+	memcpy( pb->range, ranges, nRanges * sizeof(*ranges) );
+
+	blk.data = (void *)pb;
+
+	rv = M_setstat( path, MSCAN_SETFILTERRANGES, (INT32_OR_64)&blk );
+
+	NMsgPbFree( &stk, pb );
+
+	if( (rv == 0) && infoP )
+		rv = mscan_filter_info( path, infoP );
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Get acceptance of current global filter
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	infoP	receives mode and accepted IDs. If the filter was
+ *					set by mscan_set_filter(), all counts are 0.
+ *
+ * \return 	0 on success, or -1 on error.
+ *
+ * \sa mscan_set_filter_ranges, \ref ConfFilt
+ */
+int32 __MAPILIB mscan_filter_info(
+	MDIS_PATH path,
+	MSCAN_HWFILT_INFO *infoP )
+{
+	int32 rv;
+
+	DO_BLK_GETSTAT( *infoP, MSCAN_FILTERINFO );
+	return rv;
+}
+
+/**********************************************************************/
+/** Derive global acceptance filter from Rx objects automatically
+ *
+ * The driver computes the global filter from the local filters of all
+ * Rx objects, immediately and whenever an Rx object is configured
+ * or removed. See \ref ConfFilt for more information.
+ *
+ * \remark Bus activity is temporarily disabled when the filter changes.
+ *  
+ * \param 	path 	MDIS path number for device
+ * \param	mode	hardware filter mode (MSCAN_HWFILT_xxx) used for the
+ *					derived filter, or -1 to stop automatic setup
+ *					(the current filter stays active)
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADPARAMETER:	 if mode invalid
+ *			- \c MSCAN_ERR_TXBUSY:		 tx buffers not sent, filter
+ *										 written by next mscan_enable()
+ *
+ * \sa mscan_filter_info, mscan_set_filter_ranges
+ */
+int32 __MAPILIB mscan_filter_auto(
+	MDIS_PATH path,
+	int32 mode )
+{
+	return M_setstat( path, MSCAN_FILTERAUTO, mode );
+}
+
+/**********************************************************************/
+/** Set filter rules of an Rx object
+ *
+ * The object accepts frames matching any of the rules, instead of the
+ * filter passed to mscan_config_msg(). RTR frames are accepted like
+ * data frames. See \ref ConfFilt for more information.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (must be an Rx object, 
+ *					configured with MSCAN_DIR_RCV)
+ * \param	nRules	number of entries in \a rules 
+ *					(max. #MSCAN_RULES_MAX). If 0, the filter passed 
+ *					to mscan_config_msg() is used again.
+ * \param	rules	filter rules
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:		 if object number invalid
+ *			- \c MSCAN_ERR_BADDIR:			 if object is not an Rx object
+ *			- \c MSCAN_ERR_BADPARAMETER:	 if rules invalid
+ *
+ * \sa mscan_config_msg
+ */
+int32 __MAPILIB mscan_set_filter_rules(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 nRules,
+	const MSCAN_FILTER_RULE *rules )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_SETRULES_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	blk.size = MSCAN_SETRULES_PB_SIZE( nRules );
+
+	if( (pb = (MSCAN_SETRULES_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->objNr	= nr;
+	pb->nRules	= nRules;
+	memcpy( pb->rule, rules, nRules * sizeof(*rules) );
+
+	blk.data = (void *)pb;
+
+	rv = M_setstat( path, MSCAN_SETRULES, (INT32_OR_64)&blk );
+
+	NMsgPbFree( &stk, pb );
+	return rv;
+}
+
+/**********************************************************************/
+/** Make an Rx object shared
+ *
+ * A shared object receives all frames matching its filter, even if 
+ * they are also put into another object. See \ref ConfFilt for more 
+ * information. The flag is cleared by mscan_config_msg().
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (must be an Rx object, 
+ *					configured with MSCAN_DIR_RCV)
+ * \param	shared	TRUE to receive copies of frames, FALSE to receive
+ *					only frames not taken by lower numbered objects
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:		 if object number invalid
+ *			- \c MSCAN_ERR_BADDIR:			 if object is not an Rx object
+ *
+ * \sa mscan_config_msg, mscan_set_filter_rules
+ */
+int32 __MAPILIB mscan_set_shared(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 shared )
+{
+	MSCAN_SETSHARED_PB pb;
+	int32 rv;
+
+	pb.objNr	= nr;
+	pb.shared	= shared;
+
+	DO_BLK_SETSTAT( pb, MSCAN_SETSHARED );
+	return rv;
+}
+
 
 /**********************************************************************/
 /** Configure message object
  *
- * Used to configure one of the 10 message objects provided by the MSCAN 
+ * Used to configure one of the message objects provided by the MSCAN 
  * driver. The error object (object #0) is also configured by this function.
  *
  * By default, all message objects are disabled (i.e direction is set
@@ -551,9 +1114,13 @@ int32 __MAPILIB mscan_set_filter(
  * \param 	dir		object direction 
  *					- MSCAN_DIR_RCV		receive
  *					- MSCAN_DIR_XMT		transmit
+ *					- MSCAN_DIR_XMTMBOX	transmit, latest frame per ID
+ *										(see \ref TxMbox)
+ *					- MSCAN_DIR_RCVMBOX	receive, latest frame per ID
+ *										(see \ref RxMbox)
  *					- MSCAN_DIR_DIS		disable
  * \param	qEntries FIFO depth (number of entries in rx or tx FIFO)
- *					must be >0
+ *					must be >0. For mailbox objects, number of IDs
  * \param	filter	structure that specifies the filter. Used only for Rx
  *					objects. Can be NULL for Tx objects and object 0.
  *
@@ -563,6 +1130,7 @@ int32 __MAPILIB mscan_set_filter(
  *											qEntries invalid
  *			- \c MSCAN_ERR_BADMSGNUM:		illegal message object number
  *			- \c MSCAN_ERR_BADDIR:	   		bad direction
+ *			- \c MSCAN_ERR_CYCLIC:	   		object used by cyclic table
  */
 int32 __MAPILIB mscan_config_msg(
 	MDIS_PATH path,
@@ -623,158 +1191,707 @@ int32 __MAPILIB mscan_set_bitrate(
 	pb.bitrate	= bitrate;
 	pb.spl		= spl;
 
-	DO_BLK_SETSTAT( pb, MSCAN_SETBITRATE );
-	return rv;
+	DO_BLK_SETSTAT( pb, MSCAN_SETBITRATE );
+	return rv;
+}
+
+/**********************************************************************/
+/** Setup bustiming directly
+ *
+ * This function allows to setup the bus timing parameters directly,
+ * in case the predefined CIA DS 102 2.0 parameters provided by 
+ * mscan_set_bitrate() are not sufficient.
+ *
+ * Bus activity must be disabled when calling this function
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	brp		baud rate prescaler (1..64)
+ * \param	sjw		Syncronisation jump width (1..4)
+ * \param 	tseg1	timing segment 1 length (1..16)
+ * \param 	tseg2	timing segment 2 length (1..8)
+ * \param	spl		sample mode 
+ *					- 0=fast, take one sample per bit
+ *					- 1=slow, take three samples per bit	
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADTMDETAILS:  wrong parameter
+ *			- \c MSCAN_ERR_ONLINE:        controller was not disabled
+ *
+ * \sa mscan_set_bitrate
+ */
+int32 __MAPILIB mscan_set_bustiming(
+	MDIS_PATH path,
+	u_int8 brp, 
+	u_int8 sjw,
+	u_int8 tseg1,
+	u_int8 tseg2,
+	u_int8 spl )
+{
+	MSCAN_SETBUSTIMING_PB pb;
+	int32 rv;
+	
+	pb.brp		= brp;
+	pb.sjw		= sjw;
+	pb.tseg1	= tseg1;
+	pb.tseg2	= tseg2;
+	pb.spl		= spl;
+
+	DO_BLK_SETSTAT( pb, MSCAN_SETBUSTIMING );
+	return rv;
+}
+
+/**********************************************************************/
+/** Read single frame from CAN object's receive FIFO
+ *
+ *  Reads the next frame from the object's receive FIFO and copies the
+ *  frame identifier, length and data portion to the user's buffer 
+ *  pointed to by \a msg.
+ *
+ *  The \a timeout parameter specifies how to wait for frames:
+ *  - If \a timeout is -1 and no frame is present in the FIFO, the function
+ *    returns -1 and errno is set to MSCAN_ERR_NOMESSAGE.
+ *  - If \a timeout is >=0 and no frame is present in the FIFO, the function
+ *    waits until a frame arrives or a timeout occurs. 
+ *  - A value of 0 causes this function to wait forever. 
+ *
+ * Depending on the operating system, this wait may be aborted by a 
+ * deadly signal.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....)
+ * \param	timeout	flags if this call waits until frame available
+ *					(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param 	msg 	user buffer where received frame will be stored.
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_NOMESSAGE:	no frame in receive buffer
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object configured for transmit
+ *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
+ *
+ * \sa \ref Recv, mscan_read_nmsg, mscan_set_rcvsig
+ */
+int32 __MAPILIB mscan_read_msg(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	MSCAN_FRAME *msg )
+{
+	MSCAN_READWRITEMSG_PB pb;
+	int32 rv;
+
+	pb.objNr		= nr;
+	pb.timeout		= timeout;
+	
+	DO_BLK_GETSTAT( pb, MSCAN_READMSG );
+
+	if( rv == 0 )
+		*msg = pb.msg;
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Read multiple frames from CAN object's receive FIFO
+ *
+ *  Reads the next \a nFrames frames from the object's receive FIFO and
+ *  copies the frames to the user's buffer pointed to by \a msg.
+ *
+ *  This is essentially the same as mscan_read_msg(), but shows better
+ *  performance when transferring large amounts of frames between 
+ *  the driver and application, since less context switches are 
+ *  required. 
+ *
+ *  However, if user intends to read only a single frame, mscan_read_msg()
+ *  is faster.
+ *
+ *  Unlike mscan_read_msg(), this function is always non blocking. If
+ *  not enough frames in fifo, it copies the number of entries
+ *  currently present in the fifo.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....)
+ * \param 	nFrames	maximum number of frames to read
+ * \param 	msg 	user buffer where received frames will be stored.
+ *
+ * \return 	number of successfully copied CAN frames, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object configured for transmit
+ *
+ * \remarks Performs a single driver call, so it's safe to call it 
+ *          from several threads sharing one path.
+ * \sa \ref Recv, mscan_read_msg, mscan_read_nmsg_timeout, mscan_set_rcvsig 
+ */
+int32 __MAPILIB mscan_read_nmsg(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 nFrames,
+	MSCAN_FRAME *msg )
+{
+	if( nFrames < 0 )
+		nFrames = 0;
+
+	return ReadNMsg( path, nr, 0, nFrames, -1, msg );
+}
+
+/**********************************************************************/
+/** Read multiple frames from CAN object's receive FIFO, blocking
+ *
+ *  Waits until at least \a minFrames frames are present in the object's
+ *  receive FIFO, then copies up to \a maxFrames frames to the user's 
+ *  buffer pointed to by \a msg.
+ *
+ *  The \a timeout parameter specifies how to wait for frames:
+ *  - If \a timeout is -1, the function does not wait and returns
+ *    the frames currently present in the FIFO (maybe 0).
+ *  - If \a timeout is >=0, the function waits until \a minFrames frames
+ *    are present or a timeout occurs. When the timeout expires with less
+ *    than \a minFrames (but at least one) frames in the FIFO, these
+ *    frames are returned.
+ *  - A value of 0 causes this function to wait forever. 
+ *
+ *  \a minFrames is limited to \a maxFrames and to the size of the FIFO.
+ *  With \a minFrames = 0, the function never waits.
+ *
+ *  Depending on the operating system, this wait may be aborted by a 
+ *  deadly signal.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param 	minFrames	number of frames to wait for
+ * \param 	maxFrames	maximum number of frames to read
+ * \param	timeout		flags if this call waits until frames available
+ *						(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param 	msg 		user buffer where received frames will be stored
+ *						(\a maxFrames entries)
+ *
+ * \return 	number of successfully copied CAN frames, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object configured for transmit
+ *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred, no frame received
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate parameter block
+ *
+ * \sa \ref Recv, mscan_read_nmsg, mscan_read_msg
+ */
+int32 __MAPILIB mscan_read_nmsg_timeout(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	u_int32 maxFrames,
+	int32 timeout,
+	MSCAN_FRAME *msg )
+{
+	return ReadNMsg( path, nr, minFrames, maxFrames, timeout, msg );
+}
+
+/**********************************************************************/
+/** Read single frame with receive timestamp from CAN object's FIFO
+ *
+ *  Same as mscan_read_msg(), but returns also the time when the frame
+ *  was received.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....)
+ * \param	timeout	flags if this call waits until frame available
+ *					(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param 	msg 	user buffer where received frame and timestamp will 
+ *					be stored.
+ *
+ * \return 	0 on success, or -1 on error. See mscan_read_msg()
+ *
+ * \sa \ref RxTs, mscan_read_nmsg_ts, mscan_ts_freq
+ */
+int32 __MAPILIB mscan_read_msg_ts(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	MSCAN_FRAME_TS *msg )
+{
+	MSCAN_READMSG_TS_PB pb;
+	int32 rv;
+
+	pb.objNr		= nr;
+	pb.timeout		= timeout;
+	
+	DO_BLK_GETSTAT( pb, MSCAN_READMSG_TS );
+
+	if( rv == 0 )
+		*msg = pb.msg;
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Read multiple frames with receive timestamps from CAN object's FIFO
+ *
+ *  Same as mscan_read_nmsg_timeout(), but returns also the time when
+ *  each frame was received.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param 	minFrames	number of frames to wait for
+ * \param 	maxFrames	maximum number of frames to read
+ * \param	timeout		flags if this call waits until frames available
+ *						(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param 	msg 		user buffer where received frames and timestamps
+ *						will be stored (\a maxFrames entries)
+ *
+ * \return 	number of successfully copied CAN frames, or -1 on error.
+ *			See mscan_read_nmsg_timeout()
+ *
+ * \sa \ref RxTs, mscan_read_msg_ts, mscan_ts_freq
+ */
+int32 __MAPILIB mscan_read_nmsg_ts(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	u_int32 maxFrames,
+	int32 timeout,
+	MSCAN_FRAME_TS *msg )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_READNMSG_TS_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	blk.size = MSCAN_NMSG_TS_PB_SIZE( maxFrames );
+
+	if( (pb = (MSCAN_READNMSG_TS_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->objNr		= nr;
+	pb->timeout		= timeout;
+	pb->minFrames	= minFrames;
+	pb->nFrames		= maxFrames;
+
+	blk.data = (void *)pb;
+
+	rv = M_getstat( path, MSCAN_READNMSG_TS, (int32 *)&blk );
+
+	if( rv == 0 ){
+		memcpy( msg, pb->frm, pb->nFrames * sizeof(*msg) );
+		rv = pb->nFrames;
+	}
+
+	NMsgPbFree( &stk, pb );
+	return rv;
+}
+
+/**********************************************************************/
+/** Read changed slots of receive mailbox object
+ *
+ *  Copies up to \a maxEntries slots of a #MSCAN_DIR_RCVMBOX object that
+ *  received a frame since they were last read. Slots not returned due to
+ *  \a maxEntries stay marked for the next call.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param 	maxEntries	maximum number of entries to read
+ * \param	timeout		flags if this call waits until a slot changed
+ *						(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param 	ent 		user buffer where changed slots will be stored
+ *						(\a maxEntries entries)
+ *
+ * \return 	number of entries copied (0 if none changed and \a timeout
+ *			is -1), or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object is no rx mailbox
+ *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
+ *			- \c ERR_OSS_SIG_OCCURED	a deadly signal occurred while waiting
+ *
+ * \sa \ref RxMbox
+ */
+int32 __MAPILIB mscan_read_mbox(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 maxEntries,
+	int32 timeout,
+	MSCAN_MBOX_ENTRY *ent )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_READMBOX_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	blk.size = MSCAN_READMBOX_PB_SIZE( maxEntries );
+
+	if( (pb = (MSCAN_READMBOX_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->objNr		= nr;
+	pb->timeout		= timeout;
+	pb->nEntries	= maxEntries;
+
+	blk.data = (void *)pb;
+
+	rv = M_getstat( path, MSCAN_READMBOX, (int32 *)&blk );
+
+	if( rv == 0 ){
+		memcpy( ent, pb->ent, pb->nEntries * sizeof(*ent) );
+		rv = pb->nEntries;
+	}
+
+	NMsgPbFree( &stk, pb );
+	return rv;
+}
+
+/**********************************************************************/
+/** Share FIFO of receive object with application
+ *
+ *  Moves the object's FIFO into memory that is read in place by the
+ *  application (see \ref RxRing). Frames in the FIFO are lost. If the
+ *  FIFO is already shared, returns the same header again. Only 
+ *  available if the driver was built for a single address space OS,
+ *  see \ref RxRing.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....), configured for receive
+ * \param	ringP	pointer to variable where the ring header pointer
+ *					will be stored
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object not configured for receive
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate ring
+ *			- \c ERR_LL_ILL_FUNC:	   	driver built without shared rings
+ *
+ * \sa \ref RxRing, mscan_rxring_wait
+ */
+int32 __MAPILIB mscan_rxring_map(
+	MDIS_PATH path,
+	u_int32 nr,
+	MSCAN_RXRING **ringP )
+{
+	MSCAN_RXRINGMAP_PB pb;
+	int32 rv;
+
+	pb.objNr = nr;
+
+	DO_BLK_GETSTAT( pb, MSCAN_RXRINGMAP );
+
+	if( rv == 0 )
+		*ringP = pb.ring;
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Wait for frames in shared receive ring
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param 	minFrames	number of frames to wait for
+ * \param	timeout		-1=don't wait, 0=wait forever, >0=tout in ms
+ *
+ * \return 	0 if at least \a minFrames frames are in the ring, 
+ *			or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	ring not shared
+ *			- \c MSCAN_ERR_NOMESSAGE:	not enough frames (timeout=-1)
+ *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
+ *			- \c ERR_OSS_SIG_OCCURED	a deadly signal occurred while waiting
+ *
+ * \sa \ref RxRing, mscan_rxring_map
+ */
+int32 __MAPILIB mscan_rxring_wait(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	int32 timeout )
+{
+	MSCAN_RXRINGWAIT_PB pb;
+	int32 rv;
+
+	pb.objNr	 = nr;
+	pb.minFrames = minFrames;
+	pb.timeout	 = timeout;
+
+	DO_BLK_GETSTAT( pb, MSCAN_RXRINGWAIT );
+	return rv;
+}
+
+/**********************************************************************/
+/** Share FIFO of transmit object with application
+ *
+ *  Moves the object's FIFO into memory that is written in place by the
+ *  application (see \ref TxRing). Frames in the FIFO are lost. If the
+ *  FIFO is already shared, returns the same header again. Only 
+ *  available if the driver was built for a single address space OS,
+ *  see \ref RxRing.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....), configured for transmit
+ * \param	ringP	pointer to variable where the ring header pointer
+ *					will be stored
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object not configured for transmit
+ *										or mailbox object
+ *			- \c MSCAN_ERR_CYCLIC:	   	object used by cyclic table
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate ring
+ *			- \c ERR_LL_ILL_FUNC:	   	driver built without shared rings
+ *
+ * \sa \ref TxRing, mscan_txring_doorbell
+ */
+int32 __MAPILIB mscan_txring_map(
+	MDIS_PATH path,
+	u_int32 nr,
+	MSCAN_TXRING **ringP )
+{
+	MSCAN_TXRINGMAP_PB pb;
+	int32 rv;
+
+	pb.objNr = nr;
+
+	DO_BLK_GETSTAT( pb, MSCAN_TXRINGMAP );
+
+	if( rv == 0 )
+		*ringP = pb.ring;
+
+	return rv;
+}
+
+/**********************************************************************/
+/** Send frames put into shared transmit ring
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....)
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	ring not shared
+ *			- \c MSCAN_ERR_NOTINIT:	   	CAN not enabled
+ *			- \c MSCAN_ERR_QFULL:	   	more frames put than free entries
+ *
+ * \sa \ref TxRing, mscan_txring_map
+ */
+int32 __MAPILIB mscan_txring_doorbell(
+	MDIS_PATH path,
+	u_int32 nr )
+{
+	return M_setstat( path, MSCAN_TXDOORBELL, nr );
+}
+
+/**********************************************************************/
+/** Wait for frames or transmit space on several CAN objects
+ *
+ *  Blocks until at least one receive object in \a rxMaskP has frames 
+ *  (or the error object has errors), or at least one transmit object in
+ *  \a txMaskP has \a txSpace free FIFO entries. Only one thread per
+ *  device can wait at a time, polls (\a timeout -1) are always allowed.
+ *  The timeout applies to the whole call.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	rxMaskP		in: receive objects to wait for (bit n=object n,
+ *						bit 0=error object), out: objects with frames
+ * \param	txMaskP		in: transmit objects to wait for, out: objects
+ *						with enough space
+ * \param	txSpace		free entries to wait for (0=1, limited to FIFO
+ *						size)
+ * \param	timeout		-1=don't wait, 0=wait forever, >0=tout in ms
+ *
+ * \return 	0 on success (masks are 0 if nothing ready and \a timeout
+ *			is -1), or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADPARAMETER:	both masks 0
+ *			- \c MSCAN_ERR_WAITBUSY:	another thread is waiting and
+ *							nothing ready
+ *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
+ *			- \c ERR_OSS_SIG_OCCURED	a deadly signal occurred while waiting
+ *
+ * \sa \ref MultiWait
+ */
+int32 __MAPILIB mscan_wait(
+	MDIS_PATH path,
+	u_int32 *rxMaskP,
+	u_int32 *txMaskP,
+	u_int32 txSpace,
+	int32 timeout )
+{
+	MSCAN_WAIT_PB pb;
+	int32 rv;
+
+	pb.rxMask	= *rxMaskP;
+	pb.txMask	= *txMaskP;
+	pb.txSpace	= txSpace;
+	pb.timeout	= timeout;
+
+	DO_BLK_GETSTAT( pb, MSCAN_WAIT );
+
+	if( rv == 0 ){
+		*rxMaskP = pb.rxMask;
+		*txMaskP = pb.txMask;
+	}
+	return rv;
+}
+
+/**********************************************************************/
+/** Get frequency of receive timestamps
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	freqP	pointer to variable where frequency (Hz) will be
+ *					stored. 0 if not yet known (bit timing not set)
+ *
+ * \return 	0 on success, or -1 on error.
+ *
+ * \sa \ref RxTs, mscan_read_msg_ts, mscan_read_nmsg_ts
+ */
+int32 __MAPILIB mscan_ts_freq(
+	MDIS_PATH path,
+	u_int32 *freqP )
+{
+	int32 freq, rv;
+
+	rv = M_getstat( path, MSCAN_TSFREQ, &freq );
+
+	if( rv == 0 )
+		*freqP = (u_int32)freq;
+
+	return rv;		
 }
 
 /**********************************************************************/
-/** Setup bustiming directly
- *
- * This function allows to setup the bus timing parameters directly,
- * in case the predefined CIA DS 102 2.0 parameters provided by 
- * mscan_set_bitrate() are not sufficient.
- *
- * Bus activity must be disabled when calling this function
+/** Enable or disable transmit confirmation for CAN object
  *
  * \param 	path 	MDIS path number for device
- * \param	brp		baud rate prescaler (1..64)
- * \param	sjw		Syncronisation jump width (1..4)
- * \param 	tseg1	timing segment 1 length (1..16)
- * \param 	tseg2	timing segment 2 length (1..8)
- * \param	spl		sample mode 
- *					- 0=fast, take one sample per bit
- *					- 1=slow, take three samples per bit	
+ * \param	nr		message object number (1....), must be configured
+ *					for transmit
+ * \param	entries	number of confirmations that can be buffered 
+ *					(rounded up to power of two). 0 disables confirmation
  *
  * \return 	0 on success, or -1 on error.
  *			In case of error, \em errno set to:
- *			- \c MSCAN_ERR_BADTMDETAILS:  wrong parameter
- *			- \c MSCAN_ERR_ONLINE:        controller was not disabled
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object not configured for transmit
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate ring
  *
- * \sa mscan_set_bitrate
+ * \sa \ref TxConf, mscan_read_txconf
  */
-int32 __MAPILIB mscan_set_bustiming(
+int32 __MAPILIB mscan_txconf_enable(
 	MDIS_PATH path,
-	u_int8 brp, 
-	u_int8 sjw,
-	u_int8 tseg1,
-	u_int8 tseg2,
-	u_int8 spl )
+	u_int32 nr,
+	u_int32 entries )
 {
-	MSCAN_SETBUSTIMING_PB pb;
+	MSCAN_TXCONFENABLE_PB pb;
 	int32 rv;
-	
-	pb.brp		= brp;
-	pb.sjw		= sjw;
-	pb.tseg1	= tseg1;
-	pb.tseg2	= tseg2;
-	pb.spl		= spl;
 
-	DO_BLK_SETSTAT( pb, MSCAN_SETBUSTIMING );
+	pb.objNr	= nr;
+	pb.entries	= entries;
+
+	DO_BLK_SETSTAT( pb, MSCAN_TXCONFENABLE );
 	return rv;
 }
 
 /**********************************************************************/
-/** Read single frame from CAN object's receive FIFO
- *
- *  Reads the next frame from the object's receive FIFO and copies the
- *  frame identifier, length and data portion to the user's buffer 
- *  pointed to by \a msg.
- *
- *  The \a timeout parameter specifies how to wait for frames:
- *  - If \a timeout is -1 and no frame is present in the FIFO, the function
- *    returns -1 and errno is set to MSCAN_ERR_NOMESSAGE.
- *  - If \a timeout is >=0 and no frame is present in the FIFO, the function
- *    waits until a frame arrives or a timeout occurs. 
- *  - A value of 0 causes this function to wait forever. 
+/** Read transmit confirmations of CAN object
  *
- * Depending on the operating system, this wait may be aborted by a 
- * deadly signal.
+ *  Copies up to \a maxEntries confirmations to \a conf. Never blocks.
  *
- * \param 	path 	MDIS path number for device
- * \param	nr		message object number (1....)
- * \param	timeout	flags if this call waits until frame available
- *					(-1=don't wait, 0=wait forever, >0=tout in ms)
- * \param 	msg 	user buffer where received frame will be stored.
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param 	maxEntries	maximum number of entries to read
+ * \param 	conf 		user buffer for confirmations
+ * \param 	lostP 		if not NULL, receives number of confirmations
+ *						lost since last call
  *
- * \return 	0 on success, or -1 on error.
+ * \return 	number of copied entries, or -1 on error.
  *			In case of error, \em errno set to:
- *			- \c MSCAN_ERR_NOMESSAGE:	no frame in receive buffer
  *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
- *			- \c MSCAN_ERR_BADDIR:	   	object configured for transmit
- *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
+ *			- \c MSCAN_ERR_NOTINIT:	   	confirmation not enabled
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate parameter block
  *
- * \sa \ref Recv, mscan_read_nmsg, mscan_set_rcvsig
+ * \sa \ref TxConf, mscan_txconf_enable
  */
-int32 __MAPILIB mscan_read_msg(
+int32 __MAPILIB mscan_read_txconf(
 	MDIS_PATH path,
 	u_int32 nr,
-	int32 timeout,
-	MSCAN_FRAME *msg )
+	u_int32 maxEntries,
+	MSCAN_TXCONF *conf,
+	u_int32 *lostP )
 {
-	MSCAN_READWRITEMSG_PB pb;
+	NMSG_STACK_PB stk;
+	MSCAN_READTXCONF_PB *pb;
+	M_SG_BLOCK blk;
 	int32 rv;
 
-	pb.objNr		= nr;
-	pb.timeout		= timeout;
-	
-	DO_BLK_GETSTAT( pb, MSCAN_READMSG );
+	blk.size = MSCAN_TXCONF_PB_SIZE( maxEntries );
 
-	if( rv == 0 )
-		*msg = pb.msg;
+	if( (pb = (MSCAN_READTXCONF_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->objNr		= nr;
+	pb->nEntries	= maxEntries;
 
+	blk.data = (void *)pb;
+
+	rv = M_getstat( path, MSCAN_READTXCONF, (int32 *)&blk );
+
+	if( rv == 0 ){
+		memcpy( conf, pb->ent, pb->nEntries * sizeof(*conf) );
+		if( lostP )
+			*lostP = pb->lost;
+		rv = pb->nEntries;
+	}
+
+	NMsgPbFree( &stk, pb );
 	return rv;
 }
 
 /**********************************************************************/
-/** Read multiple frames from CAN object's receive FIFO
- *
- *  Reads the next \a nFrames frames from the object's receive FIFO and
- *  copies the frames to the user's buffer pointed to by \a msg.
- *
- *  This is essentially the same as mscan_read_msg(), but shows better
- *  performance when transferring large amounts of frames between 
- *  the driver and application, since less context switches are 
- *  required. 
+/** Abort pending transmissions of CAN object
  *
- *  However, if user intends to read only a single frame, mscan_read_msg()
- *  is faster.
+ *  Clears the object's transmit FIFO and aborts the frames in the
+ *  controller's transmit buffers like mscan_queue_clear() with 
+ *  \em txabort. Then waits until the controller has aborted or sent 
+ *  these frames and returns the frames that have \em not been sent, 
+ *  oldest first.
  *
- *  Unlike mscan_read_msg(), this function is always non blocking. If
- *  not enough frames in fifo, it copies the number of entries
- *  currently present in the fifo.
+ *  If \a timeout expires, only the frames aborted so far are 
+ *  returned. This is not an error.
  *
  * \param 	path 	MDIS path number for device
  * \param	nr		message object number (1....)
- * \param 	nFrames	maximum number of frames to read
- * \param 	msg 	user buffer where received frames will be stored.
+ * \param	timeout	-1=don't wait, 0=wait forever, >0=timeout in ms
+ * \param	frames	user buffer for #MSCAN_TXABORT_MAX frames 
+ *					(or NULL)
  *
- * \return 	number of successfully copied CAN frames, or -1 on error.
+ * \return 	number of aborted frames, or -1 on error.
  *			In case of error, \em errno set to:
  *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
- *			- \c MSCAN_ERR_BADDIR:	   	object configured for transmit
+ *			- \c MSCAN_ERR_BADDIR:	   	object not configured for transmit
  *
- * \remarks modifies current MDIS channel number
- * \sa \ref Recv, mscan_read_msg, mscan_set_rcvsig 
+ * \sa mscan_queue_clear
  */
-int32 __MAPILIB mscan_read_nmsg(
+int32 __MAPILIB mscan_tx_abort(
 	MDIS_PATH path,
 	u_int32 nr,
-	int32 nFrames,
-	MSCAN_FRAME *msg )
+	int32 timeout,
+	MSCAN_FRAME *frames )
 {
+	MSCAN_TXABORT_PB pb;
 	int32 rv;
 
-	/* set the current channel to the objHdl */
-	if( M_setstat( path, M_MK_CH_CURRENT, nr ))
-		return -1;
-
-	/* read frames */
-	rv = M_getblock( path, (u_int8 *)msg, nFrames * sizeof(*msg));
+	pb.objNr	= nr;
+	pb.timeout	= timeout;
 
-	if( rv < 0 )
-		return -1;
+	DO_BLK_GETSTAT( pb, MSCAN_TXABORT );
 
-	return rv / sizeof(*msg);	
+	if( rv == 0 ){
+		if( frames )
+			memcpy( frames, pb.frm, pb.nFrames * sizeof(*frames) );
+		rv = pb.nFrames;
+	}
+	return rv;
 }
 
 /**********************************************************************/
@@ -808,11 +1925,13 @@ int32 __MAPILIB mscan_read_nmsg(
  * \return 	0 on success, or -1 on error.
  *			In case of error, \em errno set to:
  *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
- *			- \c MSCAN_ERR_QFULL: 	   	no space in FIFO (if wait=0)
+ *			- \c MSCAN_ERR_QFULL: 	   	no space in FIFO (if wait=0),
+ *										or no free mailbox ID slot
  *			- \c MSCAN_ERR_BADDIR:	   	object configured for receive
  *			- \c ERR_OSS_TIMEOUT:	   	timeout occurred	
  *			- \c ERR_OSS_SIG_OCCURED	a deadly signal occurred while waiting
  *			- \c MSCAN_ERR_NOTINIT		CAN not online
+ *			- \c MSCAN_ERR_CYCLIC		object used by cyclic table
  *
  * \sa \ref Transm, mscan_write_nmsg, mscan_set_xmtsig
  */
@@ -833,6 +1952,134 @@ int32 __MAPILIB mscan_write_msg(
 	return rv;
 }
 
+/**********************************************************************/
+/** Put single frame with limited lifetime into CAN object's tx FIFO
+ *
+ *  Like mscan_write_msg(), but the frame is dropped by the driver if it
+ *  could not be put into the controller's transmit buffer within
+ *  \a lifetime milliseconds after this call. The resolution is one
+ *  OS tick.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	nr		message object number (1....)
+ * \param	timeout	flags if this call waits until FIFO space available
+ *					(-1=don't wait, 0=wait forever, >0=tout in ms)
+ * \param	lifetime	lifetime of frame in ms (0=unlimited)
+ * \param 	msg 	CAN message id and data to send 
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set as in mscan_write_msg() or:
+ *			- \c MSCAN_ERR_BADPARAMETER:	lifetime too large
+ *
+ * \sa \ref Transm, mscan_tx_expired
+ */
+int32 __MAPILIB mscan_write_msg_exp(
+	MDIS_PATH path,
+	u_int32 nr,
+	int32 timeout,
+	u_int32 lifetime,
+	const MSCAN_FRAME *msg )
+{
+	MSCAN_WRITEMSG_EXP_PB pb;
+	int32 rv;
+
+	pb.m.objNr		= nr;
+	pb.m.timeout	= timeout;
+	pb.m.msg		= *msg;
+	pb.lifetime		= lifetime;
+
+	DO_BLK_SETSTAT( pb, MSCAN_WRITEMSG_EXP );
+	return rv;
+}
+
+/**********************************************************************/
+/** Get number of transmit frames dropped due to expired lifetime
+ *
+ *  The counter is reset when the object is configured.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param	expiredP	receives number of dropped frames
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *
+ * \sa \ref Transm, mscan_write_msg_exp
+ */
+int32 __MAPILIB mscan_tx_expired(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 *expiredP )
+{
+	MSCAN_TXEXPIRED_PB pb;
+	int32 rv;
+
+	pb.objNr = nr;
+
+	DO_BLK_GETSTAT( pb, MSCAN_TXEXPIRED );
+
+	if( rv == 0 )
+		*expiredP = pb.expired;
+	return rv;
+}
+
+/**********************************************************************/
+/** Update entries of the cyclic transmit table
+ *
+ *  Replaces the table entries \a first ... \a first + \a nEntries - 1
+ *  by \a ent. An entry with period 0 is removed. The changed entries
+ *  become active together, their first transmission is \em phase ms 
+ *  after this call. Other entries are not affected.
+ *
+ *  When the function returns, the driver no longer uses the old 
+ *  entries, so an object that is no longer used by the table can be 
+ *  reconfigured.
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	first		first table entry to update (0..)
+ * \param	nEntries	number of entries in \a ent
+ * \param	ent			new entries
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADPARAMETER:	bad entry number or parameters,
+ *										  or period shorter than the 
+ *										  driver timer (see \ref TxCyclic)
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADDIR:	   	object not configured for transmit
+ *			- \c ERR_OSS_MEM_ALLOC:	   	can't allocate table
+ *
+ * \sa \ref TxCyclic
+ */
+int32 __MAPILIB mscan_set_cyclic(
+	MDIS_PATH path,
+	u_int32 first,
+	u_int32 nEntries,
+	const MSCAN_CYCLIC *ent )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_SETCYCLIC_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	blk.size = MSCAN_CYCLIC_PB_SIZE( nEntries );
+
+	if( (pb = (MSCAN_SETCYCLIC_PB *)NMsgPbGet( &stk, blk.size )) == NULL )
+		return -1;
+
+	pb->first		= first;
+	pb->nEntries	= nEntries;
+	memcpy( pb->ent, ent, nEntries * sizeof(*ent) );
+
+	blk.data = (void *)pb;
+
+	rv = M_setstat( path, MSCAN_SETCYCLIC, (INT32_OR_64)&blk );
+
+	NMsgPbFree( &stk, pb );
+	return rv;
+}
+
 /**********************************************************************/
 /** Put multiple frames into CAN object's transmit FIFO
  *
@@ -861,7 +2108,8 @@ int32 __MAPILIB mscan_write_msg(
  *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
  *			- \c MSCAN_ERR_BADDIR:	   	object configured for receive
  *
- * \remarks modifies current MDIS channel number
+ * \remarks Performs a single driver call, so it's safe to call it 
+ *          from several threads sharing one path.
  * \sa \ref Transm, mscan_write_msg, mscan_set_xmtsig 
  */
 int32 __MAPILIB mscan_write_nmsg(
@@ -870,19 +2118,34 @@ int32 __MAPILIB mscan_write_nmsg(
 	int32 nFrames,
 	const MSCAN_FRAME *msg)
 {
+	NMSG_STACK_PB stk;
+	MSCAN_READWRITENMSG_PB *pb;
+	M_SG_BLOCK blk;
 	int32 rv;
 
-	/* set the current channel to the objHdl */
-	if( M_setstat( path, M_MK_CH_CURRENT, nr ))
+	if( nFrames < 0 )
+		nFrames = 0;
+
+	if( (pb = NMsgPbGet( &stk, MSCAN_NMSG_PB_SIZE( nFrames ))) == NULL )
 		return -1;
 
-	/* read frames */
-	rv = M_setblock( path, (u_int8 *)msg, nFrames * sizeof(*msg));
+	pb->objNr		= nr;
+	pb->timeout		= -1;
+	pb->minFrames	= 0;
+	pb->nFrames		= nFrames;
+	memcpy( pb->frm, msg, nFrames * sizeof(*msg) );
 
-	if( rv < 0 )
-		return -1;
+	blk.size = MSCAN_NMSG_PB_SIZE( nFrames );
+	blk.data = (void *)pb;
 
-	return rv / sizeof(*msg);	
+	/* getstat: the driver returns the number of frames queued in pb */
+	rv = M_getstat( path, MSCAN_WRITENMSG, (int32 *)&blk );
+
+	if( rv == 0 )
+		rv = pb->nFrames;
+
+	NMsgPbFree( &stk, pb );
+	return rv;
 }
 
 /**********************************************************************/
@@ -1118,9 +2381,8 @@ int32 __MAPILIB mscan_queue_status(
  *
  * For transmit message FIFOs, if \a txabort is not 0, any pending
  * transmit request related to that transmit object that has not been
- * completed should also aborted.
- *
- * \remark In the current implementation, \a txabort is ignored!
+ * completed is also aborted. The function does not wait for the abort
+ * to complete, see mscan_tx_abort.
  *
  * \param 	path 	MDIS path number for device
  * \param	nr		message object number (1....)or 0 for error object
@@ -1256,6 +2518,64 @@ int32 __MAPILIB mscan_set_loopback(
 	return M_setstat( path, MSCAN_LOOPBACK, enable );
 }
 
+/**********************************************************************/
+/** Select transmit scheduling policy between message objects
+ *
+ * The policy can only be changed while no frame is waiting in the
+ * controller's tx buffers, e.g. before bus activity is enabled, or 
+ * after all transmissions have completed.
+ *
+ * \param 	path 	MDIS path number for device
+ * \param	policy	scheduling policy
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADPARAMETER:	illegal policy
+ *			- \c MSCAN_ERR_TXBUSY:		frames in tx buffers, retry 
+ *											later
+ *
+ * \sa \ref TxSched, mscan_set_tx_param
+ */
+int32 __MAPILIB mscan_set_tx_sched(
+	MDIS_PATH path,
+	MSCAN_TXSCHED policy )
+{
+	return M_setstat( path, MSCAN_TXSCHEDPOL, (int32)policy );
+}
+
+/**********************************************************************/
+/** Set transmit scheduling parameters of CAN object
+ *
+ * \param 	path 		MDIS path number for device
+ * \param	nr			message object number (1....)
+ * \param	weight		#MSCAN_TXSCHED_WRR: frames sent per turn (0=1)
+ * \param	deadline	#MSCAN_TXSCHED_EDF: deadline of frames in ms,
+ *						relative to the time the frame was written
+ *
+ * \return 	0 on success, or -1 on error.
+ *			In case of error, \em errno set to:
+ *			- \c MSCAN_ERR_BADMSGNUM:	illegal message object number
+ *			- \c MSCAN_ERR_BADPARAMETER:	deadline too large
+ *
+ * \sa \ref TxSched, mscan_set_tx_sched
+ */
+int32 __MAPILIB mscan_set_tx_param(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 weight,
+	u_int32 deadline )
+{
+	MSCAN_TXOBJPARAM_PB pb;
+	int32 rv;
+
+	pb.objNr	= nr;
+	pb.weight	= weight;
+	pb.deadline	= deadline;
+
+	DO_BLK_SETSTAT( pb, MSCAN_TXOBJPARAM );
+	return rv;
+}
+
 /**********************************************************************/
 /** Read CAN node status
  *
@@ -1345,3 +2665,73 @@ int32 __MAPILIB mscan_dump_internals(
 	return M_getstat( path, MSCAN_DUMPINTERNALS, (int32 *)&blk );
 }
 
+/**********************************************************************/
+/** Get variable length parameter block of \a size bytes
+ *
+ * Small blocks are taken from \a stk (caller's stack), larger ones are
+ * allocated.
+ *
+ * \return PB or NULL if out of memory (errno set)
+ */
+static void *NMsgPbGet( 
+	NMSG_STACK_PB *stk, 
+	u_int32 size )
+{
+	void *pb;
+
+	if( size <= sizeof(*stk) )
+		return stk;
+
+	if( (pb = malloc( size )) == NULL )
+		errno = ERR_OSS_MEM_ALLOC;
+
+	return pb;
+}
+
+/**********************************************************************/
+/** Release parameter block obtained by NMsgPbGet
+ */
+static void NMsgPbFree( NMSG_STACK_PB *stk, void *pb )
+{
+	if( pb != (void *)stk )
+		free( pb );
+}
+
+/**********************************************************************/
+/** Common function for mscan_read_nmsg and mscan_read_nmsg_timeout
+ */
+static int32 ReadNMsg(
+	MDIS_PATH path,
+	u_int32 nr,
+	u_int32 minFrames,
+	u_int32 maxFrames,
+	int32 timeout,
+	MSCAN_FRAME *msg )
+{
+	NMSG_STACK_PB stk;
+	MSCAN_READWRITENMSG_PB *pb;
+	M_SG_BLOCK blk;
+	int32 rv;
+
+	if( (pb = NMsgPbGet( &stk, MSCAN_NMSG_PB_SIZE( maxFrames ))) == NULL )
+		return -1;
+
+	pb->objNr		= nr;
+	pb->timeout		= timeout;
+	pb->minFrames	= minFrames;
+	pb->nFrames		= maxFrames;
+
+	blk.size = MSCAN_NMSG_PB_SIZE( maxFrames );
+	blk.data = (void *)pb;
+
+	rv = M_getstat( path, MSCAN_READNMSG, (int32 *)&blk );
+
+	if( rv == 0 ){
+		memcpy( msg, pb->frm, pb->nFrames * sizeof(*msg) );
+		rv = pb->nFrames;
+	}
+
+	NMsgPbFree( &stk, pb );
+	return rv;
+}
+
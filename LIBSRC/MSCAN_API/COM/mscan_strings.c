@@ -59,6 +59,10 @@ char * __MAPILIB mscan_errmsg(int32 error)
 	case MSCAN_ERR_BADPARAMETER:	str="bad parameter"; break;
 	case MSCAN_ERR_NOTINIT: str="controller not completely initialized"; break;
 	case MSCAN_ERR_ONLINE:			str="controller not disabled"; break;
+	case MSCAN_ERR_CYCLIC:			str="object used by cyclic table"; break;
+	case MSCAN_ERR_WAITBUSY:		str="another thread waits for objects"; 
+		break;
+	case MSCAN_ERR_TXBUSY:			str="frames pending in tx buffers"; break;
 	default:
 		str = NULL;
 	}